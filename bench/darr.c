@@ -0,0 +1,69 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+// 1 MB appended per round
+#define CHUNK_SIZE (1 << 20)
+#define ROUNDS 64
+// a front insertion/erasure moves the whole array
+#define RANGE_LEN (1 << 12)
+#define RANGE_COUNT 64
+
+static char chunk[CHUNK_SIZE];
+
+// appends the chunk ROUNDS times to a reserved array, so only the copies are measured
+// 0: darrput per byte, 1: darradd + memcpy, 2: darradd_uninit + memcpy, 3: darrputn
+static void
+bench_append(const char* name, int method) {
+    char* arr = NULL;
+    darrreserve(arr, (size_t) CHUNK_SIZE * ROUNDS);
+    hh_timer_t timer = timer_start();
+    for(int r = 0; r < ROUNDS; ++r) {
+        size_t idx;
+        switch(method) {
+            case 0: for(size_t i = 0; i < CHUNK_SIZE; ++i) darrput(arr, chunk[i]); break;
+            case 1: idx = darradd(arr, CHUNK_SIZE); memcpy(arr + idx, chunk, CHUNK_SIZE); break;
+            case 2: idx = darradd_uninit(arr, CHUNK_SIZE); memcpy(arr + idx, chunk, CHUNK_SIZE); break;
+            default: darrputn(arr, chunk, CHUNK_SIZE); break;
+        }
+    }
+    double duration = timer_duration(timer);
+    printf("%-8s append %8.2lfms [%zu bytes, %x]\n", name, duration, darrlen(arr), (unsigned) arr[darrlen(arr) / 3] & 0xF);
+    darrfree(arr);
+}
+
+// inserts and then erases RANGE_LEN elements at the front, RANGE_COUNT times
+// per element, every insertion and erasure moves the array once
+static void
+bench_range(const char* name, _Bool bulk) {
+    uint32_t* arr = NULL;
+    uint32_t* src = NULL;
+    for(uint32_t i = 0; i < RANGE_LEN; ++i) darrput(src, i);
+    darrputn(arr, src, RANGE_LEN);
+    darrreserve(arr, 2 * RANGE_LEN);
+    hh_timer_t timer = timer_start();
+    for(int r = 0; r < RANGE_COUNT; ++r) {
+        if(bulk) {
+            darrinsertn(arr, 0, src, RANGE_LEN);
+            darrerasen(arr, 0, RANGE_LEN);
+            continue;
+        }
+        for(size_t i = 0; i < RANGE_LEN; ++i) darrinsertn(arr, i, src + i, 1);
+        for(size_t i = 0; i < RANGE_LEN; ++i) darrerasen(arr, 0, 1);
+    }
+    double duration = timer_duration(timer);
+    printf("%-8s range  %8.2lfms [%d x %d elements, %x]\n", name, duration, RANGE_COUNT, RANGE_LEN, arr[RANGE_LEN - 1] & 0xF);
+    darrfree(arr);
+    darrfree(src);
+}
+
+int
+main(void) {
+    for(size_t i = 0; i < CHUNK_SIZE; ++i) chunk[i] = (char) (i * 31);
+    bench_append("put", 0);
+    bench_append("add", 1);
+    bench_append("uninit", 2);
+    bench_append("putn", 3);
+    bench_range("single", 0);
+    bench_range("bulk", 1);
+    return 0;
+}
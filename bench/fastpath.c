@@ -0,0 +1,86 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define PUSH_COUNT (1 << 26)
+#define ROUNDS 8
+// small enough to stay in cache, so the per-call overhead dominates
+#define ENTRY_COUNT (1 << 12)
+#define LOOKUP_COUNT (1 << 25)
+
+// pushes into a fresh array each round, so growth is part of the measurement
+static void
+bench_push(void) {
+    double total = 0.0;
+    size_t sink = 0;
+    for(int r = 0; r < ROUNDS; ++r) {
+        uint32_t* arr = NULL;
+        hh_timer_t timer = timer_start();
+        for(uint32_t i = 0; i < PUSH_COUNT / ROUNDS; ++i) darrput(arr, i);
+        total += timer_duration(timer);
+        sink += darrlen(arr) + arr[r];
+        darrfree(arr);
+    }
+    printf("%-8s push   %8.2lfms [%d pushes, %zx]\n", "darr", total, PUSH_COUNT, sink & 0xF);
+}
+
+// the same pushes, calling the out-of-line growth function every time
+static void
+bench_push_call(void) {
+    double total = 0.0;
+    size_t sink = 0;
+    for(int r = 0; r < ROUNDS; ++r) {
+        uint32_t* arr = NULL;
+        hh_timer_t timer = timer_start();
+        for(uint32_t i = 0; i < PUSH_COUNT / ROUNDS; ++i) {
+            HH__darrgrow((void**) &arr, 1, sizeof(*arr));
+            arr[hh_darrheader(arr)->len++] = i;
+        }
+        total += timer_duration(timer);
+        sink += darrlen(arr) + arr[r];
+        darrfree(arr);
+    }
+    printf("%-8s push   %8.2lfms [%d pushes, %zx]\n", "call", total, PUSH_COUNT, sink & 0xF);
+}
+
+// the default key functions, called through pointers like every lookup did before word keys were inlined
+static size_t
+bench_hash(const void* ptr, size_t sz, size_t seed) {
+    return hash_wide(ptr, sz, seed);
+}
+
+static int
+bench_comp(const void* fst, const void* snd, size_t sz) {
+    return memcmp(fst, snd, sz);
+}
+
+static void
+bench_lookup(const char* name, int layout, _Bool inlined) {
+    struct { uint64_t key; uint32_t val; }* map = NULL;
+    if(inlined) hmapconfig(map, .layout = layout);
+    else hmapconfig(map, .layout = layout, .key_f.hash = bench_hash, .key_f.comp = bench_comp);
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint64_t key = i * 0x9E3779B97F4A7C15ULL;
+        hmapinsert(map, &key, (uint32_t) i);
+    }
+    size_t hits = 0;
+    hh_timer_t timer = timer_start();
+    for(uint64_t i = 0; i < LOOKUP_COUNT; ++i) {
+        // half of all lookups miss
+        uint64_t key = (i % (2 * ENTRY_COUNT)) * 0x9E3779B97F4A7C15ULL;
+        hits += hmapget(map, &key) != SIZE_MAX;
+    }
+    printf("%-8s lookup %8.2lfms [%zu hits / %d lookups]\n", name, timer_duration(timer), hits, LOOKUP_COUNT);
+    hmapfree(map);
+}
+
+int
+main(void) {
+    bench_push();
+    bench_push_call();
+    // rows marked - hash and compare keys through .key_f
+    bench_lookup("chained", HMAP_CHAINED, 1);
+    bench_lookup("chained-", HMAP_CHAINED, 0);
+    bench_lookup("flat", HMAP_FLAT, 1);
+    bench_lookup("flat-", HMAP_FLAT, 0);
+    return 0;
+}
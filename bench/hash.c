@@ -0,0 +1,67 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define BUCKET_BITS 16
+#define KEY_COUNT (1 << 20)
+#define BYTES_TOTAL (1 << 28)
+
+typedef struct {
+    const char* name;
+    hash_f hash;
+} bench_hash_t;
+
+static const bench_hash_t HASHES[] = {
+    { "djb2", hash_djb2 },
+    { "wide", hash_wide },
+};
+
+// throughput over keys of a fixed length
+static void
+bench_throughput(bench_hash_t h, size_t len) {
+    static unsigned char buf[4096];
+    for(size_t i = 0; i < sizeof(buf); ++i) buf[i] = (unsigned char) (i * 131);
+    size_t sink = 0, iters = BYTES_TOTAL / len;
+    hh_timer_t timer = timer_start();
+    for(size_t i = 0; i < iters; ++i) sink += (h.hash)(buf + (i & 63), len, sink);
+    double ms = timer_duration(timer);
+    printf("%-5s %5zu-byte keys: %9.2lf MB/s [%zx]\n", 
+        h.name, len, (double) BYTES_TOTAL / (1024.0 * 1024.0) / (ms / 1000.0), sink & 0xF);
+}
+
+// chi-squared statistic of bucket occupancy when indexing with the low bits
+// values near the bucket count indicate a uniform distribution
+static void
+bench_distribution(bench_hash_t h, _Bool strings) {
+    static size_t counts[1 << BUCKET_BITS];
+    memset(counts, 0, sizeof(counts));
+    char key[32];
+    for(uint32_t i = 0; i < KEY_COUNT; ++i) {
+        size_t hash;
+        if(strings) {
+            int len = snprintf(key, sizeof(key), "key_%u", i);
+            hash = (h.hash)(key, (size_t) len, 0);
+        } else hash = (h.hash)(&i, sizeof(i), 0);
+        ++counts[hash & ((1 << BUCKET_BITS) - 1)];
+    }
+    double expected = (double) KEY_COUNT / (double) (1 << BUCKET_BITS), chi = 0.0;
+    size_t max = 0;
+    for(size_t i = 0; i < (1 << BUCKET_BITS); ++i) {
+        chi += ((double) counts[i] - expected) * ((double) counts[i] - expected) / expected;
+        max = MAX(max, counts[i]);
+    }
+    printf("%-5s %-7s keys: chi^2 = %12.1lf [%d buckets], max bucket = %zu [expected %.0lf]\n", 
+        h.name, strings ? "string" : "integer", chi, 1 << BUCKET_BITS, max, expected);
+}
+
+int
+main(void) {
+    for(size_t i = 0; i < ARR_LEN(HASHES); ++i) {
+        bench_distribution(HASHES[i], 0);
+        bench_distribution(HASHES[i], 1);
+    }
+    const size_t lens[] = { 4, 8, 16, 32, 64, 256, 4000 };
+    for(size_t i = 0; i < ARR_LEN(HASHES); ++i) {
+        for(size_t j = 0; j < ARR_LEN(lens); ++j) bench_throughput(HASHES[i], lens[j]);
+    }
+    return 0;
+}
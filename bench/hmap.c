@@ -0,0 +1,184 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT (1 << 20)
+#define LOOKUP_COUNT (1 << 23)
+
+// keys are scattered so that half of all lookups miss
+static inline uint32_t
+bench_key(uint32_t i) {
+    return i * 2654435761u;
+}
+
+static void
+bench_layout(const char* name, int layout) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hmapconfig(map, .layout = layout);
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint32_t key = bench_key(i);
+        hmapinsert(map, &key, i);
+    }
+    double insert = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) {
+        uint32_t key = bench_key(i % (2 * ENTRY_COUNT));
+        hits += hmapget(map, &key) != SIZE_MAX;
+    }
+    double lookup = timer_duration(timer);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups]\n", 
+        name, insert, lookup, hits, LOOKUP_COUNT);
+    hmapfree(map);
+}
+
+// same workload through hh_hmapinsert_many/hh_hmapget_many
+static void
+bench_layout_many(const char* name, int layout) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hmapconfig(map, .layout = layout);
+    uint32_t* keys = NULL;
+    uint32_t* vals = NULL;
+    darradd(keys, ENTRY_COUNT);
+    darradd(vals, ENTRY_COUNT);
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        keys[i] = bench_key(i);
+        vals[i] = i;
+    }
+    hh_timer_t timer = timer_start();
+    hmapinsert_many(map, keys, vals, ENTRY_COUNT);
+    double insert = timer_duration(timer);
+    darrfree(keys);
+    darrfree(vals);
+    keys = NULL;
+    darradd(keys, LOOKUP_COUNT);
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) keys[i] = bench_key(i % (2 * ENTRY_COUNT));
+    size_t* idx = NULL;
+    size_t hits = 0;
+    timer = timer_start();
+    hmapget_many(map, keys, LOOKUP_COUNT, idx);
+    for(size_t i = 0; i < darrlen(idx); ++i) hits += idx[i] != SIZE_MAX;
+    double lookup = timer_duration(timer);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups]\n", 
+        name, insert, lookup, hits, LOOKUP_COUNT);
+    darrfree(keys);
+    darrfree(idx);
+    hmapfree(map);
+}
+
+// removes every entry front to back, so each removal moves the last entry into the gap
+static void
+bench_remove(const char* name, int layout) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hmapconfig(map, .layout = layout);
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint32_t key = bench_key(i);
+        hmapinsert(map, &key, i);
+    }
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint32_t key = bench_key(i);
+        hmapremove(map, &key);
+    }
+    double remove = timer_duration(timer);
+    printf("%-8s remove %8.2lfms [%d entries, %zu left]\n", name, remove, ENTRY_COUNT, hmaplen(map));
+    hmapfree(map);
+}
+
+// rebuilding a map vs. loading a saved copy of it
+static void
+bench_save(void) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint32_t key = bench_key(i);
+        hmapinsert(map, &key, i);
+    }
+    double build = timer_duration(timer);
+    timer = timer_start();
+    ASSERT(hmapsave(map, PROJECT_ROOT "bench/hmap.tmp"), "hh_hmapsave failed");
+    double save = timer_duration(timer);
+    hmapfree(map);
+    map = NULL;
+    timer = timer_start();
+    ASSERT(hmapload_mapped(map, PROJECT_ROOT "bench/hmap.tmp"), "hh_hmapload_mapped failed");
+    double load = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) {
+        uint32_t key = bench_key(i % (2 * ENTRY_COUNT));
+        hits += hmapget(map, &key) != SIZE_MAX;
+    }
+    double lookup = timer_duration(timer);
+    printf("mapped   build %8.2lfms, save %8.2lfms, load %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups]\n", 
+        build, save, load, lookup, hits, LOOKUP_COUNT);
+    hmapfree(map);
+    remove(PROJECT_ROOT "bench/hmap.tmp");
+}
+
+static inline _Bool
+u32_eq(uint32_t fst, uint32_t snd) {
+    return fst == snd;
+}
+
+HMAP_DEFINE(u32map, uint32_t, uint32_t, hash_int, u32_eq)
+
+// int keys through the HH_HMAP_DEFINE functions, compared against the generic path
+// (memcmp and hh_hash_wide through function pointers)
+static void
+bench_layout_typed(const char* name, int layout) {
+    u32map_t* map = NULL;
+    u32map_config(&map, (hh_hmap_opt) { .layout = layout });
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) u32map_insert(&map, bench_key(i), i);
+    double insert = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) 
+        hits += u32map_find(map, bench_key(i % (2 * ENTRY_COUNT))) != SIZE_MAX;
+    double lookup = timer_duration(timer);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups]\n", 
+        name, insert, lookup, hits, LOOKUP_COUNT);
+    hmapfree(map);
+}
+
+// 90% of lookups miss, with and without a filter in front of the index
+static void
+bench_miss(const char* name, int layout, double filter_fpr) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hmapconfig(map, .layout = layout, .filter_fpr = filter_fpr);
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint32_t key = bench_key(i);
+        hmapinsert(map, &key, i);
+    }
+    size_t hits = 0;
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) {
+        uint32_t key = bench_key(i % (10 * ENTRY_COUNT));
+        hits += hmapget(map, &key) != SIZE_MAX;
+    }
+    double lookup = timer_duration(timer);
+    printf("%-8s miss   %8.2lfms [%zu hits / %d lookups, filter_fpr = %.3lf]\n", 
+        name, lookup, hits, LOOKUP_COUNT, filter_fpr);
+    hmapfree(map);
+}
+
+int
+main(void) {
+    bench_layout("chained", HMAP_CHAINED);
+    bench_layout("flat", HMAP_FLAT);
+    // starred rows use the batched calls
+    bench_layout_many("chained*", HMAP_CHAINED);
+    bench_layout_many("flat*", HMAP_FLAT);
+    // rows marked + use HH_HMAP_DEFINE
+    bench_layout_typed("chained+", HMAP_CHAINED);
+    bench_layout_typed("flat+", HMAP_FLAT);
+    bench_remove("chained", HMAP_CHAINED);
+    bench_remove("flat", HMAP_FLAT);
+    bench_save();
+    bench_miss("chained", HMAP_CHAINED, 0.0);
+    bench_miss("chained", HMAP_CHAINED, 0.01);
+    bench_miss("flat", HMAP_FLAT, 0.0);
+    bench_miss("flat", HMAP_FLAT, 0.01);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT (1 << 20)
+#define LOOKUP_COUNT (1 << 23)
+
+// same workload as bench/hmap.c, half of all lookups miss
+static inline uint32_t
+bench_key(uint32_t i) {
+    return i * 2654435761u;
+}
+
+static inline _Bool
+u32_eq(uint32_t fst, uint32_t snd) {
+    return fst == snd;
+}
+
+HH_HMAP_DEFINE(u32map, uint32_t, uint32_t, hash_int, u32_eq)
+
+static void
+bench_hmap(void) {
+    u32map_t* map = NULL;
+    u32map_config(&map, (hh_hmap_opt) { .layout = HMAP_FLAT });
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) u32map_insert(&map, bench_key(i), i);
+    double insert = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) 
+        hits += u32map_find(map, bench_key(i % (2 * ENTRY_COUNT))) != SIZE_MAX;
+    double lookup = timer_duration(timer);
+    hmapstats_t stats = hmapstats(map);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups, %zu bytes]\n", "hmap+", 
+        insert, lookup, hits, LOOKUP_COUNT, stats.bytes_entries + stats.bytes_index + stats.bytes_slack);
+    hmapfree(map);
+}
+
+static void
+bench_map(void) {
+    struct { uint32_t key; uint32_t val; }* map = NULL;
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) hsetput(map, bench_key(i), i);
+    double insert = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) hits += hsetget(map, bench_key(i % (2 * ENTRY_COUNT))) != SIZE_MAX;
+    double lookup = timer_duration(timer);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups, %zu bytes]\n", "hsetmap", 
+        insert, lookup, hits, LOOKUP_COUNT, hsetslots(map) * sizeof(*map));
+    hsetfree(map);
+}
+
+static void
+bench_set(void) {
+    uint32_t* set = NULL;
+    hh_timer_t timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) hsetinsert(set, bench_key(i));
+    double insert = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(uint32_t i = 0; i < LOOKUP_COUNT; ++i) hits += hsethas(set, bench_key(i % (2 * ENTRY_COUNT)));
+    double lookup = timer_duration(timer);
+    printf("%-8s insert %8.2lfms, lookup %8.2lfms [%zu hits / %d lookups, %zu bytes]\n", "hset", 
+        insert, lookup, hits, LOOKUP_COUNT, hsetslots(set) * sizeof(*set));
+    timer = timer_start();
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) hsetremove(set, bench_key(i));
+    printf("%-8s remove %8.2lfms [%d entries, %zu left]\n", "hset", timer_duration(timer), ENTRY_COUNT, hsetlen(set));
+    hsetfree(set);
+}
+
+int
+main(void) {
+    bench_hmap();
+    bench_map();
+    bench_set();
+    return 0;
+}
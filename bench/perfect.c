@@ -0,0 +1,91 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define TOKEN_COUNT (1 << 16)
+#define PASS_COUNT 64
+
+static const char* keywords[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if",
+    "inline", "int", "long", "register", "restrict", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "_Bool", "_Complex", "_Imaginary"
+};
+
+// identifiers that aren't keywords, some sharing a keyword's prefix
+static const char* others[] = { "x", "i", "len", "ptr", "iff", "intern", "format", "doubled", "count", "node" };
+
+// a token stream in which roughly one token in three is a keyword
+static char*
+bench_source(void) {
+    char* src = NULL;
+    uint32_t state = 1;
+    for(size_t i = 0; i < TOKEN_COUNT; ++i) {
+        state = state * 1664525u + 1013904223u;
+        const char* tok = ((state >> 16) % 3 == 0) ? 
+            keywords[(state >> 8) % ARR_LEN(keywords)] : others[(state >> 8) % ARR_LEN(others)];
+        for(const char* c = tok; *c; ++c) darrput(src, *c);
+        darrput(src, ' ');
+    }
+    darrput(src, '\0');
+    return src;
+}
+
+static void
+bench_hmap(const char* name, int layout, char* src) {
+    struct { const char* key; uint32_t val; }* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr, .layout = layout, 
+        .probe_f.hash = hash_span, .probe_f.comp = comp_span_cstr);
+    for(uint32_t i = 0; i < ARR_LEN(keywords); ++i) hmapinsert(map, &keywords[i], i);
+    size_t hits = 0;
+    hh_timer_t timer = timer_start();
+    for(size_t pass = 0; pass < PASS_COUNT; ++pass) {
+        span_t tokens = span(src), tok;
+        while((tok = span_next(&tokens, .delim = " ")).ptr != NULL) hits += hmapget_probe(map, &tok) != SIZE_MAX;
+    }
+    double lookup = timer_duration(timer);
+    printf("%-8s lookup %8.2lfms [%zu hits / %d tokens]\n", name, lookup, hits, TOKEN_COUNT * PASS_COUNT);
+    hmapfree(map);
+}
+
+static void
+bench_perfect(char* src) {
+    perfect_t kw = {0};
+    hh_timer_t timer = timer_start();
+    perfect_build(&kw, keywords, ARR_LEN(keywords));
+    double build = timer_duration(timer);
+    size_t hits = 0;
+    timer = timer_start();
+    for(size_t pass = 0; pass < PASS_COUNT; ++pass) {
+        span_t tokens = span(src), tok;
+        while((tok = span_next(&tokens, .delim = " ")).ptr != NULL) hits += perfect_find_span(&kw, tok) != PERFECT_NONE;
+    }
+    double lookup = timer_duration(timer);
+    printf("%-8s lookup %8.2lfms [%zu hits / %d tokens], build %.3lfms\n", 
+        "perfect", lookup, hits, TOKEN_COUNT * PASS_COUNT, build);
+    perfect_free(&kw);
+}
+
+// tokenizing alone, the baseline both lookups are measured on top of
+static void
+bench_tokens(char* src) {
+    size_t count = 0;
+    hh_timer_t timer = timer_start();
+    for(size_t pass = 0; pass < PASS_COUNT; ++pass) {
+        span_t tokens = span(src), tok;
+        while((tok = span_next(&tokens, .delim = " ")).ptr != NULL) count += span_len(tok) > 0;
+    }
+    double lookup = timer_duration(timer);
+    printf("%-8s split  %8.2lfms [%zu tokens]\n", "none", lookup, count);
+}
+
+int
+main(void) {
+    char* src = bench_source();
+    bench_tokens(src);
+    bench_hmap("chained", HMAP_CHAINED, src);
+    bench_hmap("flat", HMAP_FLAT, src);
+    bench_perfect(src);
+    darrfree(src);
+    return 0;
+}
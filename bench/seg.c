@@ -0,0 +1,58 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define PUSH_COUNT (1 << 26)
+#define ROUNDS 8
+
+// pushes into a fresh array each round, so growth is part of the measurement
+static void
+bench_push(_Bool segmented) {
+    double total = 0.0;
+    size_t sink = 0;
+    for(int r = 0; r < ROUNDS; ++r) {
+        hh_timer_t timer = timer_start();
+        if(segmented) {
+            seg_t nums = {0};
+            seg_config(&nums, .elem_size = sizeof(uint32_t));
+            for(uint32_t i = 0; i < PUSH_COUNT / ROUNDS; ++i) seg_push(&nums, &i);
+            total += timer_duration(timer);
+            sink += seg_len(&nums) + *(uint32_t*) seg_get(&nums, (size_t) r);
+            seg_free(&nums);
+        } else {
+            uint32_t* arr = NULL;
+            for(uint32_t i = 0; i < PUSH_COUNT / ROUNDS; ++i) darrput(arr, i);
+            total += timer_duration(timer);
+            sink += darrlen(arr) + arr[r];
+            darrfree(arr);
+        }
+    }
+    printf("%-8s push   %8.2lfms [%d pushes, %zx]\n", segmented ? "seg" : "darr", total, PUSH_COUNT, sink & 0xF);
+}
+
+// sums the array by index and chunk by chunk
+static void
+bench_scan(void) {
+    seg_t nums = {0};
+    seg_config(&nums, .elem_size = sizeof(uint32_t));
+    seg_putn(&nums, NULL, PUSH_COUNT);
+    uint64_t sum = 0;
+    hh_timer_t timer = timer_start();
+    for(size_t i = 0; i < PUSH_COUNT; ++i) sum += *(uint32_t*) seg_get(&nums, i);
+    printf("%-8s scan   %8.2lfms [%d elements, %llx]\n", "get", timer_duration(timer), PUSH_COUNT, (unsigned long long) sum & 0xF);
+    timer = timer_start();
+    for(size_t k = 0; k < seg_chunks(&nums); ++k) {
+        size_t len;
+        uint32_t* chunk = seg_chunk(&nums, k, &len);
+        for(size_t i = 0; i < len; ++i) sum += chunk[i];
+    }
+    printf("%-8s scan   %8.2lfms [%d elements, %llx]\n", "chunk", timer_duration(timer), PUSH_COUNT, (unsigned long long) sum & 0xF);
+    seg_free(&nums);
+}
+
+int
+main(void) {
+    bench_push(0);
+    bench_push(1);
+    bench_scan();
+    return 0;
+}
@@ -151,6 +151,39 @@ hh_log_stream_get(int level);
 #define hh_calloc_checked(num, size) HH__calloc_checked((num), (size), __FILE__, __LINE__)
 #define hh_realloc_checked(ptr, size) HH__realloc_checked((void**) &(ptr), (size), __FILE__, __LINE__)
 
+// allocator interface, used by dynamic arrays, hmaps, arenas and hh_read_entire_file
+// alloc:   returns `size` zero-initialized bytes
+// resize:  moves a block to one of `new_size` bytes, keeping the first min(old_size, new_size) bytes
+//          (bytes past old_size are unspecified)
+// release: frees a block, `size` is the size it was allocated/resized with
+// ctx:     passed to every function, for allocators with state
+// functions may return NULL on failure, the library asserts that they don't
+// EXAMPLE (everything a request allocates is freed at once):
+// hh_arena scratch = {0};
+// hh_allocator_t alloc = hh_arena_allocator(&scratch);
+// int* arr = NULL;
+// hh_darrinit(arr, &alloc);
+// hh_hmapconfig(map, .alloc = &alloc);
+// ...
+// hh_arena_reset(&scratch);
+typedef struct {
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*resize)(void* ctx, void* ptr, size_t old_size, size_t new_size);
+    void (*release)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+} hh_allocator_t;
+
+// the default allocator, built on hh_calloc_checked and hh_realloc_checked
+extern const hh_allocator_t hh_allocator_checked;
+
+// returns the global allocator, which containers use unless they are given one
+const hh_allocator_t*
+hh_allocator_get(void);
+// replaces the global allocator (NULL restores hh_allocator_checked), returns the previous one
+// containers keep the allocator they were created with, so it must outlive them
+const hh_allocator_t*
+hh_allocator_set(const hh_allocator_t* alloc);
+
 // union to easily pass around and store function pointers as data pointers
 // without breaking C99 conventions
 typedef union {
@@ -180,23 +213,56 @@ typedef union {
 // hh_darrputstrn  same as above, just copies the first n-characters of the string
 // hh_darrpop      removes the last element and returns it by value
 // hh_darradd      adds n zero-initialized elements to the array, returns the index to the 1st new element
+// hh_darradd_uninit  same as above, but the new elements are left uninitialized
+// hh_darrputn     appends n elements copied from src, returns the index to the 1st new element
+// hh_darrinsertn  inserts n elements copied from src (zeroed if src is NULL) before index i, returns i
+// hh_darrerasen   removes the n elements starting at index i, keeping the order of the rest
+//                 (src may point into the array itself)
 // hh_darrlen      returns array length
 // hh_darrcap      returns array capacity
 // hh_darrswap     swaps the elements at 2 indices
 // hh_darrswapdel  deletes the ith element by swapping it with the last element, then popping
+// hh_darrreserve  makes room for n elements in total, so the array can grow to n elements without reallocating
+// hh_darrshrink   reduces the capacity to the length of the array
+// hh_darrinit     creates an empty array (arr must be NULL) that allocates through alloc,
+//                 arrays created any other way use the global allocator (see hh_allocator_get)
+// hh_darrinit_aligned  same as above, but the elements start at a multiple of align (a power of two),
+//                      e.g. 32 or 64 for aligned SIMD loads, and stay aligned as the array grows
+// capacity grows according to HH_DARR_GROWTH_FACTOR and HH_DARR_GROWTH_LIMIT,
+// arrays above HH_DARR_MMAP_THRESHOLD bytes are mapped separately on Linux and grow without copying
 
 #define hh_darrclear(arr)           (((arr) == NULL) ? 0 : (hh_darrheader(arr)->len = 0))
-#define hh_darrfree(arr)            ((void) (((arr) == NULL) ? (void) 0 : free(hh_darrheader(arr))), (arr) = NULL)
+#define hh_darrfree(arr)            (HH__darrfree(arr), (arr) = NULL)
 #define hh_darrlast(arr)            ((arr)[hh_darrheader(arr)->len - 1])
 #define hh_darrput(arr, val)        ((void) hh_darrgrow(arr, 1), (arr)[(hh_darrheader(arr)->len)++] = (val))
 #define hh_darrputstr(arr, str)     (HH__darrputstr((void**) &(arr), (str)))
 #define hh_darrputstrn(arr, str, n) (HH__darrputstrn((void**) &(arr), (str), (n)))
 #define hh_darrpop(arr)             ((arr)[--(hh_darrheader(arr)->len)])
 #define hh_darradd(arr, n)          (HH__darraddn((void**) &(arr), (n), sizeof *(arr)))
+#define hh_darradd_uninit(arr, n)   (HH__darradd_uninit((void**) &(arr), (n), sizeof *(arr)))
+#define hh_darrputn(arr, src, n)    (HH__darrputn((void**) &(arr), (1 ? (src) : (arr)), (n), sizeof *(arr)))
+#define hh_darrinsertn(arr, i, src, n) (HH__darrinsertn((void**) &(arr), (i), (1 ? (src) : (arr)), (n), sizeof *(arr)))
+#define hh_darrerasen(arr, i, n)    (HH__darrerasen((arr), (i), (n)))
 #define hh_darrlen(arr)             (((arr) == NULL) ? 0 : hh_darrheader(arr)->len)
 #define hh_darrcap(arr)             (((arr) == NULL) ? 0 : hh_darrheader(arr)->cap)
 #define hh_darrswap(arr, i, j)      (HH__darrswap((arr), (i), (j)))
 #define hh_darrswapdel(arr, i)      (HH__darrswap((arr), (i), hh_darrlen(arr) - 1), hh_darrpop(arr))
+#define hh_darrreserve(arr, n)      (HH__darrreserve((void**) &(arr), (n), sizeof(*(arr))))
+#define hh_darrshrink(arr)          (HH__darrshrink((void**) &(arr)))
+#define hh_darrinit(arr, alloc)     (HH__darrinit((void**) &(arr), sizeof(*(arr)), (alloc), 0))
+#define hh_darrinit_aligned(arr, alloc, align) (HH__darrinit((void**) &(arr), sizeof(*(arr)), (alloc), (align)))
+
+// declares `T* name`, an empty array backed by an inline buffer with room for n elements
+// it works with every hh_darr* macro, and only moves to the heap once it grows past n elements
+// hh_darrfree must still be called, it doesn't release the inline buffer
+// the buffer lives as long as the enclosing block, so the array must not escape it
+// EXAMPLE:
+// HH_DARR_INLINE(hh_span_t, tokens, 16);
+// while(...) hh_darrput(tokens, tok);
+// hh_darrfree(tokens);
+#define HH_DARR_INLINE(T, name, n) \
+    struct { hh_darrheader_t hdr; T buf[(n) + 1]; } name##_inline; \
+    T* name = HH__darrinline(&(name##_inline.hdr), name##_inline.buf, (n) + 1, sizeof(T))
 
 // type representing a memory arena
 typedef struct HH__arena hh_arena;
@@ -204,12 +270,23 @@ typedef struct HH__arena hh_arena;
 // allocates memory within an arena
 // assumes 0-initialization
 // any size is valid, even if it is >= HH_ARENA_DEFAULT_SIZE
+// constant time, allocations continue in the segment of the previous one
+// (space left in earlier segments is only reused after hh_arena_reset)
 void*
 hh_arena_alloc(hh_arena* arena, size_t sz);
 // free the given memory arena
 // does not free(arena), it must be freed separately if it was heap-allocated
 void
 hh_arena_free(hh_arena* arena);
+// releases every allocation at once, but keeps the segments for reuse
+void
+hh_arena_reset(hh_arena* arena);
+// returns an allocator that carves blocks out of the arena
+// release is a no-op, everything is freed by hh_arena_reset or hh_arena_free
+// resizing the most recent block grows it in place when the segment has room
+// segments come from the global allocator at the time of the arena's first allocation
+hh_allocator_t
+hh_arena_allocator(hh_arena* arena);
 
 // hh_path_alloc
 // [in const] raw: a cstr representing a raw path
@@ -296,13 +373,20 @@ hh_timer_duration(hh_timer_t from);
 
 // function types for hashing and comparing hmap keys
 // in both cases, the pointers... point to the key's bytes
-typedef size_t (*hh_hash_f)(const void* ptr, size_t sz);
+// seed is the per-map seed (hh_hmap_opt.seed), it should perturb the entire hash
+typedef size_t (*hh_hash_f)(const void* ptr, size_t sz, size_t seed);
 typedef int    (*hh_comp_f)(const void* fst, const void* snd, size_t sz);
 typedef void   (*hh_copy_f)(void* dst, const void* key, size_t sz);
 
-// default hash implementation
+// default hash implementation, consumes 16-32 bytes per step (wyhash-based)
+size_t
+hh_hash_wide(const void* ptr, size_t sz, size_t seed);
+// hashes a null-terminated string, identical to hh_hash_wide(str, strlen(str), seed)
 size_t
-hh_hash_djb2(const void* ptr, size_t sz);
+hh_hash_wide_str(const char* str, size_t seed);
+// classic byte-at-a-time hash, kept for comparison
+size_t
+hh_hash_djb2(const void* ptr, size_t sz, size_t seed);
 
 // implementation for cstr keys
 // EXAMPLE (non-owning):
@@ -316,7 +400,7 @@ hh_hash_djb2(const void* ptr, size_t sz);
 // const char* temp = "hello";
 // hh_hmapinsert(map, &temp, 42);
 size_t
-hh_hash_cstr(const void* ptr, size_t sz);
+hh_hash_cstr(const void* ptr, size_t sz, size_t seed);
 int
 hh_comp_cstr(const void* fst, const void* snd, size_t sz);
 int
@@ -327,6 +411,22 @@ hh_copy_cstr(void* dst, const void* ptr, size_t sz);
 // configuration options for hmap
 // applied through hh_hmapconfig
 // see example for cstr helper functions above
+// reserve:      pre-sizes both the entry storage and the bucket table
+// bucket_count: initial number of buckets (overrides the count derived from reserve)
+//               with HH_HMAP_FLAT, the minimum number of slots
+// max_load:     entries per bucket before the table is doubled (HH_HMAP_MAX_LOAD by default)
+//               with HH_HMAP_FLAT, the fraction of occupied slots (HH_HMAP_FLAT_MAX_LOAD by default)
+// layout:       index structure used to find entries (see below)
+// seed:         passed to key_f.hash, a random seed is chosen when 0 (or HH_HMAP_SEED if defined)
+//               randomizing it defends against hash flooding with untrusted keys
+// probe_f:      hash/comp pair for looking up a different key type with hh_hmapget_probe
+//               probe_f.hash must agree with key_f.hash for equal keys,
+//               probe_f.comp receives the probe first and the stored key second
+// filter_fpr:   attaches a Bloom filter (see hh_bloom_t) with this false-positive rate,
+//               lookups of absent keys are then usually rejected without touching the index
+//               pays off with HH_HMAP_CHAINED, HH_HMAP_FLAT usually rejects them in one probe anyway
+//               0 (the default) disables it
+// alloc:        allocator for the entries, the index and its buckets (the global one when NULL)
 typedef struct {
     struct {
         hh_hash_f hash;
@@ -337,22 +437,94 @@ typedef struct {
     struct {
         void (*free)(void* ptr);
     } val_f;
+    struct {
+        hh_hash_f hash;
+        hh_comp_f comp;
+    } probe_f;
     size_t reserve;
     size_t bucket_count;
+    double max_load;
+    int layout;
+    size_t seed;
+    double filter_fpr;
+    const hh_allocator_t* alloc;
 } hh_hmap_opt;
 
+// index layouts for hh_hmap, selected through hh_hmap_opt.layout
+// both keep entries in the same dense array, so hh_hmapget indices behave identically
+// HH_HMAP_CHAINED: an array of entry indices per bucket (default)
+// HH_HMAP_FLAT:    open addressing over a flat table of control bytes,
+//                  probed 16 slots at a time (SSE2/NEON when available)
+// EXAMPLE:
+// hh_hmapconfig(map, .layout = HH_HMAP_FLAT);
+#define HH_HMAP_CHAINED 0
+#define HH_HMAP_FLAT    1
+
+// number of histogram bins in hh_hmapstats_t, the last bin collects all longer chains
+#ifndef HH_HMAP_STATS_BINS
+#define HH_HMAP_STATS_BINS 16
+#endif // not HH_HMAP_STATS_BINS
+
+// snapshot of an hmap's shape, returned by hh_hmapstats
+// buckets:   bucket count (HH_HMAP_CHAINED) or slot count (HH_HMAP_FLAT)
+// load:      entries per bucket/slot
+// hist:      HH_HMAP_CHAINED: hist[k] buckets hold k entries
+//            HH_HMAP_FLAT:    hist[k] entries are stored k groups past their first probe
+// max_chain: the longest chain (or probe distance) in the map
+// bytes_*:   memory held by live entries, by the index (including the per-entry hash/position caches)
+//            and by unused entry capacity
+// the event counters are only maintained by code compiled with HH_HMAP_STATS defined,
+// elsewhere the increments compile out (the map layout is the same either way)
+// WARNING: with HH_HMAP_STATS, lookups count comparisons in the map, so hh_hmapget writes to it
+// and a map can't be shared by concurrent readers without a lock
+typedef struct {
+    size_t len, cap, buckets;
+    double load;
+    size_t hist[HH_HMAP_STATS_BINS];
+    size_t max_chain;
+    size_t bytes_entries, bytes_index, bytes_slack;
+    size_t inserts, replaces, removes, rehashes, comparisons;
+} hh_hmapstats_t;
+
 // hh_hmaplen     returns number of entries in the map
 // hh_hmapconfig  set custom hh_hmap_opt fields
 // hh_hmapinsert  insert an entry, returns a pointer to the replaced entry if the key was already present
 // hh_hmapget     returns the index of the entry with the given key
 // hh_hmapfree    frees the hmap and sets it to NULL
 // hh_hmapremove  removes an entry and returns a pointer to it
+// hh_hmapupsert  returns a pointer to the value for key, inserting a zeroed entry if it was absent
+//                hashes the key once, so it suits counting/aggregation loops:
+//                ++*hh_hmapupsert(map, &word);
+// hh_hmaphash    returns the hash the map would compute for key
+// hh_hmapstats   returns load, chain lengths, memory use and event counters (see hh_hmapstats_t)
+// hh_hmapget_probe  like hh_hmapget, but the key has the type expected by .probe_f
+//                   EXAMPLE (span tokens against cstr keys, see span.h):
+//                   hh_hmapconfig(map, .key_f.hash = hh_hash_cstr, .key_f.comp = hh_comp_cstr,
+//                       .probe_f.hash = hh_hash_span, .probe_f.comp = hh_comp_span_cstr);
+//                   hh_span_t tok = hh_span_next(&src, .delim = " ");
+//                   size_t idx = hh_hmapget_probe(map, &tok);
+// the _hashed variants accept a hash from hh_hmaphash instead of computing it
+// (the map must already be configured, so that the seed is fixed)
+// hh_hmapget_many     looks up n keys (an array of the map's key type) and appends
+//                     each index (SIZE_MAX if absent) to the size_t darr `out`
+//                     keys are hashed and prefetched in batches, overlapping cache misses
+// hh_hmapinsert_many  inserts n keys with the n values in vals, growing the map only once
+//                     returns the number of new entries, the others replace existing ones
+//                     (replaced keys/values are released through .key_f.free/.val_f.free)
 
 #define hh_hmaplen(map)                 (((map) == NULL) ? 0 : hh_hmapheader(map)->len)
 #define hh_hmapconfig(map, ...)         ((void) HH__hmapconfig((void**) &(map), hh_hmapprop(map), (hh_hmap_opt) { __VA_ARGS__ }))
 #define hh_hmapinsert(map, key_, val_)  (HH__hmapinsert((void**) &(map), hh_hmapprop(map), (key_)) ? \
     ((map)[hh_hmapheader(map)->last].val = val_, &(map)[hh_hmaplen(map)]) : \
     ((map)[hh_hmapheader(map)->last].val = val_, NULL))
+#define hh_hmapinsert_hashed(map, key_, val_, hash) (HH__hmapinsert_hashed((void**) &(map), (key_), (hash)) ? \
+    ((map)[hh_hmapheader(map)->last].val = val_, &(map)[hh_hmaplen(map)]) : \
+    ((map)[hh_hmapheader(map)->last].val = val_, NULL))
+#define hh_hmapupsert(map, key_)        (HH__hmapupsert((void**) &(map), hh_hmapprop(map), (key_)), \
+    &(map)[hh_hmapheader(map)->last].val)
+#define hh_hmapget_many(map, keys, n, out)     (HH__hmapget_many((map), (1 ? (keys) : &(map)->key), (n), &(out)))
+#define hh_hmapinsert_many(map, keys, vals, n) (HH__hmapinsert_many((void**) &(map), hh_hmapprop(map), \
+    (1 ? (keys) : &(map)->key), (1 ? (vals) : &(map)->val), (n)))
 
 // NOTE: if .key_f.free and/or .val_f.free is configured
 // the corresponding entry fields will be freed under the following conditions
@@ -360,15 +532,173 @@ typedef struct {
 // - an entry is removed by hh_hmapremove
 // - an entry was left in the map when hh_hmapfree was called
 
-size_t
+// HH_HMAP_DEFINE(name, K, V, hash_f, eq_f) generates a map type with typed functions
+// hashing and comparison are inlined instead of going through .key_f
+//   size_t hash_f(K key, size_t seed)
+//   _Bool  eq_f(K fst, K snd)
+// name##_t                                  entry type { K key; V val; }
+// name##_config(name##_t** map, opt)        like hh_hmapconfig (.key_f.hash/.key_f.comp are set for you)
+// name##_find(const name##_t* map, K key)   like hh_hmapget
+// name##_insert(name##_t** map, K key, V val)  like hh_hmapinsert
+// name##_remove(name##_t* map, K key)       like hh_hmapremove
+// the result is an ordinary hmap, every hh_hmap* function can be used on it too
+// EXAMPLE:
+// static inline _Bool id_eq(uint32_t fst, uint32_t snd) { return fst == snd; }
+// HH_HMAP_DEFINE(idmap, uint32_t, float, hh_hash_int, id_eq)
+// idmap_t* map = NULL;
+// idmap_insert(&map, 42, 1.0f);
+// float val = map[idmap_find(map, 42)].val;
+#define HH_HMAP_DEFINE(name, K, V, hash_f, eq_f) \
+typedef struct { K key; V val; } name##_t; \
+static inline size_t \
+name##_hash(const void* key, size_t sz, size_t seed) { \
+    (void) sz; \
+    return hash_f(*((const K*) key), seed); \
+} \
+static inline int \
+name##_comp(const void* fst, const void* snd, size_t sz) { \
+    (void) sz; \
+    return !eq_f(*((const K*) fst), *((const K*) snd)); \
+} \
+static inline void \
+name##_config(name##_t** map, hh_hmap_opt opt) { \
+    opt.key_f.hash = name##_hash; \
+    opt.key_f.comp = name##_comp; \
+    HH__hmapconfig((void**) map, hh_hmapprop(*map), opt); \
+} \
+static inline size_t \
+name##_find(const name##_t* map, K key) { \
+    if(map == NULL) return SIZE_MAX; \
+    return HH__hmapfind(map, hash_f(key, hh_hmapheader(map)->opt.seed), &key, name##_comp); \
+} \
+static inline name##_t* \
+name##_insert(name##_t** map, K key, V val) { \
+    if(*map == NULL) name##_config(map, (hh_hmap_opt) {0}); \
+    size_t hash = hash_f(key, hh_hmapheader(*map)->opt.seed); \
+    size_t idx = HH__hmapfind(*map, hash, &key, name##_comp); \
+    name##_t* old = NULL; \
+    /* both write the key like hh_hmapinsert would, through .key_f.copy if it is set */ \
+    if(idx == SIZE_MAX) idx = HH__hmapappend((void**) map, &key, hash); \
+    else old = (name##_t*) HH__hmapreplace((void**) map, idx, &key); \
+    (*map)[idx].val = val; \
+    return old; \
+} \
+static inline name##_t* \
+name##_remove(name##_t* map, K key) { \
+    size_t idx = name##_find(map, key); \
+    return (idx == SIZE_MAX) ? NULL : (name##_t*) HH__hmapremoveat(map, idx); \
+}
+
+// 64-bit finalizer (murmur3 fmix64), all 64 bits of the result are usable even where size_t is 32 bits
+static inline uint64_t
+HH__mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// hash for integer keys (up to 64 bits), e.g. for HH_HMAP_DEFINE
+static inline size_t
+hh_hash_int(uint64_t key, size_t seed) {
+    return (size_t) HH__mix64(key ^ (uint64_t) seed);
+}
+
+// hh_bloom_t is a blocked Bloom filter over precomputed hashes (e.g. from hh_hmaphash)
+// all bits of a hash fall in one 64-byte block, so a query touches a single cache line
+// hh_bloom_reserve  sizes the filter for n hashes at false-positive rate fpr (0 < fpr < 1)
+//                   and empties it, it must be called before hh_bloom_add
+// hh_bloom_add      adds a hash
+// hh_bloom_has      returns falsy if the hash was definitely never added
+// hh_bloom_free     frees the filter and zeroes it
+// hashes can't be removed, reserve again and re-add the remaining ones instead
+// the rate degrades once more than n hashes (see .capacity) have been added
+// EXAMPLE:
+// hh_bloom_t seen = {0};
+// hh_bloom_reserve(&seen, 1000, 0.01);
+// hh_bloom_add(&seen, hh_hash_int(id, 0));
+// if(!hh_bloom_has(&seen, hh_hash_int(other, 0))) { ... }
+// hh_bloom_free(&seen);
+typedef struct {
+    uint64_t* blocks;
+    void* mem;
+    size_t block_count;
+    unsigned k;
+    size_t count, capacity;
+    double fpr;
+    // allocator behind mem, the global one at the time of the first hh_bloom_reserve
+    const hh_allocator_t* alloc;
+} hh_bloom_t;
+
+// 64-bit words in a block
+#define HH__BLOOM_WORDS 8
+
+void
+hh_bloom_reserve(hh_bloom_t* bloom, size_t n, double fpr);
+void
+hh_bloom_add(hh_bloom_t* bloom, size_t hash);
+void
+hh_bloom_free(hh_bloom_t* bloom);
+
+// the block is picked by the high half of the mixed hash,
+// each of the k bits inside it by the top 9 bits of a step of an LCG seeded with it
+static inline _Bool
+hh_bloom_has(const hh_bloom_t* bloom, size_t hash) {
+    uint64_t h = HH__mix64((uint64_t) hash);
+    const uint64_t* block = bloom->blocks + (((h >> 32) * bloom->block_count) >> 32) * HH__BLOOM_WORDS;
+    for(unsigned i = 0; i < bloom->k; ++i) {
+        h = h * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+        if(!(block[h >> 61] & (1ULL << ((h >> 55) & 63u)))) return 0;
+    }
+    return 1;
+}
+
+static inline size_t
 hh_hmapget(const void* map, const void* key);
+static inline size_t
+hh_hmapget_hashed(const void* map, const void* key, size_t hash);
+size_t
+hh_hmapget_probe(const void* map, const void* probe);
+size_t
+hh_hmaphash(const void* map, const void* key);
+hh_hmapstats_t
+hh_hmapstats(const void* map);
 void
 hh_hmapfree(const void* map);
 void*
 hh_hmapremove(const void* map, const void* key);
 
+// persistent hmaps
+// hh_hmapsave         writes the map to a single flat file, returns truthy on success
+//                     keys and values are written as raw bytes, except for string keys
+//                     (cstr keys compared by hh_comp_cstr and hh_span_t keys compared by hh_comp_span),
+//                     whose contents are stored in the file
+// hh_hmapload_mapped  maps a file written by hh_hmapsave into memory and points map at it,
+//                     returns truthy on success (on failure map is left untouched)
+//                     lookups are served straight from the mapping, nothing is parsed or copied
+//                     (the file is checked once, so that a corrupted one can't send lookups out of bounds)
+//                     functions can't be saved, so .key_f/.probe_f are taken from the map passed in,
+//                     they must hash like the saved map did (use hh_hmapconfig beforehand)
+//                     the loaded map always uses HH_HMAP_FLAT, changes to it are never written back:
+//                     values may be changed and entries removed in place (the mapping is private),
+//                     the first insertion copies the entries and index to the heap
+//                     release it with hh_hmapfree as usual
+// EXAMPLE:
+// hh_hmapsave(map, "words.hmap");
+// ...
+// hh_hmapconfig(map, .key_f.hash = hh_hash_cstr, .key_f.comp = hh_comp_cstr);
+// if(!hh_hmapload_mapped(map, "words.hmap")) { ... }
+#define hh_hmapload_mapped(map, path) (HH__hmapload_mapped((void**) &(map), hh_hmapprop(map), (path)))
+
+_Bool
+hh_hmapsave(const void* map, const char* path);
+
 // reads an entire file given by path
 // returns a dynamic array with file contents (free with hh_darrfree)
+// the contents are null-terminated, hh_darrlen is the size of the file
+// the array uses the global allocator
 // returns NULL on failure
 char* 
 hh_read_entire_file(const char* path);
@@ -393,6 +723,324 @@ hh_memflip(char* ptr, const char* end);
 void 
 hh_memflipn(char* ptr, size_t n);
 
+// hh_btree_t is an ordered map (B+-tree) for range queries and sorted iteration
+// keys are either signed 64-bit integers (HH_BTREE_INT) or byte strings (HH_BTREE_STR),
+// strings are ordered like memcmp (shorter first on a common prefix) and copied into the tree
+// values are val_size bytes, stored next to their keys in the leaves
+// nodes are HH_BTREE_NODE_SIZE bytes and come from an arena, so a lookup touches one node per level
+// and the leaves are chained for scans
+// nodes and key bytes freed by removal are reused, so memory follows the live keys, not every key ever inserted
+// a zero-initialized hh_btree_t is an integer set (val_size 0), call hh_btree_config before use otherwise
+// EXAMPLE (timestamps in a window):
+// hh_btree_t events = {0};
+// hh_btree_config(&events, .kind = HH_BTREE_INT, .val_size = sizeof(event_t));
+// hh_btree_put_int(&events, ev.time, &ev);
+// for(hh_btree_cursor_t c = hh_btree_lower_int(&events, from);
+//     hh_btree_valid(c) && hh_btree_key_int(c) < to; hh_btree_next(&c)) {
+//     event_t* ev = hh_btree_val(c);
+// }
+// EXAMPLE (keys with a prefix):
+// for(hh_btree_cursor_t c = hh_btree_lower_str(&names, "foo", 3); hh_btree_valid(c); hh_btree_next(&c)) {
+//     size_t len;
+//     const char* name = hh_btree_key_str(c, &len);
+//     if(len < 3 || memcmp(name, "foo", 3) != 0) break;
+// }
+typedef struct HH__btree_t hh_btree_t;
+
+// key kinds, selected through hh_btree_opt.kind
+#define HH_BTREE_INT 0
+#define HH_BTREE_STR 1
+
+// node size in bytes, the fan-out follows from it and the key/value sizes
+#ifndef HH_BTREE_NODE_SIZE
+#define HH_BTREE_NODE_SIZE 512
+#endif // not HH_BTREE_NODE_SIZE
+
+// configuration options for hh_btree_t, applied through hh_btree_config on an empty tree
+// kind:     HH_BTREE_INT or HH_BTREE_STR
+// val_size: size of the values in bytes (0 for a set)
+typedef struct {
+    int kind;
+    size_t val_size;
+} hh_btree_opt;
+
+// position of an entry, returned by the lower/upper bound functions
+// it stays valid until the tree is modified
+typedef struct {
+    const hh_btree_t* tree;
+    void* leaf;
+    size_t idx;
+} hh_btree_cursor_t;
+
+#define hh_btree_config(tree, ...) (HH__btree_config((tree), (hh_btree_opt) { __VA_ARGS__ }))
+
+// hh_btree_put_*     inserts a key with a copy of the val_size bytes at val (zeroed if val is NULL),
+//                    replacing the value of an existing key, returns truthy if the key was new
+// hh_btree_get_*     returns a pointer to the key's value, or NULL if it is absent
+//                    (the pointer is valid until the tree is modified)
+// hh_btree_remove_*  removes a key, returns truthy if it was present
+//                    a node left under half full is merged with a sibling when both fit in one node
+// hh_btree_lower_*   cursor at the first key >= key
+// hh_btree_upper_*   cursor at the first key > key
+// the _span variants take an hh_span_t (see span.h)
+_Bool
+hh_btree_put_int(hh_btree_t* tree, int64_t key, const void* val);
+void*
+hh_btree_get_int(const hh_btree_t* tree, int64_t key);
+_Bool
+hh_btree_remove_int(hh_btree_t* tree, int64_t key);
+hh_btree_cursor_t
+hh_btree_lower_int(const hh_btree_t* tree, int64_t key);
+hh_btree_cursor_t
+hh_btree_upper_int(const hh_btree_t* tree, int64_t key);
+_Bool
+hh_btree_put_str(hh_btree_t* tree, const char* str, size_t len, const void* val);
+void*
+hh_btree_get_str(const hh_btree_t* tree, const char* str, size_t len);
+_Bool
+hh_btree_remove_str(hh_btree_t* tree, const char* str, size_t len);
+hh_btree_cursor_t
+hh_btree_lower_str(const hh_btree_t* tree, const char* str, size_t len);
+hh_btree_cursor_t
+hh_btree_upper_str(const hh_btree_t* tree, const char* str, size_t len);
+#define hh_btree_put_span(tree, span, val) (hh_btree_put_str((tree), (span).ptr, hh_span_len(span), (val)))
+#define hh_btree_get_span(tree, span)      (hh_btree_get_str((tree), (span).ptr, hh_span_len(span)))
+#define hh_btree_lower_span(tree, span)    (hh_btree_lower_str((tree), (span).ptr, hh_span_len(span)))
+#define hh_btree_upper_span(tree, span)    (hh_btree_upper_str((tree), (span).ptr, hh_span_len(span)))
+
+// replaces the contents of the tree with n sorted, distinct keys given as a darr
+// (int64_t for HH_BTREE_INT, null-terminated `const char*` for HH_BTREE_STR)
+// vals holds n values of val_size bytes (zeroed if vals is NULL)
+// the leaves are packed, which is faster and more compact than n insertions
+void
+hh_btree_load(hh_btree_t* tree, const void* keys, const void* vals);
+
+// returns the number of keys
+size_t
+hh_btree_len(const hh_btree_t* tree);
+// cursor at the smallest key
+hh_btree_cursor_t
+hh_btree_first(const hh_btree_t* tree);
+// truthy while the cursor points at an entry
+#define hh_btree_valid(cursor) ((cursor).leaf != NULL)
+// advances the cursor to the next key in order
+void
+hh_btree_next(hh_btree_cursor_t* cursor);
+// key and value at the cursor
+int64_t
+hh_btree_key_int(hh_btree_cursor_t cursor);
+const char*
+hh_btree_key_str(hh_btree_cursor_t cursor, size_t* len);
+void*
+hh_btree_val(hh_btree_cursor_t cursor);
+// frees all nodes and keys, the options are kept
+void
+hh_btree_free(hh_btree_t* tree);
+
+// hh_hset is an open-addressing hash set of integer keys (1, 2, 4 or 8 bytes, signed or unsigned)
+// keys are hashed by fibonacci hashing and stored inline, without a separate index,
+// so a membership test usually touches a single cache line
+// the same functions also manage integer-keyed maps: an array of struct { K key; V val; }
+// (key first), filled with hh_hsetput instead of hh_hsetinsert
+// a set only stores its keys, halving the memory a map with a dummy value would need
+// EXAMPLE:
+// uint32_t* seen = NULL;
+// if(hh_hsetinsert(seen, id)) { /* first time */ }
+// ASSERT(hh_hsethas(seen, id));
+// hh_hsetfree(seen);
+// struct { uint64_t key; float val; }* weights = NULL;
+// hh_hsetput(weights, 42, 1.0f);
+// size_t slot = hh_hsetget(weights, 42);
+// float w = weights[slot].val;
+// hh_hsetfree(weights);
+
+// fraction of occupied slots before the table is doubled
+#ifndef HH_HSET_MAX_LOAD
+#define HH_HSET_MAX_LOAD 0.7
+#endif // not HH_HSET_MAX_LOAD
+
+// hh_hsetlen      returns the number of keys
+// hh_hsetinsert   inserts a key into a set, returns truthy if it wasn't present
+// hh_hsetput      inserts (or overwrites) a key/value pair in a map, returns truthy if the key wasn't present
+// hh_hsetget      returns the slot holding key, or SIZE_MAX
+// hh_hsethas      returns truthy if key is present
+// hh_hsetremove   removes key, returns truthy if it was present
+// hh_hsetreserve  makes room for n keys without growing
+// hh_hsetfree     frees the set and sets it to NULL
+// hh_hsetinit     creates an empty set (set must be NULL) that allocates through alloc,
+//                 sets created any other way use the global allocator (see hh_allocator_get)
+// slots move whenever the set grows or a key is removed, so slot indices are only valid until then
+// iterate over all keys with hh_hsetslots/hh_hsetvalid:
+// for(size_t i = 0; i < hh_hsetslots(set); ++i) if(hh_hsetvalid(set, i)) { ... set[i] ... }
+#define hh_hsetlen(set)            (((set) == NULL) ? 0 : hh_hsetheader(set)->len)
+#define hh_hsetinsert(set, key)    (HH__hsetinsert((void**) &(set), sizeof(*(set)), sizeof(*(set)), (uint64_t) (key)))
+#define hh_hsetput(map, key_, val_) (HH__hsetinsert((void**) &(map), sizeof((map)->key), sizeof(*(map)), (uint64_t) (key_)) ? \
+    ((map)[hh_hsetheader(map)->last].val = (val_), 1) : \
+    ((map)[hh_hsetheader(map)->last].val = (val_), 0))
+#define hh_hsetget(set, key)       (((set) == NULL) ? SIZE_MAX : HH__hsetfind((set), (uint64_t) (key)))
+#define hh_hsethas(set, key)       (hh_hsetget((set), (key)) != SIZE_MAX)
+#define hh_hsetremove(set, key)    (((set) == NULL) ? 0 : HH__hsetremove((set), (uint64_t) (key)))
+#define hh_hsetreserve(set, n)     (HH__hsetreserve((void**) &(set), sizeof(*(set)), (n)))
+#define hh_hsetinit(set, alloc)    (HH__hsetinit((void**) &(set), sizeof(*(set)), (alloc)))
+#define hh_hsetfree(set)           (HH__hsetfree(set), (set) = NULL)
+#define hh_hsetslots(set)          (((set) == NULL) ? 0 : hh_hsetheader(set)->cap + 1)
+#define hh_hsetvalid(set, i)       (HH__hsetvalid((set), (i)))
+
+// hh_intern_t maps strings to dense uint32_t IDs (0, 1, 2, ...) and back
+// every distinct string is copied once into an arena,
+// so the strings handed out by hh_intern_str stay valid until hh_intern_free
+// a zero-initialized hh_intern_t is ready for use
+// EXAMPLE:
+// hh_intern_t names = {0};
+// uint32_t id = hh_intern(&names, "foo");
+// ASSERT(hh_intern(&names, "foo") == id && strcmp(hh_intern_str(&names, id), "foo") == 0);
+// hh_intern_free(&names);
+typedef struct HH__intern_t hh_intern_t;
+
+// returned by the hh_intern_find family when a string hasn't been interned
+#define HH_INTERN_NONE UINT32_MAX
+
+// returns the ID of the string, interning it if it is new
+uint32_t
+hh_intern(hh_intern_t* in, const char* str);
+// same as hh_intern, the string is given by its first len bytes (it may contain '\0')
+uint32_t
+hh_intern_n(hh_intern_t* in, const char* str, size_t len);
+// returns the ID of the string, or HH_INTERN_NONE if it hasn't been interned
+uint32_t
+hh_intern_find(const hh_intern_t* in, const char* str);
+uint32_t
+hh_intern_find_n(const hh_intern_t* in, const char* str, size_t len);
+// returns the interned (null-terminated) string with the given ID
+const char*
+hh_intern_str(const hh_intern_t* in, uint32_t id);
+// returns the length of the interned string with the given ID
+size_t
+hh_intern_len(const hh_intern_t* in, uint32_t id);
+// returns the number of distinct strings
+#define hh_intern_count(in) ((uint32_t) hh_hmaplen((in)->index))
+// span variants (see span.h)
+#define hh_intern_span(in, span)      (hh_intern_n((in), (span).ptr, hh_span_len(span)))
+#define hh_intern_find_span(in, span) (hh_intern_find_n((in), (span).ptr, hh_span_len(span)))
+// frees all interned strings and resets the table
+void
+hh_intern_free(hh_intern_t* in);
+
+// hh_lru_t is a least-recently-used cache from byte-string keys to values
+// get, put and eviction are O(1): entries live in an hmap and are threaded
+// on an intrusive recency list that follows them when the hmap moves them around
+// keys are copied (into recycled arena blocks), values are opaque pointers owned by the caller,
+// which are handed back through .evict once the cache lets go of them
+// a zero-initialized hh_lru_t is ready for use (and never evicts)
+// EXAMPLE:
+// hh_lru_t cache = {0};
+// hh_lru_config(&cache, .max_bytes = 1 << 20, .evict = release);
+// image_t* img = hh_lru_get(&cache, path, strlen(path));
+// if(img == NULL) hh_lru_put(&cache, path, strlen(path), img = load(path), img->size);
+// hh_lru_free(&cache);
+typedef struct HH__lru_t hh_lru_t;
+
+// configuration options for hh_lru_t, applied through hh_lru_config
+// max_entries: entries kept before the least recently used ones are evicted (0 for no limit)
+// max_bytes:   total size (as passed to hh_lru_put) kept before evicting (0 for no limit)
+//              the most recently put entry is kept even if it alone exceeds the limit
+// evict:       called with every value the cache drops: on eviction, when hh_lru_put replaces it
+//              with a different pointer, and for the remaining entries in hh_lru_free
+//              not called by hh_lru_remove, which returns the value instead
+// ctx:         passed to evict
+typedef struct {
+    size_t max_entries;
+    size_t max_bytes;
+    void (*evict)(const void* key, size_t len, void* val, void* ctx);
+    void* ctx;
+} hh_lru_opt;
+
+// counters returned by hh_lru_stats
+typedef struct {
+    size_t len, bytes;
+    size_t hits, misses, evictions;
+} hh_lru_stats_t;
+
+// sets the cache's options, evicting entries that no longer fit
+#define hh_lru_config(lru, ...) (HH__lru_config((lru), (hh_lru_opt) { __VA_ARGS__ }))
+// returns the value stored for key (marking it most recently used) or NULL
+// counts a hit or a miss
+void*
+hh_lru_get(hh_lru_t* lru, const void* key, size_t len);
+// inserts or replaces the value for key, marks it most recently used
+// and evicts least recently used entries until the cache is within its limits
+// size is the value's cost against .max_bytes
+void
+hh_lru_put(hh_lru_t* lru, const void* key, size_t len, void* val, size_t size);
+// removes key without calling .evict, returns its value (or NULL if it was absent)
+void*
+hh_lru_remove(hh_lru_t* lru, const void* key, size_t len);
+// returns the number of entries
+size_t
+hh_lru_len(const hh_lru_t* lru);
+hh_lru_stats_t
+hh_lru_stats(const hh_lru_t* lru);
+// passes every remaining value to .evict, frees the cache and resets it (options included)
+void
+hh_lru_free(hh_lru_t* lru);
+
+// hh_perfect_t is a minimal perfect hash table over a fixed set of strings (e.g. keywords)
+// it is built once from the key set, every key then owns exactly one of `count` slots,
+// so a lookup is one hash, one slot and one comparison
+// lookups return the key's index in the array passed to hh_perfect_build
+// EXAMPLE:
+// const char* keywords[] = { "if", "else", "while" };
+// hh_perfect_t kw = {0};
+// if(!hh_perfect_build(&kw, keywords, 3)) { ... }
+// hh_span_t tok = hh_span_next(&src, .delim = " ");
+// switch(hh_perfect_find_span(&kw, tok)) { case 0: ... }
+// hh_perfect_free(&kw);
+// the table can also be generated at build time with hh_perfect_emit,
+// the emitted file defines a ready-to-use `static const hh_perfect_t`
+typedef struct {
+    size_t count, bucket_count;
+    size_t seed;
+    // per-bucket displacement, keys in bucket b are placed by hashing with pilots[b]
+    const uint32_t* pilots;
+    // index (in the built key set) of the key in each slot
+    const uint32_t* ids;
+    // the key in slot i is chars[offs[i]..offs[i + 1])
+    const uint32_t* offs;
+    const char* chars;
+    // owned allocation, NULL for emitted tables
+    void* mem;
+} hh_perfect_t;
+
+// returned by the hh_perfect_find family when a string isn't in the set
+#define HH_PERFECT_NONE UINT32_MAX
+
+// average number of keys per bucket, larger buckets shrink the table but slow down the build
+#ifndef HH_PERFECT_BUCKET_SIZE
+#define HH_PERFECT_BUCKET_SIZE 2
+#endif // not HH_PERFECT_BUCKET_SIZE
+
+// builds the table for n null-terminated keys, replacing its previous contents
+// returns falsy (leaving the table untouched) if a key occurs twice
+// the keys are copied, they don't have to outlive the table
+_Bool
+hh_perfect_build(hh_perfect_t* table, const char* const* keys, size_t n);
+// returns the index of the string among the built keys, or HH_PERFECT_NONE
+uint32_t
+hh_perfect_find(const hh_perfect_t* table, const char* str);
+// same as hh_perfect_find, the string is given by its first len bytes
+uint32_t
+hh_perfect_find_n(const hh_perfect_t* table, const char* str, size_t len);
+// span variant (see span.h)
+#define hh_perfect_find_span(table, span) (hh_perfect_find_n((table), (span).ptr, hh_span_len(span)))
+// writes a C header defining `static const hh_perfect_t name` (and its arrays) to path,
+// returns truthy on success
+// hashes are word-size dependent, so the header must be compiled for the same word size
+_Bool
+hh_perfect_emit(const hh_perfect_t* table, const char* name, const char* path);
+// frees a built table and zeroes it
+void
+hh_perfect_free(hh_perfect_t* table);
+
 // simple struct for calculating an incremental average
 typedef struct {
     double mean;
@@ -414,6 +1062,115 @@ hh_profiler_start(const char* name, hh_profiler_t* parent);
 void
 hh_profiler_end(hh_profiler_t* profiler);
 
+// hh_seg_t is a segmented array: elements live in chunks of doubling size,
+// chunk k holds HH_SEG_FIRST_CHUNK << k elements
+// growing allocates the next chunk and never moves existing elements, so pointers to them
+// stay valid until hh_seg_free, and appends never pay for a copy of the whole array
+// chunk sizes double like darr capacities, so at most half of the reserved slots go unused
+// indexing is O(1): the chunk is the index's highest set bit and the chunk directory
+// is a fixed array inside hh_seg_t, so it never reallocates either
+// chunks are contiguous, so long scans should walk them with hh_seg_chunk instead of hh_seg_get
+// a zero-initialized hh_seg_t must be configured with hh_seg_config before use
+// EXAMPLE:
+// hh_seg_t events = {0};
+// hh_seg_config(&events, .elem_size = sizeof(event_t));
+// event_t* ev = hh_seg_push(&events, NULL);
+// for(size_t k = 0; k < hh_seg_chunks(&events); ++k) {
+//     size_t len;
+//     event_t* chunk = hh_seg_chunk(&events, k, &len);
+//     for(size_t i = 0; i < len; ++i) process(&chunk[i]);
+// }
+// hh_seg_free(&events);
+typedef struct HH__seg_t hh_seg_t;
+
+// number of elements in the first chunk, must be a power of two
+#ifndef HH_SEG_FIRST_CHUNK
+#define HH_SEG_FIRST_CHUNK 64
+#endif // not HH_SEG_FIRST_CHUNK
+
+// configuration options for hh_seg_t, applied through hh_seg_config on an empty array
+// elem_size: size of the elements in bytes
+// alloc:     allocator the chunks come from (see hh_allocator_t), NULL for the global one
+typedef struct {
+    size_t elem_size;
+    const hh_allocator_t* alloc;
+} hh_seg_opt;
+
+#define hh_seg_config(seg, ...) (HH__seg_config((seg), (hh_seg_opt) { __VA_ARGS__ }))
+
+// hh_seg_push    appends a copy of the element at val (zeroed if val is NULL), returns a pointer to it
+// hh_seg_putn    appends n elements copied from src (zeroed if src is NULL) with one copy per chunk,
+//                returns the index of the first one
+// hh_seg_get     returns a pointer to element i, which must be less than hh_seg_len
+// hh_seg_pop     removes the last element, returns a pointer to it (valid until the next append)
+// hh_seg_clear   removes all elements, the chunks are kept for reuse
+// all returned pointers stay valid until hh_seg_free
+static inline void*
+hh_seg_push(hh_seg_t* seg, const void* val);
+size_t
+hh_seg_putn(hh_seg_t* seg, const void* src, size_t n);
+static inline void*
+hh_seg_get(const hh_seg_t* seg, size_t i);
+void*
+hh_seg_pop(hh_seg_t* seg);
+void
+hh_seg_clear(hh_seg_t* seg);
+// number of elements
+size_t
+hh_seg_len(const hh_seg_t* seg);
+// number of chunks holding elements
+size_t
+hh_seg_chunks(const hh_seg_t* seg);
+// chunk k (k < hh_seg_chunks), stores the number of elements in it in *len
+// every chunk but the last is full, so walking k = 0, 1, ... visits the elements in order
+void*
+hh_seg_chunk(const hh_seg_t* seg, size_t k, size_t* len);
+// frees all chunks, the options are kept
+void
+hh_seg_free(hh_seg_t* seg);
+
+// a slot map is a dense array of values that hands out stable handles to them
+// the values are a regular dynamic array, so iteration and the read-only darr macros
+// (hh_darrlen, hh_darrlast, indexing) work on it as usual
+// removal moves the last value into the hole like hh_darrswapdel, but handles keep
+// pointing at their value, and handles to removed values are detected as stale
+// a handle packs a slot index (low 32 bits) and a generation (high 32 bits),
+// so resolving one is two array reads instead of a hash probe
+// only the hh_slot* macros may grow, shrink or free the array
+// EXAMPLE:
+// entity_t* entities = NULL;
+// hh_slot_t player = hh_slotinsert(entities, (entity_t) { .hp = 10 });
+// for(size_t i = 0; i < hh_darrlen(entities); ++i) update(&entities[i]);
+// entity_t* p = hh_slotget(entities, player);
+// hh_slotremove(entities, player);
+// ASSERT(hh_slotget(entities, player) == NULL);
+// hh_slotfree(entities);
+
+// handle to a value in a slot map
+typedef uint64_t hh_slot_t;
+
+// never refers to a value, usable as a null handle
+#define HH_SLOT_NONE ((hh_slot_t) 0)
+
+// hh_slotinsert  appends a value, returns its handle
+// hh_slotget     returns a pointer to the handle's value, or NULL if the handle is stale
+//                (the pointer is valid until the next insertion or removal)
+// hh_slotindex   returns the index of the handle's value in the array, or SIZE_MAX if the handle is stale
+// hh_slothas     returns truthy if the handle refers to a value
+// hh_slotremove  removes the handle's value, returns truthy if the handle wasn't stale
+// hh_slothandle  returns the handle of the value at index i
+// hh_slotclear   removes all values, every handle handed out so far becomes stale
+// hh_slotfree    frees the slot map and sets it to NULL
+#define hh_slotinsert(arr, val)  (HH__slotgrow((void**) &(arr), sizeof(*(arr))), \
+    (arr)[hh_darrheader(arr)->len] = (val), HH__slotpush(arr))
+#define hh_slotget(arr, handle)   (HH__slotget((arr), (handle)))
+#define hh_slotindex(arr, handle) (((arr) == NULL) ? SIZE_MAX : HH__slotindex((arr), (handle)))
+#define hh_slothas(arr, handle)   (hh_slotindex((arr), (handle)) != SIZE_MAX)
+#define hh_slotremove(arr, handle) (((arr) == NULL) ? 0 : HH__slotremove((arr), (handle)))
+#define hh_slothandle(arr, i)     (HH__slothandle((arr), (i)))
+#define hh_slotclear(arr)         (HH__slotclear(arr))
+#define hh_slotfree(arr)          (HH__slotfree(arr), (arr) = NULL)
+
 // hh_span_t is a string-view interface
 // intended for parsing
 typedef struct {
@@ -451,9 +1208,17 @@ hh_span(char* contents);
 #define hh_span_next(span, ...) hh_span_next_opt((span), (hh_span_opt) { __VA_ARGS__ })
 
 size_t 
-hh_hash_span(const void* ptr, size_t sz);
+hh_hash_span(const void* ptr, size_t sz, size_t seed);
 int
 hh_comp_span(const void* fst, const void* snd, size_t sz);
+// compare a span probe against cstr keys without copying it (see hh_hmapget_probe)
+// hh_hash_span produces the same hash as hh_hash_cstr for equal contents
+// hh_comp_span_cstr:       keys are `const char*`
+// hh_comp_span_cstr_owned: keys are char arrays filled by hh_copy_cstr
+int
+hh_comp_span_cstr(const void* fst, const void* snd, size_t sz);
+int
+hh_comp_span_cstr_owned(const void* fst, const void* snd, size_t sz);
 
 //
 //
@@ -505,25 +1270,85 @@ HH__calloc_checked(size_t num, size_t size, const char* file, int line);
 void*
 HH__realloc_checked(void** ptr, size_t size, const  char* file, int line);
 
+// calls through an allocator (NULL is the global one), asserting success
+// the name is used in the assertion message
+void*
+HH__alloc(const hh_allocator_t* alloc, size_t size, const char* name);
+void*
+HH__resize(const hh_allocator_t* alloc, void* ptr, size_t old_size, size_t new_size, const char* name);
+void
+HH__release(const hh_allocator_t* alloc, void* ptr, size_t size);
+
 // initial capacity of dynamic array
 #ifndef HH_DARR_INITIAL_CAPACITY
 #define HH_DARR_INITIAL_CAPACITY 16
 #endif // not HH_DARR_INITIAL_CAPACITY
 
+// growth policy of dynamic arrays
+// capacity is multiplied by HH_DARR_GROWTH_FACTOR until the elements take up HH_DARR_GROWTH_LIMIT bytes,
+// from then on it grows by HH_DARR_GROWTH_LIMIT bytes at a time (0 keeps multiplying)
+#ifndef HH_DARR_GROWTH_FACTOR
+#define HH_DARR_GROWTH_FACTOR 2.0
+#endif // not HH_DARR_GROWTH_FACTOR
+#ifndef HH_DARR_GROWTH_LIMIT
+#define HH_DARR_GROWTH_LIMIT 0
+#endif // not HH_DARR_GROWTH_LIMIT
+
+// (Linux only) arrays of at least this many bytes are moved into their own mapping,
+// which grows with mremap instead of realloc, so the elements are never copied again
+// 0 disables mapped arrays
+#ifndef HH_DARR_MMAP_THRESHOLD
+#define HH_DARR_MMAP_THRESHOLD (64 << 20)
+#endif // not HH_DARR_MMAP_THRESHOLD
+
 // internal array components
 typedef struct { 
     size_t len, cap, elem_size; 
+    // HH__DARR_* flags
+    size_t flags;
+    // allocator the array was created with
+    const hh_allocator_t* alloc;
+    // bytes between the start of the block and the header, which is moved forward
+    // when the elements must be aligned further than the block is (hh_darrinit_aligned)
+    // it also keeps the header a multiple of 16 bytes, so the elements are as aligned as the block
+    size_t offset;
 } hh_darrheader_t;
 
+// the array lives in its own mapping (see HH_DARR_MMAP_THRESHOLD)
+#define HH__DARR_MAPPED 1
+// the array doesn't own its block (HH_DARR_INLINE), growing copies it to the heap
+#define HH__DARR_UNOWNED 2
+// the bits above hold the alignment of the elements (0 when it is the block's own)
+#define HH__DARR_ALIGN_SHIFT 8
+#define HH__darralign(arr_hdr) ((arr_hdr)->flags >> HH__DARR_ALIGN_SHIFT)
+
 // helper macros for dynamic array implementation
+// the capacity check is inlined, HH__darrgrow is only called when the array must (re)allocate
 #define hh_darrheader(arr)  (((hh_darrheader_t*) (arr)) - 1)
-#define hh_darrgrow(arr, n) (HH__darrgrow((void**) &(arr), (n), sizeof(*(arr))), (arr))
+#define hh_darrgrow(arr, n) ((((arr) == NULL || hh_darrheader(arr)->len + (n) >= hh_darrheader(arr)->cap) ? \
+    HH__darrgrow((void**) &(arr), (n), sizeof(*(arr))) : (void) 0), (arr))
 
 // helper functions for dynamic array
 void 
 HH__darrgrow(void** arr_ptr, size_t n, size_t elem_size);
 size_t
 HH__darraddn(void** arr_ptr, size_t n, size_t elem_size);
+size_t
+HH__darradd_uninit(void** arr_ptr, size_t n, size_t elem_size);
+size_t
+HH__darrputn(void** arr_ptr, const void* src, size_t n, size_t elem_size);
+size_t
+HH__darrinsertn(void** arr_ptr, size_t i, const void* src, size_t n, size_t elem_size);
+void
+HH__darrerasen(void* arr, size_t i, size_t n);
+void
+HH__darrreserve(void** arr_ptr, size_t n, size_t elem_size);
+void
+HH__darrshrink(void** arr_ptr);
+void
+HH__darrfree(void* arr);
+void
+HH__darrinit(void** arr_ptr, size_t elem_size, const hh_allocator_t* alloc, size_t align);
 
 // swaps two values, used for darrswap and darrswapdel
 void
@@ -542,6 +1367,11 @@ struct HH__arena {
     char* end;
     char* cur;
     hh_arena* next;
+    // allocator behind the segments, the global one at the time of the first allocation
+    const hh_allocator_t* alloc;
+    // (first segment only) segment of the most recent allocation, where the next one starts,
+    // so allocating never walks the whole chain
+    hh_arena* tail;
 };
 
 // the default size of a 'page' in the allocator
@@ -642,11 +1472,47 @@ struct HH__timer_t {
     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, \
     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, )
 
+// sets up the header of an HH_DARR_INLINE buffer, returns its elements
+// capacity includes the spare element that null-terminated char arrays need
+static inline void*
+HH__darrinline(hh_darrheader_t* arr_hdr, void* buf, size_t cap, size_t elem_size) {
+    HH_ASSERT((void*) (arr_hdr + 1) == buf, "HH_DARR_INLINE requires elements aligned to at most 16 bytes");
+    *arr_hdr = (hh_darrheader_t) { .cap = cap, .elem_size = elem_size, .flags = HH__DARR_UNOWNED };
+    return buf;
+}
+
 // the default number of buckets to be used by hh_hmap
 #ifndef HH_BUCKET_COUNT
 #define HH_BUCKET_COUNT 16
 #endif // not HH_BUCKET_COUNT
 
+// the default maximum load factor (entries per bucket) of hh_hmap
+#ifndef HH_HMAP_MAX_LOAD
+#define HH_HMAP_MAX_LOAD 1.0
+#endif // not HH_HMAP_MAX_LOAD
+
+// the default maximum load factor (fraction of occupied slots) of HH_HMAP_FLAT
+#ifndef HH_HMAP_FLAT_MAX_LOAD
+#define HH_HMAP_FLAT_MAX_LOAD 0.875
+#endif // not HH_HMAP_FLAT_MAX_LOAD
+
+// control bytes of HH_HMAP_FLAT slots
+// full slots hold the low 7 bits of the (mixed) hash, so the high bit marks a free slot
+#define HH__HMAP_EMPTY   0x80
+#define HH__HMAP_DELETED 0xFE
+// number of control bytes compared at once
+#define HH__HMAP_GROUP   16
+
+// number of old buckets migrated by each insert/remove while rehashing
+#ifndef HH_HMAP_REHASH_STEP
+#define HH_HMAP_REHASH_STEP 4
+#endif // not HH_HMAP_REHASH_STEP
+
+// number of keys hashed and prefetched together by hh_hmapget_many/hh_hmapinsert_many
+#ifndef HH_HMAP_BATCH
+#define HH_HMAP_BATCH 16
+#endif // not HH_HMAP_BATCH
+
 // descriptor for hmap entry, computed via hh_hmapprop
 typedef struct {
     size_t sz_key, off_key;
@@ -659,21 +1525,342 @@ typedef struct {
     .sz_val = sizeof((map)->val), .off_val = (size_t) ((char*)&(map)->val - (char*)(map)), \
     .sz_entry = sizeof(*(map)) })
 
+// an index entry, refers to an entry of the map
+// tag holds the upper bits of the entry's hash (see HH__hmaptag), so probes reject most
+// mismatched slots without touching the entry, and a slot still fits in 8 bytes
+// (which limits maps to UINT32_MAX - 1 entries)
+typedef struct {
+    uint32_t idx;
+    uint32_t tag;
+} hh_hmapslot_t;
+
 // internal hmap components
+// hashes[i] caches the hash of entry i, so keys are never re-hashed while the index is rebuilt
+// pos[i] is where the index references entry i (position in its bucket, or its flat slot),
+// so removal never searches the index
+// while rehashing, old buckets below `rehash` have already been migrated,
+// so a key lives in buckets_old iff its old bucket index is >= rehash
 typedef struct {
     hh_hmapprop_t prop;
     hh_hmap_opt opt;
     size_t len, cap, last;
-    size_t** buckets;
+    size_t* hashes;
+    size_t* pos;
+    hh_hmapslot_t** buckets;
+    size_t bucket_count;
+    hh_hmapslot_t** buckets_old;
+    size_t bucket_count_old, rehash;
+    // HH_HMAP_FLAT index, slot_count is a power of two
+    // slot_free counts the empty slots that may still be filled before resizing
+    unsigned char* ctrl;
+    hh_hmapslot_t* slots;
+    size_t slot_count, slot_free;
+    // set for maps loaded by hh_hmapload_mapped, string keys may point into the mapping
+    // `mapped` is set while the entries and index live in it too, the first insertion copies them out
+    void* mapping;
+    size_t mapping_size;
+    _Bool mapped;
+    // set when .filter_fpr is, holds the hashes of all entries
+    // removed entries stay in it until it is rebuilt
+    hh_bloom_t filter;
+    // sz_key when keys are compared by memcmp and fit in a word (1, 2, 4 or 8 bytes),
+    // lookups then compare them inline instead of calling memcmp
+    size_t word_key;
+    // set when word keys are hashed by hh_hash_wide, which is then inlined as well
+    // word_state caches its seeded initial state
+    _Bool word_hash;
+    uint64_t word_state;
+    // hh_hmapstats counters, present regardless of HH_HMAP_STATS so that the layout never changes
+    size_t inserts, replaces, removes, rehashes, comparisons;
 } hh_hmapheader_t;
 // macro for retrieving hmap header
 #define hh_hmapheader(map) (((hh_hmapheader_t*) (map)) - 1)
 
+// bumps one of the hh_hmapstats counters, a no-op unless HH_HMAP_STATS is defined
+// lookups bump `comparisons` through a const header, see the warning at hh_hmapstats_t
+#ifdef HH_HMAP_STATS
+#define HH__HMAP_COUNT(map_hdr, counter) ((void) ++(((hh_hmapheader_t*) (map_hdr))->counter))
+#else
+#define HH__HMAP_COUNT(map_hdr, counter) ((void) 0)
+#endif // HH_HMAP_STATS
+
+// SIMD group probing for HH_HMAP_FLAT
+// define HH_NO_SIMD to force the scalar fallback
+#ifndef HH_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HH__HMAP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define HH__HMAP_NEON
+#include <arm_neon.h>
+#endif
+#endif // not HH_NO_SIMD
+
+// index of the lowest set bit, mask must be non-zero
+static inline unsigned
+HH__ctz(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned) __builtin_ctz(mask);
+#else
+    unsigned idx = 0;
+    while(!(mask & 1u)) { mask >>= 1; ++idx; }
+    return idx;
+#endif
+}
+
+// bitmask of the slots in a group whose control byte equals `byte`
+static inline unsigned
+HH__hmapgroupmatch(const unsigned char* group, unsigned char byte) {
+#if defined(HH__HMAP_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+    return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) byte)));
+#elif defined(HH__HMAP_NEON)
+    static const uint8_t bits[HH__HMAP_GROUP] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(group), vdupq_n_u8(byte)), vld1q_u8(bits));
+    return (unsigned) vaddv_u8(vget_low_u8(eq)) | ((unsigned) vaddv_u8(vget_high_u8(eq)) << 8);
+#else
+    unsigned mask = 0;
+    for(unsigned i = 0; i < HH__HMAP_GROUP; ++i) mask |= (unsigned) (group[i] == byte) << i;
+    return mask;
+#endif
+}
+
+// spreads the user hash so both the group index (high bits) and
+// the 7-bit control tag (low bits) are well distributed
+static inline size_t
+HH__hmapmix(size_t hash) {
+    uint64_t h = (uint64_t) hash;
+    h ^= h >> 32;
+    h *= 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    return (size_t) h;
+}
+
+// the hash bits kept in an index slot, the upper half of a 64-bit hash
+// (the bucket, group and control byte mostly depend on the lower half)
+static inline uint32_t
+HH__hmaptag(size_t hash) {
+    return (uint32_t) ((uint64_t) hash >> ((sizeof(size_t) > 4) ? 32 : 0));
+}
+
+// hh_hash_wide primitives (see the implementation),
+// here so that lookups can hash word keys inline
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 HH__u128;
+#endif // __SIZEOF_INT128__
+
+static const uint64_t HH__HASH_SECRET[2] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL };
+
+// 64x64 -> 128-bit multiply, returns both halves through the arguments
+static inline void
+HH__hashmum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+    HH__u128 r = (HH__u128) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+    uint64_t c = (t < rl) + (lo < t);
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif // not __SIZEOF_INT128__
+}
+
+static inline uint64_t
+HH__hashmix(uint64_t a, uint64_t b) {
+    HH__hashmum(&a, &b);
+    return a ^ b;
+}
+
+// reads a word key as a zero-extended little-endian integer
+static inline uint64_t
+HH__hmapwordread(const void* key, size_t sz) {
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // fixed-size copies compile to single loads
+    uint8_t v8;
+    uint16_t v16;
+    uint32_t v32;
+    uint64_t v64;
+    switch(sz) {
+        case 1: __builtin_memcpy(&v8, key, 1); return v8;
+        case 2: __builtin_memcpy(&v16, key, 2); return v16;
+        case 4: __builtin_memcpy(&v32, key, 4); return v32;
+        default: __builtin_memcpy(&v64, key, 8); return v64;
+    }
+#else
+    const unsigned char* p = key;
+    uint64_t v = 0;
+    for(size_t i = 0; i < sz; ++i) v |= (uint64_t) p[i] << (8 * i);
+    return v;
+#endif
+}
+
+// equals hh_hash_wide(key, sz, seed) for word keys, state is the seeded state it starts from
+static inline size_t
+HH__hmapwordhash(const void* key, size_t sz, uint64_t state) {
+    uint64_t a = HH__hmapwordread(key, sz);
+    uint64_t b = state;
+    a ^= HH__HASH_SECRET[1];
+    HH__hashmum(&a, &b);
+    return (size_t) HH__hashmix(a ^ HH__HASH_SECRET[0] ^ (uint64_t) sz, b ^ HH__HASH_SECRET[1]);
+}
+
+// same as hash % count, bucket counts are usually powers of two (unless .bucket_count says otherwise),
+// which avoids the division
+static inline size_t
+HH__hmapbucketidx(size_t hash, size_t count) {
+    return ((count & (count - 1)) == 0) ? (hash & (count - 1)) : (hash % count);
+}
+
+// returns the bucket that holds (or would hold) a key with the given hash
+static inline hh_hmapslot_t**
+HH__hmapbucketref(const hh_hmapheader_t* map_hdr, size_t hash) {
+    if(map_hdr->buckets_old != NULL) {
+        size_t idx = HH__hmapbucketidx(hash, map_hdr->bucket_count_old);
+        if(idx >= map_hdr->rehash) return &(map_hdr->buckets_old[idx]);
+    }
+    return &(map_hdr->buckets[HH__hmapbucketidx(hash, map_hdr->bucket_count)]);
+}
+
+// inlining is forced so that a constant comp (see HH_HMAP_DEFINE) becomes a direct call
+#if defined(__GNUC__) || defined(__clang__)
+#define HH__FORCE_INLINE static inline __attribute__((always_inline))
+#else
+#define HH__FORCE_INLINE static inline
+#endif
+
+// equality of word keys (see .word_key), a fixed-size memcmp compiles to a single load and compare
+static inline _Bool
+HH__hmapwordeq(const void* fst, const void* snd, size_t sz) {
+#if defined(__GNUC__) || defined(__clang__)
+    switch(sz) {
+        case 1: return __builtin_memcmp(fst, snd, 1) == 0;
+        case 2: return __builtin_memcmp(fst, snd, 2) == 0;
+        case 4: return __builtin_memcmp(fst, snd, 4) == 0;
+        default: return __builtin_memcmp(fst, snd, 8) == 0;
+    }
+#else
+    const unsigned char* bytes_fst = fst;
+    const unsigned char* bytes_snd = snd;
+    for(size_t i = 0; i < sz; ++i) if(bytes_fst[i] != bytes_snd[i]) return 0;
+    return 1;
+#endif
+}
+
+// comparison for lookups by key, NULL selects HH__hmapwordeq
+#define HH__hmapcomp(map_hdr) ((map_hdr)->word_key ? NULL : (map_hdr)->opt.key_f.comp)
+
+// hashes a key with .key_f.hash
+static inline size_t
+HH__hmaphashkey(const hh_hmapheader_t* map_hdr, const void* key) {
+    if(map_hdr->word_hash) return HH__hmapwordhash(key, map_hdr->prop.sz_key, map_hdr->word_state);
+    return (map_hdr->opt.key_f.hash)(key, map_hdr->prop.sz_key, map_hdr->opt.seed);
+}
+
+// returns the index of the entry matching key (with the given hash)
+// comp receives key first, which allows probing with a different key type
+// a NULL comp compares word keys inline
+HH__FORCE_INLINE size_t
+HH__hmapfind(const void* map, size_t hash, const void* key, hh_comp_f comp) {
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    const char* other;
+    if(map_hdr->filter.blocks != NULL && !hh_bloom_has(&(map_hdr->filter), hash)) return SIZE_MAX;
+    uint32_t tag = HH__hmaptag(hash);
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        size_t mix = HH__hmapmix(hash);
+        size_t mask = map_hdr->slot_count / HH__HMAP_GROUP - 1;
+        size_t group = (mix >> 7) & mask;
+        for(size_t step = 1;; group = (group + step++) & mask) {
+            const unsigned char* ctrl = map_hdr->ctrl + group * HH__HMAP_GROUP;
+            for(unsigned match = HH__hmapgroupmatch(ctrl, (unsigned char) (mix & 0x7F)); match; match &= match - 1) {
+                const hh_hmapslot_t* slot = map_hdr->slots + group * HH__HMAP_GROUP + HH__ctz(match);
+                // the slot is next to the one being probed, the entry is only touched when the tags agree
+                if(slot->tag != tag) continue;
+                other = (const char*) map + slot->idx * map_hdr->prop.sz_entry + map_hdr->prop.off_key;
+                HH__HMAP_COUNT(map_hdr, comparisons);
+                if((comp == NULL) ? HH__hmapwordeq(key, other, map_hdr->prop.sz_key) : 
+                    comp(key, other, map_hdr->prop.sz_key) == 0) return slot->idx;
+            }
+            // an empty slot ends the probe sequence
+            if(HH__hmapgroupmatch(ctrl, HH__HMAP_EMPTY)) return SIZE_MAX;
+        }
+    }
+    hh_hmapslot_t* bucket = *HH__hmapbucketref(map_hdr, hash);
+    for(size_t i = 0; i < hh_darrlen(bucket); ++i) {
+        if(bucket[i].tag != tag) continue;
+        // calculate byte offset to entry's key
+        other = (const char*) map + bucket[i].idx * map_hdr->prop.sz_entry + map_hdr->prop.off_key;
+        HH__HMAP_COUNT(map_hdr, comparisons);
+        if((comp == NULL) ? HH__hmapwordeq(key, other, map_hdr->prop.sz_key) : 
+            comp(key, other, map_hdr->prop.sz_key) == 0) return bucket[i].idx;
+    }
+    return SIZE_MAX;
+}
+
+// lookups are inlined, word keys with the default hash and comparison don't call through any pointer
+static inline size_t
+hh_hmapget(const void* map, const void* key) {
+    HH_ASSERT_INVARIANT(key != NULL);
+    if(map == NULL) return SIZE_MAX;
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    return HH__hmapfind(map, HH__hmaphashkey(map_hdr, key), key, HH__hmapcomp(map_hdr));
+}
+
+static inline size_t
+hh_hmapget_hashed(const void* map, const void* key, size_t hash) {
+    HH_ASSERT_INVARIANT(key != NULL);
+    if(map == NULL) return SIZE_MAX;
+    return HH__hmapfind(map, hash, key, HH__hmapcomp(hh_hmapheader(map)));
+}
+
 // implementations of hmap macros
 hh_hmapheader_t*
 HH__hmapconfig(void** map_ptr, hh_hmapprop_t prop, hh_hmap_opt opt);
 _Bool
 HH__hmapinsert(void** map_ptr, hh_hmapprop_t prop, const void* key);
+_Bool
+HH__hmapinsert_hashed(void** map_ptr, const void* key, size_t hash);
+void
+HH__hmapupsert(void** map_ptr, hh_hmapprop_t prop, const void* key);
+void
+HH__hmapget_many(const void* map, const void* keys, size_t n, size_t** out);
+size_t
+HH__hmapinsert_many(void** map_ptr, hh_hmapprop_t prop, const void* keys, const void* vals, size_t n);
+// building blocks shared with the HH_HMAP_DEFINE functions
+size_t
+HH__hmapappend(void** map_ptr, const void* key, size_t hash);
+void*
+HH__hmapreplace(void** map_ptr, size_t idx, const void* key);
+void*
+HH__hmapremoveat(const void* map, size_t idx);
+_Bool
+HH__hmapload_mapped(void** map_ptr, hh_hmapprop_t prop, const char* path);
+
+// file format of hh_hmapsave, all offsets are from the start of the file:
+// | hh_hmapfile_t | gap for hh_hmapheader_t | entries | hashes | pos | ctrl | slots | string heap |
+// hh_hmapload_mapped fills the gap in, so that the entries can be used in place
+// the entries section has room for one more entry, the spare slot used by hh_hmapremove
+// string keys point into the heap as if the file were mapped at `base`,
+// they are relocated when it can't be mapped there
+#define HH__HMAPFILE_MAGIC   "hh_hmap"
+#define HH__HMAPFILE_VERSION 4
+#define HH__HMAPFILE_ENDIAN  0x01020304u
+#define HH__HMAPFILE_ALIGN   64
+// key representations
+#define HH__HMAPFILE_RAW  0
+#define HH__HMAPFILE_CSTR 1
+#define HH__HMAPFILE_SPAN 2
+typedef struct {
+    char magic[8];
+    uint32_t version, endian, word, keys;
+    // checksum (hh_hash_wide, seed 0) of everything after this header
+    uint64_t checksum, size, base;
+    uint64_t len, seed, slot_count;
+    uint64_t sz_entry, sz_key, off_key, sz_val, off_val;
+    uint64_t off_entries, off_hashes, off_pos, off_ctrl, off_slots, off_heap;
+} hh_hmapfile_t;
 
 // NetBSD: getline.c,v 1.2 2014/09/16 17:23:50 christos Exp
 ptrdiff_t // NO PREFIX STRIPPING
@@ -684,6 +1871,176 @@ hh_getline(char** buf, size_t* bufsiz, FILE* fp);
 size_t
 hh_strnlen(const char *s, size_t maxlen);
 
+// a node is followed by its keys and then by its values (leaf) or its len + 1 children (inner)
+// inner child i holds the keys in [keys[i - 1], keys[i])
+typedef struct HH__btree_node_t {
+    // next leaf in key order
+    struct HH__btree_node_t* next;
+    uint32_t len;
+    uint32_t leaf;
+} HH__btree_node_t;
+
+// HH_BTREE_STR keys, the bytes live in the tree's arena
+// separators in inner nodes own a copy of their bytes, so a leaf key's bytes are freed with it
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__btree_str_t;
+
+struct HH__btree_t {
+    hh_btree_opt opt;
+    HH__btree_node_t* root;
+    size_t len;
+    // derived from opt on first use
+    size_t key_size, leaf_cap, inner_cap, off_vals;
+    hh_arena arena;
+    // blocks freed by removal, reused before the arena grows
+    // string key blocks are kept by size class, class c holds 16 << c bytes
+    void* free_nodes;
+    void* free_keys[sizeof(size_t) * 8];
+};
+
+void
+HH__btree_config(hh_btree_t* tree, hh_btree_opt opt);
+
+// internal hset components
+// slots[0..cap) is the table (cap is a power of two), key 0 marks an empty slot
+// key 0 itself lives in the extra slot `cap`, which is occupied iff `zero` is set
+typedef struct {
+    size_t sz_key, sz_entry;
+    size_t len, cap, last;
+    // allocator behind the table, the global one at the time the set was created
+    const hh_allocator_t* alloc;
+    // 64 - log2(cap), fibonacci hashing keeps the top bits of the product
+    uint32_t shift;
+    uint32_t zero;
+    // rounds the header up to a multiple of 16 bytes, so map values are as aligned as a darr's
+    uint32_t pad[(16 - (5 * sizeof(size_t) + sizeof(void*) + 2 * sizeof(uint32_t)) % 16) / sizeof(uint32_t)];
+} hh_hsetheader_t;
+// fails to compile if the padding above is wrong
+typedef char HH__hsetheader_aligned[(sizeof(hh_hsetheader_t) % 16 == 0) ? 1 : -1];
+// macro for retrieving hset header
+#define hh_hsetheader(set) (((hh_hsetheader_t*) (set)) - 1)
+
+// reads the key at the start of an entry
+// (signed and unsigned keys of the same width may alias)
+static inline uint64_t
+HH__hsetkey(const void* entry, size_t sz_key) {
+    switch(sz_key) {
+        case 1: return *((const uint8_t*) entry);
+        case 2: return *((const uint16_t*) entry);
+        case 4: return *((const uint32_t*) entry);
+        default: return *((const uint64_t*) entry);
+    }
+}
+
+// truncates a (possibly sign-extended) key to the width it is stored with
+// (hh_hsetreserve leaves the key size at 0, which maps every key to 0)
+static inline uint64_t
+HH__hsetnorm(uint64_t key, size_t sz_key) {
+    return (sz_key >= 8) ? key : key & ((1ULL << (sz_key * 8)) - 1);
+}
+
+static inline size_t
+HH__hsethome(const hh_hsetheader_t* set_hdr, uint64_t key) {
+    return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> set_hdr->shift);
+}
+
+// returns the slot holding key, or SIZE_MAX
+HH__FORCE_INLINE size_t
+HH__hsetfind(const void* set, uint64_t key) {
+    const hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    key = HH__hsetnorm(key, set_hdr->sz_key);
+    if(key == 0) return set_hdr->zero ? set_hdr->cap : SIZE_MAX;
+    size_t mask = set_hdr->cap - 1;
+    for(size_t i = HH__hsethome(set_hdr, key);; i = (i + 1) & mask) {
+        uint64_t other = HH__hsetkey((const char*) set + i * set_hdr->sz_entry, set_hdr->sz_key);
+        if(other == key) return i;
+        // the table is never full, so every probe reaches an empty slot
+        if(other == 0) return SIZE_MAX;
+    }
+}
+
+// implementations of hset macros
+_Bool
+HH__hsetinsert(void** set_ptr, size_t sz_key, size_t sz_entry, uint64_t key);
+_Bool
+HH__hsetremove(void* set, uint64_t key);
+void
+HH__hsetreserve(void** set_ptr, size_t sz_entry, size_t n);
+void
+HH__hsetinit(void** set_ptr, size_t sz_entry, const hh_allocator_t* alloc);
+_Bool
+HH__hsetvalid(const void* set, size_t idx);
+void
+HH__hsetfree(void* set);
+
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__intern_key_t;
+
+struct HH__intern_t {
+    hh_arena arena;
+    // entry i holds the string with ID i
+    struct { HH__intern_key_t key; uint32_t val; }* index;
+};
+
+size_t
+HH__intern_hash(const void* ptr, size_t sz, size_t seed);
+int
+HH__intern_comp(const void* fst, const void* snd, size_t sz);
+
+// key blocks are recycled through per-size free lists, sizes 8, 16, ..., 8 << (HH__LRU_CLASSES - 1)
+// longer keys are malloc'd
+#define HH__LRU_CLASSES 10
+
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__lru_key_t;
+
+// prev/next are entry indices (SIZE_MAX at either end of the list)
+typedef struct {
+    void* val;
+    size_t size;
+    size_t prev, next;
+} HH__lru_node_t;
+
+struct HH__lru_t {
+    hh_lru_opt opt;
+    struct { HH__lru_key_t key; HH__lru_node_t val; }* index;
+    // most and least recently used entries, only meaningful while the cache isn't empty
+    size_t head, tail;
+    size_t bytes, hits, misses, evictions;
+    hh_arena arena;
+    void* free_keys[HH__LRU_CLASSES];
+};
+
+void
+HH__lru_config(hh_lru_t* lru, hh_lru_opt opt);
+size_t
+HH__lru_hash(const void* ptr, size_t sz, size_t seed);
+int
+HH__lru_comp(const void* fst, const void* snd, size_t sz);
+
+// pilots tried for a bucket before the build starts over with another seed
+#define HH__PERFECT_MAX_PILOT (1u << 20)
+// seeds tried before hh_perfect_build gives up
+#define HH__PERFECT_MAX_SEED 64
+
+// the bucket is picked by the high half of the mixed hash, the slot by the hash mixed with the pilot
+// (mixed to 64 bits first, where size_t is 32 bits the hash itself has no high half)
+static inline size_t
+HH__perfectbucket(uint64_t hash, size_t bucket_count) {
+    return (size_t) (((HH__mix64(hash) >> 32) * (uint64_t) bucket_count) >> 32);
+}
+
+static inline size_t
+HH__perfectslot(uint64_t hash, uint32_t pilot, size_t count) {
+    return (size_t) (((uint64_t) (uint32_t) hh_hash_int(hash, pilot) * (uint64_t) count) >> 32);
+}
+
 struct HH__profiler_t {
     const char* name;
     hh_timer_t timer;
@@ -697,28 +2054,149 @@ struct HH__profiler_t {
     } inner;
 };
 
-hh_span_t
-hh_span_next_opt(hh_span_t* s, hh_span_opt opt);
-
-#ifdef HH_IMPLEMENTATION
+// one chunk per bit of an index, enough to address any size_t
+#define HH__SEG_MAX_CHUNKS (sizeof(size_t) * 8)
 
-// implementation-exclusive includes
-#include <ctype.h>
-#include <errno.h>
-#include <string.h>
-#include <stdarg.h>
-#include <stdlib.h>
+struct HH__seg_t {
+    hh_seg_opt opt;
+    size_t len;
+    // chunk k holds HH_SEG_FIRST_CHUNK << k elements, allocated on first use
+    char* chunks[HH__SEG_MAX_CHUNKS];
+};
 
-// platform-dependent includes
-#ifdef _WIN32
-#include <io.h>
-#include <windows.h>
+// index of the highest set bit, v must be non-zero
+static inline size_t
+HH__seg_log2(size_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(unsigned long long) * 8 - 1 - (size_t) __builtin_clzll((unsigned long long) v);
 #else
-#include <unistd.h>
-#include <sys/stat.h>
-#endif // _WIN32
+    size_t idx = 0;
+    while(v >>= 1) ++idx;
+    return idx;
+#endif
+}
 
-static FILE* HH_DBG_STREAM = NULL;
+// element i is at offset i + HH_SEG_FIRST_CHUNK - (HH_SEG_FIRST_CHUNK << k) of chunk k,
+// where HH_SEG_FIRST_CHUNK << k is the highest set bit of i + HH_SEG_FIRST_CHUNK
+HH__FORCE_INLINE void*
+HH__seg_at(const hh_seg_t* seg, size_t i) {
+    size_t pos = i + HH_SEG_FIRST_CHUNK;
+    size_t top = HH__seg_log2(pos);
+    size_t k = top - HH__seg_log2(HH_SEG_FIRST_CHUNK);
+    return seg->chunks[k] + (pos - ((size_t) 1 << top)) * seg->opt.elem_size;
+}
+
+static inline void*
+hh_seg_get(const hh_seg_t* seg, size_t i) {
+    HH_ASSERT(i < seg->len, "hh_seg_get received index %zu of %zu", i, seg->len);
+    return HH__seg_at(seg, i);
+}
+
+// copies into the current chunk inline, only a new chunk or a zeroed element goes through hh_seg_putn
+static inline void*
+hh_seg_push(hh_seg_t* seg, const void* val) {
+#if defined(__GNUC__) || defined(__clang__)
+    size_t pos = seg->len + HH_SEG_FIRST_CHUNK;
+    size_t top = HH__seg_log2(pos);
+    char* chunk = seg->chunks[top - HH__seg_log2(HH_SEG_FIRST_CHUNK)];
+    if(chunk != NULL && val != NULL) {
+        char* dst = chunk + (pos - ((size_t) 1 << top)) * seg->opt.elem_size;
+        __builtin_memcpy(dst, val, seg->opt.elem_size);
+        ++(seg->len);
+        return dst;
+    }
+#endif
+    return HH__seg_at(seg, hh_seg_putn(seg, val, 1));
+}
+
+void
+HH__seg_config(hh_seg_t* seg, hh_seg_opt opt);
+
+// internal slot map components
+// the darr header comes last, so it sits right in front of the values
+typedef struct {
+    // slot i: index of its value while live (next free slot otherwise) and generation
+    struct { uint32_t idx, gen; }* slots;
+    // owners[j]: slot of the value at index j
+    uint32_t* owners;
+    // first free slot, UINT32_MAX if there is none
+    uint32_t free;
+    // rounds the fields above up to a multiple of 16 bytes, so the values are as aligned as a darr's
+    uint32_t pad[(16 - (2 * sizeof(void*) + sizeof(uint32_t)) % 16) / sizeof(uint32_t)];
+    hh_darrheader_t darr;
+} hh_slotheader_t;
+// fails to compile if the padding above is wrong
+typedef char HH__slotheader_aligned[(offsetof(hh_slotheader_t, darr) % 16 == 0) ? 1 : -1];
+// macro for retrieving slot map header
+#define hh_slotheader(arr) (((hh_slotheader_t*) (arr)) - 1)
+
+// returns the index of the handle's value, or SIZE_MAX
+HH__FORCE_INLINE size_t
+HH__slotindex(const void* arr, hh_slot_t handle) {
+    const hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = (uint32_t) handle;
+    // generations start at 1, so HH_SLOT_NONE never matches
+    if(slot >= hh_darrlen(arr_hdr->slots) || arr_hdr->slots[slot].gen != (uint32_t) (handle >> 32)) return SIZE_MAX;
+    return arr_hdr->slots[slot].idx;
+}
+
+static inline void*
+HH__slotget(void* arr, hh_slot_t handle) {
+    if(arr == NULL) return NULL;
+    size_t idx = HH__slotindex(arr, handle);
+    return (idx == SIZE_MAX) ? NULL : (char*) arr + idx * hh_darrheader(arr)->elem_size;
+}
+
+// implementations of slot map macros
+void
+HH__slotgrow(void** arr_ptr, size_t elem_size);
+hh_slot_t
+HH__slotpush(void* arr);
+_Bool
+HH__slotremove(void* arr, hh_slot_t handle);
+hh_slot_t
+HH__slothandle(const void* arr, size_t idx);
+void
+HH__slotclear(void* arr);
+void
+HH__slotfree(void* arr);
+
+hh_span_t
+hh_span_next_opt(hh_span_t* s, hh_span_opt opt);
+// lets hh_hmapsave recognize maps with hh_span_t keys
+#define HH__HMAPFILE_SPAN_COMP hh_comp_span
+
+#ifdef HH_IMPLEMENTATION
+
+// implementation-exclusive includes
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+
+// platform-dependent includes
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+// read prefetch hint, a no-op where unsupported
+#if defined(__GNUC__) || defined(__clang__)
+#define HH__PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#elif defined(HH__HMAP_SSE2)
+#define HH__PREFETCH(addr) _mm_prefetch((const char*) (addr), _MM_HINT_T0)
+#else
+#define HH__PREFETCH(addr) ((void) (addr))
+#endif
+
+static FILE* HH_DBG_STREAM = NULL;
 static FILE* HH_MSG_STREAM = NULL;
 static FILE* HH_ERR_STREAM = NULL;
 
@@ -736,6 +2214,7 @@ hh_log_stream_get(int level) {
     if(HH_LOG_MSG & level) return (HH_MSG_STREAM == NULL) ? stdout : HH_MSG_STREAM;
     if(HH_LOG_ERR & level) return (HH_ERR_STREAM == NULL) ? stderr : HH_ERR_STREAM;
     HH_UNREACHABLE;
+    return NULL;
 }
 
 void*
@@ -776,39 +2255,315 @@ HH__realloc_checked(void** ptr, size_t size, const char* file, int line) {
     return ret;
 }
 
+// the checked wrappers abort on failure, so the default allocator never returns NULL
+// zero-sized requests are rounded up, so that they don't look like failures
+static void*
+HH__allocator_checked_alloc(void* ctx, size_t size) {
+    (void) ctx;
+    return HH__calloc_checked(1, HH_MAX(size, (size_t) 1), __FILE__, __LINE__);
+}
+
+static void*
+HH__allocator_checked_resize(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    (void) ctx;
+    (void) old_size;
+    return HH__realloc_checked(&ptr, HH_MAX(new_size, (size_t) 1), __FILE__, __LINE__);
+}
+
+static void
+HH__allocator_checked_release(void* ctx, void* ptr, size_t size) {
+    (void) ctx;
+    (void) size;
+    free(ptr);
+}
+
+const hh_allocator_t hh_allocator_checked = {
+    .alloc = HH__allocator_checked_alloc,
+    .resize = HH__allocator_checked_resize,
+    .release = HH__allocator_checked_release,
+};
+
+static const hh_allocator_t* HH__allocator_global = &hh_allocator_checked;
+
+const hh_allocator_t*
+hh_allocator_get(void) {
+    return HH__allocator_global;
+}
+
+const hh_allocator_t*
+hh_allocator_set(const hh_allocator_t* alloc) {
+    const hh_allocator_t* prev = HH__allocator_global;
+    HH__allocator_global = (alloc == NULL) ? &hh_allocator_checked : alloc;
+    return prev;
+}
+
+void*
+HH__alloc(const hh_allocator_t* alloc, size_t size, const char* name) {
+    if(alloc == NULL) alloc = HH__allocator_global;
+    void* ptr = (alloc->alloc)(alloc->ctx, size);
+    (void) name;
+    HH_ASSERT(ptr != NULL, "%s failed to allocate %zu bytes", name, size);
+    return ptr;
+}
+
+void*
+HH__resize(const hh_allocator_t* alloc, void* ptr, size_t old_size, size_t new_size, const char* name) {
+    if(alloc == NULL) alloc = HH__allocator_global;
+    ptr = (alloc->resize)(alloc->ctx, ptr, old_size, new_size);
+    (void) name;
+    HH_ASSERT(ptr != NULL, "%s failed to allocate %zu bytes", name, new_size);
+    return ptr;
+}
+
+void
+HH__release(const hh_allocator_t* alloc, void* ptr, size_t size) {
+    if(ptr == NULL) return;
+    if(alloc == NULL) alloc = HH__allocator_global;
+    (alloc->release)(alloc->ctx, ptr, size);
+}
+
+#if defined(__linux__) && HH_DARR_MMAP_THRESHOLD > 0
+#define HH__DARR_MMAP
+// mremap is only declared with _GNU_SOURCE
+#ifndef MREMAP_MAYMOVE
+#define MREMAP_MAYMOVE 1
+void*
+mremap(void* old_address, size_t old_size, size_t new_size, int flags, ...);
+#endif // not MREMAP_MAYMOVE
+
+// size of the mapping behind a mapped array of `size` bytes
+static size_t
+HH__darrmapsize(size_t size) {
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+#endif // __linux__ && HH_DARR_MMAP_THRESHOLD > 0
+
+// capacity after growing once from cap
+static size_t
+HH__darrnextcap(size_t cap, size_t elem_size) {
+#if HH_DARR_GROWTH_LIMIT > 0
+    if(cap * elem_size >= (size_t) HH_DARR_GROWTH_LIMIT) return cap + HH_MAX((size_t) HH_DARR_GROWTH_LIMIT / elem_size, 1);
+#else
+    (void) elem_size;
+#endif // HH_DARR_GROWTH_LIMIT > 0
+    size_t next = (size_t) ((double) cap * HH_DARR_GROWTH_FACTOR);
+    return HH_MAX(next, cap + 1);
+}
+
+// size of the block behind an array, aligned arrays get room to move the header forward
+static size_t
+HH__darrsize(size_t cap, size_t elem_size, size_t align) {
+    return sizeof(hh_darrheader_t) + cap * elem_size + ((align > 0) ? align - 1 : 0);
+}
+
+// offset of the header in a block, so that the elements that follow it are aligned
+static size_t
+HH__darralignoff(const void* block, size_t align) {
+    if(align == 0) return 0;
+    return (align - ((uintptr_t) block + sizeof(hh_darrheader_t)) % align) % align;
+}
+
+// moves the array into a block with room for (at least) cap elements
+static void
+HH__darrresize(void** arr_ptr, size_t cap) {
+    hh_darrheader_t* arr_hdr = hh_darrheader(*arr_ptr);
+    size_t elem_size = arr_hdr->elem_size;
+    size_t align = HH__darralign(arr_hdr);
+    // the header and the elements, which move together
+    size_t used = sizeof(hh_darrheader_t) + arr_hdr->len * elem_size;
+    char* block = (char*) arr_hdr - arr_hdr->offset;
+    size_t off;
+    if(arr_hdr->flags & HH__DARR_UNOWNED) {
+        // an inline buffer never shrinks, growing copies the array into a block of its own
+        if(cap <= arr_hdr->cap) return;
+        if(arr_hdr->alloc == NULL) arr_hdr->alloc = HH__allocator_global;
+        block = HH__alloc(arr_hdr->alloc, HH__darrsize(cap, elem_size, align), "HH__darrgrow");
+        memcpy(block, arr_hdr, used);
+        arr_hdr = (hh_darrheader_t*) block;
+        arr_hdr->flags &= ~(size_t) HH__DARR_UNOWNED;
+        arr_hdr->offset = 0;
+        arr_hdr->cap = cap;
+        *arr_ptr = (void*) (arr_hdr + 1);
+        return;
+    }
+#ifdef HH__DARR_MMAP
+    // only arrays on the default allocator are moved into mappings
+    if((arr_hdr->flags & HH__DARR_MAPPED) || (arr_hdr->alloc == &hh_allocator_checked && 
+        HH__darrsize(cap, elem_size, align) >= (size_t) HH_DARR_MMAP_THRESHOLD)) {
+        size_t size = HH__darrmapsize(HH__darrsize(cap, elem_size, align));
+        char* ptr;
+        if(arr_hdr->flags & HH__DARR_MAPPED) {
+            // the kernel moves the pages, the elements aren't copied
+            off = arr_hdr->offset;
+            ptr = mremap(block, HH__darrmapsize(HH__darrsize(arr_hdr->cap, elem_size, align)), size, MREMAP_MAYMOVE);
+        } else {
+            ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            off = 0;
+            if(ptr != MAP_FAILED) {
+                memcpy(ptr, arr_hdr, used);
+                HH__release(arr_hdr->alloc, block, HH__darrsize(arr_hdr->cap, elem_size, align));
+            }
+        }
+        HH_ASSERT(ptr != MAP_FAILED, "HH__darrgrow failed to map array");
+        block = ptr;
+        arr_hdr = (hh_darrheader_t*) (block + off);
+        arr_hdr->flags |= HH__DARR_MAPPED;
+    } else 
+#endif // HH__DARR_MMAP
+    {
+        off = arr_hdr->offset;
+        block = HH__resize(arr_hdr->alloc, block, HH__darrsize(arr_hdr->cap, elem_size, align), 
+            HH__darrsize(cap, elem_size, align), "HH__darrgrow");
+        arr_hdr = (hh_darrheader_t*) (block + off);
+    }
+    // the new block may be aligned differently, then the array is moved within it
+    size_t aligned = HH__darralignoff(block, align);
+    if(aligned != off) {
+        memmove(block + aligned, block + off, used);
+        arr_hdr = (hh_darrheader_t*) (block + aligned);
+        arr_hdr->offset = aligned;
+    }
+    arr_hdr->cap = cap;
+    *arr_ptr = (void*) (arr_hdr + 1);
+}
+
 void 
 HH__darrgrow(void** arr_ptr, size_t n, size_t elem_size) {
     HH_ASSERT_INVARIANT(arr_ptr != NULL);
     HH_ASSERT_INVARIANT(elem_size > 0);
     hh_darrheader_t* arr_hdr;
     if(*arr_ptr == NULL) {
-        arr_hdr = calloc(1, sizeof(hh_darrheader_t) + elem_size * HH_MAX(n, HH_DARR_INITIAL_CAPACITY));
-        HH_ASSERT(arr_hdr != NULL, "HH__darrgrow failed to allocate array");
-        arr_hdr->len = 0;
-        arr_hdr->cap = HH_MAX(n, HH_DARR_INITIAL_CAPACITY);
-        arr_hdr->elem_size = elem_size;
-        *arr_ptr = (void*) (arr_hdr + 1);
+        HH__darrinit(arr_ptr, elem_size, NULL, 0);
+        if(n > HH_DARR_INITIAL_CAPACITY) HH__darrresize(arr_ptr, n);
         return;
     }
     arr_hdr = hh_darrheader(*arr_ptr);
     if(arr_hdr->len + n < arr_hdr->cap) return;
-    while(arr_hdr->len + n >= arr_hdr->cap) arr_hdr->cap *= 2;
-    arr_hdr = realloc(arr_hdr, sizeof(hh_darrheader_t) + arr_hdr->cap * arr_hdr->elem_size);
-    HH_ASSERT(arr_hdr != NULL, "HH__darrgrow failed to allocate array");
+    size_t cap = arr_hdr->cap;
+    while(arr_hdr->len + n >= cap) cap = HH__darrnextcap(cap, elem_size);
+    HH__darrresize(arr_ptr, cap);
+}
+
+void
+HH__darrreserve(void** arr_ptr, size_t n, size_t elem_size) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    if(*arr_ptr == NULL) HH__darrgrow(arr_ptr, 0, elem_size);
+    // growing checks len + n >= cap, so n elements need a capacity of n + 1
+    if(n >= hh_darrheader(*arr_ptr)->cap) HH__darrresize(arr_ptr, n + 1);
+}
+
+void
+HH__darrshrink(void** arr_ptr) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    if(*arr_ptr == NULL) return;
+    hh_darrheader_t* arr_hdr = hh_darrheader(*arr_ptr);
+    if(arr_hdr->cap > arr_hdr->len) HH__darrresize(arr_ptr, arr_hdr->len);
+}
+
+void
+HH__darrfree(void* arr) {
+    if(arr == NULL) return;
+    hh_darrheader_t* arr_hdr = hh_darrheader(arr);
+    if(arr_hdr->flags & HH__DARR_UNOWNED) return;
+    char* block = (char*) arr_hdr - arr_hdr->offset;
+    size_t size = HH__darrsize(arr_hdr->cap, arr_hdr->elem_size, HH__darralign(arr_hdr));
+#ifdef HH__DARR_MMAP
+    if(arr_hdr->flags & HH__DARR_MAPPED) {
+        munmap(block, HH__darrmapsize(size));
+        return;
+    }
+#endif // HH__DARR_MMAP
+    HH__release(arr_hdr->alloc, block, size);
+}
+
+void
+HH__darrinit(void** arr_ptr, size_t elem_size, const hh_allocator_t* alloc, size_t align) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    HH_ASSERT_INVARIANT(elem_size > 0);
+    HH_ASSERT(*arr_ptr == NULL, "hh_darrinit requires an empty (NULL) array");
+    HH_ASSERT((align & (align - 1)) == 0, "hh_darrinit_aligned requires a power of two: %zu", align);
+    if(alloc == NULL) alloc = HH__allocator_global;
+    char* block = HH__alloc(alloc, HH__darrsize(HH_DARR_INITIAL_CAPACITY, elem_size, align), "HH__darrgrow");
+    hh_darrheader_t* arr_hdr = (hh_darrheader_t*) (block + HH__darralignoff(block, align));
+    arr_hdr->len = 0;
+    arr_hdr->cap = HH_DARR_INITIAL_CAPACITY;
+    arr_hdr->elem_size = elem_size;
+    arr_hdr->flags = align << HH__DARR_ALIGN_SHIFT;
+    arr_hdr->alloc = alloc;
+    arr_hdr->offset = (size_t) ((char*) arr_hdr - block);
     *arr_ptr = (void*) (arr_hdr + 1);
 }
 
 size_t
 HH__darraddn(void** arr_ptr, size_t n, size_t elem_size) {
+    size_t len = HH__darradd_uninit(arr_ptr, n, elem_size);
+    if(n > 0) memset((char*) (*arr_ptr) + len * elem_size, 0, elem_size * n);
+    return len;
+}
+
+size_t
+HH__darradd_uninit(void** arr_ptr, size_t n, size_t elem_size) {
     HH__darrgrow(arr_ptr, n, elem_size);
-    size_t len = hh_darrlen(*arr_ptr);
-    if(n > 0) {
-        memset((char*) (*arr_ptr) + len * elem_size, 0, elem_size * n);
-        hh_darrheader(*arr_ptr)->len = len + n;
-    }
+    hh_darrheader_t* arr_hdr = hh_darrheader(*arr_ptr);
+    size_t len = arr_hdr->len;
+    arr_hdr->len = len + n;
     return len;
 }
 
+// byte offset of ptr in the array's elements, SIZE_MAX if it points elsewhere
+// growing moves the array, so sources inside of it are found again through the offset
+static size_t
+HH__darroffset(const void* arr, const void* ptr) {
+    if(arr == NULL || ptr == NULL) return SIZE_MAX;
+    const hh_darrheader_t* arr_hdr = hh_darrheader(arr);
+    uintptr_t off = (uintptr_t) ptr - (uintptr_t) arr;
+    return ((uintptr_t) ptr >= (uintptr_t) arr && off < arr_hdr->len * arr_hdr->elem_size) ? (size_t) off : SIZE_MAX;
+}
+
+size_t
+HH__darrputn(void** arr_ptr, const void* src, size_t n, size_t elem_size) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    HH_ASSERT(src != NULL || n == 0, "hh_darrputn received NULL");
+    size_t off = HH__darroffset(*arr_ptr, src);
+    size_t idx = HH__darradd_uninit(arr_ptr, n, elem_size);
+    if(off != SIZE_MAX) src = (char*) (*arr_ptr) + off;
+    if(n > 0) memcpy((char*) (*arr_ptr) + idx * elem_size, src, n * elem_size);
+    return idx;
+}
+
+size_t
+HH__darrinsertn(void** arr_ptr, size_t i, const void* src, size_t n, size_t elem_size) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    size_t len = hh_darrlen(*arr_ptr);
+    HH_ASSERT(i <= len, "hh_darrinsertn received an out-of-bounds index: %zu", i);
+    size_t off = HH__darroffset(*arr_ptr, src);
+    HH__darradd_uninit(arr_ptr, n, elem_size);
+    char* arr = *arr_ptr;
+    char* dst = arr + i * elem_size;
+    size_t size = n * elem_size;
+    memmove(dst + size, dst, (len - i) * elem_size);
+    if(off != SIZE_MAX) {
+        // the part of the source past the gap was moved along with the tail
+        size_t head = (off < i * elem_size) ? HH_MIN(i * elem_size - off, size) : 0;
+        memcpy(dst, arr + off, head);
+        memcpy(dst + head, arr + off + head + size, size - head);
+    } else if(src != NULL) memcpy(dst, src, size);
+    else memset(dst, 0, size);
+    return i;
+}
+
+void
+HH__darrerasen(void* arr, size_t i, size_t n) {
+    if(n == 0) return;
+    size_t len = hh_darrlen(arr);
+    HH_ASSERT(i <= len && n <= len - i, "hh_darrerasen received an out-of-bounds range: [%zu, %zu)", i, i + n);
+    size_t elem_size = hh_darrheader(arr)->elem_size;
+    char* dst = (char*) arr + i * elem_size;
+    memmove(dst, dst + n * elem_size, (len - i - n) * elem_size);
+    hh_darrheader(arr)->len = len - n;
+}
+
 char*
 HH__darrputstr(void** arr_ptr, const char* str) {
     HH_ASSERT_INVARIANT(arr_ptr != NULL);
@@ -817,7 +2572,7 @@ HH__darrputstr(void** arr_ptr, const char* str) {
     size_t n = 0;
     if(hh_darrlen(*arr_ptr) == 0) n = 1;
     else if((hh_darrlen(*arr_ptr) != 0 && (((char**) arr_ptr)[0] + hh_darrlen(*arr_ptr) - 1)[0] != '\0')) n = 1;
-    size_t idx = HH__darraddn(arr_ptr, ((str == NULL) ? 0 : strlen(str)) + n, 1);
+    size_t idx = HH__darradd_uninit(arr_ptr, ((str == NULL) ? 0 : strlen(str)) + n, 1);
     HH_ASSERT((n == 0 && idx > 0) || n > 0);
     if(str == NULL && n > 0) ((char**) arr_ptr)[0][idx] = '\0';
     else strcpy(((char**) arr_ptr)[0] + (idx -= (n == 0)), (str));
@@ -833,7 +2588,7 @@ HH__darrputstrn(void** arr_ptr, const char* str, size_t n) {
         (void) hh_darrpop(((char**) arr_ptr)[0]);
     }
     size_t len = hh_strnlen(str, n);
-    size_t off = hh_darradd(((char**) arr_ptr)[0], n);
+    size_t off = hh_darradd_uninit(((char**) arr_ptr)[0], n);
     memcpy(((char**) arr_ptr)[0] + off, str, len);
     if(len < n) memset(((char**) arr_ptr)[0] + off + len, '\0', n - len);
     hh_darrlast(((char**) arr_ptr)[0]) = '\0';
@@ -858,25 +2613,29 @@ HH__darrswap(void* arr, size_t i, size_t j) {
 
 void*
 hh_arena_alloc(hh_arena* arena, size_t sz) {
-    // if this is the first allocation
-    if(arena->ptr == NULL) {
+    if(arena->alloc == NULL) arena->alloc = HH__allocator_global;
+    // earlier segments are never revisited, their leftover space is given up
+    hh_arena* seg = (arena->tail == NULL) ? arena : arena->tail;
+    // move on while the requested allocation doesn't fit in the current segment
+    // (only segments kept by hh_arena_reset are skipped, new ones are made large enough)
+    while(seg->ptr != NULL && (size_t) (seg->end - seg->cur) < sz) {
+        if(seg->next == NULL) {
+            seg->next = HH__alloc(arena->alloc, sizeof(hh_arena), "hh_arena_alloc");
+            seg->next->alloc = arena->alloc;
+        }
+        seg = seg->next;
+    }
+    // first allocation in this segment
+    if(seg->ptr == NULL) {
         size_t sz_align = (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
         size_t sz_alloc = HH_MAX(HH_ARENA_DEFAULT_SIZE, sz_align);
-        arena->ptr = malloc(sz_alloc);
-        if(arena->ptr == NULL) return NULL;
-        arena->end = arena->ptr + sz_alloc;
-        arena->cur = arena->ptr + sz;
-        return arena->ptr;
-    }
-    // if the requested allocation size is too small to fit in the current segment
-    if((size_t) (arena->end - arena->cur) < sz) {
-        if(arena->next == NULL) arena->next = calloc(1, sizeof(hh_arena));
-        if(arena->next == NULL) return NULL;
-        return hh_arena_alloc(arena->next, sz);
-    }
-    // otherwise, fill in the space in this segment
-    void* ptr = arena->cur;
-    arena->cur += sz;
+        seg->ptr = HH__alloc(arena->alloc, sz_alloc, "hh_arena_alloc");
+        seg->end = seg->ptr + sz_alloc;
+        seg->cur = seg->ptr;
+    }
+    arena->tail = seg;
+    void* ptr = seg->cur;
+    seg->cur += sz;
     return ptr;
 }
 
@@ -885,12 +2644,81 @@ hh_arena_free(hh_arena* arena) {
     if(arena == NULL) return;
     if(arena->next != NULL) {
         hh_arena_free(arena->next);
-        free(arena->next);
+        HH__release(arena->alloc, arena->next, sizeof(hh_arena));
     }
-    free(arena->ptr);
+    HH__release(arena->alloc, arena->ptr, (size_t) (arena->end - arena->ptr));
     memset(arena, 0, sizeof(hh_arena));
 }
 
+void
+hh_arena_reset(hh_arena* arena) {
+    if(arena != NULL) arena->tail = NULL;
+    for(; arena != NULL && arena->ptr != NULL; arena = arena->next) {
+        // allocations are zero-initialized, so the used part is cleared again
+        memset(arena->ptr, 0, (size_t) (arena->cur - arena->ptr));
+        arena->cur = arena->ptr;
+    }
+}
+
+// alignment of the blocks handed out by hh_arena_allocator
+#define HH__ARENA_ALIGN 16
+
+static void*
+HH__arena_allocator_alloc(void* ctx, size_t size) {
+    hh_arena* arena = ctx;
+    // align the block within the current segment if it has room for it,
+    // otherwise it goes into a later one, which is aligned as far as its allocator aligns blocks
+    hh_arena* seg = (arena->tail == NULL) ? arena : arena->tail;
+    if(seg->ptr != NULL) {
+        size_t pad = (size_t) (-(uintptr_t) seg->cur) & (HH__ARENA_ALIGN - 1);
+        if((size_t) (seg->end - seg->cur) >= pad + size) seg->cur += pad;
+    }
+    return hh_arena_alloc(arena, size);
+}
+
+// returns the segment holding the most recent block if it is `ptr`, NULL otherwise
+static hh_arena*
+HH__arena_allocator_last(hh_arena* arena, char* ptr, size_t size) {
+    hh_arena* seg = (arena->tail == NULL) ? arena : arena->tail;
+    if(seg->ptr == NULL || ptr < seg->ptr || ptr > seg->end) return NULL;
+    return (ptr + size == seg->cur) ? seg : NULL;
+}
+
+static void*
+HH__arena_allocator_resize(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    hh_arena* last = HH__arena_allocator_last(ctx, ptr, old_size);
+    if(last != NULL && (size_t) (last->end - (char*) ptr) >= new_size) {
+        // the bytes given back must be zero for later allocations
+        if(new_size < old_size) memset((char*) ptr + new_size, 0, old_size - new_size);
+        last->cur = (char*) ptr + new_size;
+        return ptr;
+    }
+    if(new_size <= old_size) return ptr;
+    void* copy = HH__arena_allocator_alloc(ctx, new_size);
+    memcpy(copy, ptr, old_size);
+    return copy;
+}
+
+static void
+HH__arena_allocator_release(void* ctx, void* ptr, size_t size) {
+    // only the most recent block can be given back
+    hh_arena* last = HH__arena_allocator_last(ctx, ptr, size);
+    if(last == NULL) return;
+    memset(ptr, 0, size);
+    last->cur = ptr;
+}
+
+hh_allocator_t
+hh_arena_allocator(hh_arena* arena) {
+    HH_ASSERT_INVARIANT(arena != NULL);
+    return (hh_allocator_t) {
+        .alloc = HH__arena_allocator_alloc,
+        .resize = HH__arena_allocator_resize,
+        .release = HH__arena_allocator_release,
+        .ctx = arena,
+    };
+}
+
 char* 
 hh_path_alloc(const char *raw) {
     char* path = NULL;
@@ -1059,17 +2887,101 @@ hh_timer_duration(hh_timer_t timer) {
 }
 
 size_t
-hh_hash_djb2(const void* ptr, size_t sz) {
-    size_t hash = 5381;
-    for(size_t i = 0; i < sz; ++i) hash = ((hash << 5) + hash) + (size_t) ((char*) ptr)[i];
+hh_hash_djb2(const void* ptr, size_t sz, size_t seed) {
+    size_t hash = 5381 ^ seed;
+    for(size_t i = 0; i < sz; ++i) hash = ((hash << 5) + hash) + (size_t) ((const unsigned char*) ptr)[i];
     return hash;
 }
 
+// Adapted from...
+// wyhash (final version) - public domain - Wang Yi
+// restructured so every 16-byte block is consumed in order
+
+// the mixing primitives live with the hmap internals, see HH__hmapwordhash
+// little-endian loads, so hashes don't depend on the platform's byte order
+static inline uint64_t
+HH__hashle(uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(v);
+#else
+    return v;
+#endif
+}
+
+static inline uint64_t
+HH__hashread(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return HH__hashle(v);
+}
+
+static inline uint64_t
+HH__hashread32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+// reads n < 8 bytes as a zero-padded little-endian word
+static inline uint64_t
+HH__hashreadpartial(const unsigned char* p, size_t n) {
+    if(n >= 4) return HH__hashread32(p) | (HH__hashread32(p + n - 4) << (8 * (n - 4)));
+    if(n > 0) return (uint64_t) p[0] | ((uint64_t) p[n >> 1] << (8 * (n >> 1))) | ((uint64_t) p[n - 1] << (8 * (n - 1)));
+    return 0;
+}
+
+static inline uint64_t
+HH__hashinit(size_t seed) {
+    return (uint64_t) seed ^ HH__hashmix((uint64_t) seed ^ HH__HASH_SECRET[0], HH__HASH_SECRET[1]);
+}
+
+static inline uint64_t
+HH__hashblock(uint64_t state, uint64_t fst, uint64_t snd) {
+    return HH__hashmix(fst ^ HH__HASH_SECRET[1], snd ^ state);
+}
+
+// a and b hold the final (possibly partial) 16 bytes
+static inline size_t
+HH__hashfinal(uint64_t state, uint64_t a, uint64_t b, size_t len) {
+    a ^= HH__HASH_SECRET[1];
+    b ^= state;
+    HH__hashmum(&a, &b);
+    return (size_t) HH__hashmix(a ^ HH__HASH_SECRET[0] ^ (uint64_t) len, b ^ HH__HASH_SECRET[1]);
+}
+
+size_t
+hh_hash_wide(const void* ptr, size_t sz, size_t seed) {
+    const unsigned char* p = ptr;
+    uint64_t state = HH__hashinit(seed);
+    size_t n = sz;
+    for(; n >= 32; n -= 32, p += 32) {
+        state = HH__hashblock(state, HH__hashread(p), HH__hashread(p + 8));
+        state = HH__hashblock(state, HH__hashread(p + 16), HH__hashread(p + 24));
+    }
+    if(n >= 16) {
+        state = HH__hashblock(state, HH__hashread(p), HH__hashread(p + 8));
+        n -= 16;
+        p += 16;
+    }
+    uint64_t a = (n >= 8) ? HH__hashread(p) : HH__hashreadpartial(p, n);
+    uint64_t b = (n > 8) ? HH__hashreadpartial(p + 8, n - 8) : 0;
+    return HH__hashfinal(state, a, b, sz);
+}
+
+// measures the string first, a single pass that stays within it (checking bytes one at a time,
+// or memchr over fixed chunks) was slower than the vectorized strlen at every length
+size_t
+hh_hash_wide_str(const char* str, size_t seed) {
+    return hh_hash_wide(str, strlen(str), seed);
+}
+
 size_t
-hh_hash_cstr(const void* ptr, size_t sz) {
+hh_hash_cstr(const void* ptr, size_t sz, size_t seed) {
     (void) sz;
-    const char* str = *((const char**) ptr);
-    return hh_hash_djb2(str, strlen(str));
+    return hh_hash_wide_str(*((const char**) ptr), seed);
 }
 
 int
@@ -1092,101 +3004,869 @@ hh_copy_cstr(void* dst, const void* ptr, size_t sz) {
     memcpy(dst, str, len_name);
 }
 
+void
+hh_bloom_reserve(hh_bloom_t* bloom, size_t n, double fpr) {
+    HH_ASSERT_INVARIANT(bloom != NULL);
+    HH_ASSERT(fpr > 0.0 && fpr < 1.0, "hh_bloom_reserve requires 0 < fpr < 1");
+    // log2(1 / fpr), the fractional part is approximated linearly
+    double lg = 0.0, x = 1.0 / fpr;
+    for(; x >= 2.0; x /= 2.0) lg += 1.0;
+    lg += x - 1.0;
+    // 1.44 * lg bits per hash is optimal for a classic Bloom filter,
+    // confining the bits to a block costs roughly another 15%
+    double bits = (double) HH_MAX(n, (size_t) 1) * 1.44 * lg * 1.15;
+    size_t block_count = (size_t) (bits / (HH__BLOOM_WORDS * 64)) + 1;
+    HH_ASSERT(block_count <= UINT32_MAX, "hh_bloom_reserve received too many hashes");
+    size_t size = block_count * HH__BLOOM_WORDS * sizeof(uint64_t);
+    if(block_count != bloom->block_count) {
+        if(bloom->alloc == NULL) bloom->alloc = HH__allocator_global;
+        HH__release(bloom->alloc, bloom->mem, bloom->block_count * HH__BLOOM_WORDS * sizeof(uint64_t) + 64);
+        // one spare cache line to align the blocks
+        bloom->mem = HH__alloc(bloom->alloc, size + 64, "hh_bloom_reserve");
+        bloom->blocks = (uint64_t*) (((uintptr_t) bloom->mem + 63) & ~(uintptr_t) 63);
+        bloom->block_count = block_count;
+    }
+    memset(bloom->blocks, 0, size);
+    bloom->k = (unsigned) HH_MIN(HH_MAX(lg + 0.5, 1.0), 16.0);
+    bloom->count = 0;
+    bloom->capacity = n;
+    bloom->fpr = fpr;
+}
+
+void
+hh_bloom_add(hh_bloom_t* bloom, size_t hash) {
+    HH_ASSERT_INVARIANT(bloom != NULL);
+    HH_ASSERT(bloom->blocks != NULL, "hh_bloom_add requires a filter sized by hh_bloom_reserve");
+    // must mirror hh_bloom_has
+    uint64_t h = HH__mix64((uint64_t) hash);
+    uint64_t* block = bloom->blocks + (((h >> 32) * bloom->block_count) >> 32) * HH__BLOOM_WORDS;
+    for(unsigned i = 0; i < bloom->k; ++i) {
+        h = h * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+        block[h >> 61] |= 1ULL << ((h >> 55) & 63u);
+    }
+    ++(bloom->count);
+}
+
+void
+hh_bloom_free(hh_bloom_t* bloom) {
+    if(bloom == NULL) return;
+    HH__release(bloom->alloc, bloom->mem, bloom->block_count * HH__BLOOM_WORDS * sizeof(uint64_t) + 64);
+    memset(bloom, 0, sizeof(hh_bloom_t));
+}
+
+// moves a map loaded by hh_hmapload_mapped to the heap, returns its new header
+static hh_hmapheader_t* HH__hmapdetach(void** map_ptr);
+
 static inline void*
 HH__hmapgrow(void** map_ptr, size_t n) {
     HH_ASSERT_INVARIANT(map_ptr != NULL);
     hh_hmapheader_t* map_hdr = hh_hmapheader(map_ptr[0]);
+    // checked in every build, growing a mapped map in place would resize memory the allocator doesn't own
+    if(map_hdr->mapped) map_hdr = HH__hmapdetach(map_ptr);
     if(map_hdr->len + n < map_hdr->cap) return map_hdr;
-    while(map_hdr->len + n >= map_hdr->cap) map_hdr->cap *= 2;
-    map_hdr = realloc(map_hdr, sizeof(hh_hmapheader_t) + map_hdr->cap * map_hdr->prop.sz_entry);
-    HH_ASSERT(map_hdr != NULL, "hmapgrow failed to allocate");
+    // index slots hold 32-bit entry indices
+    HH_ASSERT(map_hdr->len + n < UINT32_MAX, "hh_hmap can't hold %zu entries", map_hdr->len + n);
+    size_t cap = map_hdr->cap;
+    while(map_hdr->len + n >= cap) cap *= 2;
+    const hh_allocator_t* alloc = map_hdr->opt.alloc;
+    map_hdr = HH__resize(alloc, map_hdr, sizeof(hh_hmapheader_t) + map_hdr->cap * map_hdr->prop.sz_entry, 
+        sizeof(hh_hmapheader_t) + cap * map_hdr->prop.sz_entry, "hmapgrow");
+    map_hdr->hashes = HH__resize(alloc, map_hdr->hashes, map_hdr->cap * sizeof(size_t), cap * sizeof(size_t), "hmapgrow");
+    map_hdr->pos = HH__resize(alloc, map_hdr->pos, map_hdr->cap * sizeof(size_t), cap * sizeof(size_t), "hmapgrow");
+    map_hdr->cap = cap;
     *map_ptr = (void*) (map_hdr + 1);
     return map_hdr;
 }
 
+// picks a default per-map seed
+// not cryptographically secure, but unpredictable enough to spread attacker-chosen keys
+static size_t
+HH__hmapseed(const void* addr) {
+#ifdef HH_HMAP_SEED
+    (void) addr;
+    return (size_t) HH_HMAP_SEED;
+#else
+    static uint64_t counter = 0;
+    uint64_t entropy = (uint64_t) time(NULL) ^ ((uint64_t) clock() << 32);
+    entropy ^= (uint64_t) (uintptr_t) addr ^ ((uint64_t) (uintptr_t) &counter << 16);
+    size_t seed = (size_t) HH__hashmix(entropy ^ HH__HASH_SECRET[0], ++counter ^ HH__HASH_SECRET[1]);
+    return (seed == 0) ? 1 : seed;
+#endif // not HH_HMAP_SEED
+}
+
+// (re)allocates the HH_HMAP_FLAT index with the given number of slots
+// every entry currently in the map is re-inserted
+static void HH__hmapflatresize(hh_hmapheader_t* map_hdr, size_t slot_count);
+
+// rebuilds the filter with room for n entries from the cached hashes,
+// which also drops the hashes of removed entries
+static void
+HH__hmapfilter(hh_hmapheader_t* map_hdr, size_t n) {
+    hh_bloom_reserve(&(map_hdr->filter), HH_MAX(n, (size_t) HH_BUCKET_COUNT), map_hdr->opt.filter_fpr);
+    for(size_t i = 0; i < map_hdr->len; ++i) hh_bloom_add(&(map_hdr->filter), map_hdr->hashes[i]);
+}
+
+// enables the inline paths for word keys, once the seed and key functions are known
+static void
+HH__hmapwordinit(hh_hmapheader_t* map_hdr) {
+    size_t sz = map_hdr->prop.sz_key;
+    _Bool word = sz == 1 || sz == 2 || sz == 4 || sz == 8;
+    map_hdr->word_key = (word && map_hdr->opt.key_f.comp == memcmp) ? sz : 0;
+    map_hdr->word_hash = word && map_hdr->opt.key_f.hash == hh_hash_wide;
+    map_hdr->word_state = HH__hashinit(map_hdr->opt.seed);
+}
+
 hh_hmapheader_t*
 HH__hmapconfig(void** map_ptr, hh_hmapprop_t prop, hh_hmap_opt opt) {
     size_t cap = (opt.reserve > 0) ? opt.reserve : HH_DARR_INITIAL_CAPACITY;
     size_t size = sizeof(hh_hmapheader_t) + prop.sz_entry * cap;
-    hh_hmapheader_t* map_hdr = calloc(1, size);
-    HH_ASSERT(map_hdr != NULL, "hmapinsert failed to allocate");
+    if(opt.alloc == NULL) opt.alloc = HH__allocator_global;
+    hh_hmapheader_t* map_hdr = HH__alloc(opt.alloc, size, "hmapinsert");
     map_hdr->prop = prop;
     map_hdr->opt = opt;
-    if(opt.key_f.hash == NULL) map_hdr->opt.key_f.hash = hh_hash_djb2;
+    map_hdr->filter.alloc = opt.alloc;
+    if(opt.key_f.hash == NULL) map_hdr->opt.key_f.hash = hh_hash_wide;
+    if(opt.seed == 0) map_hdr->opt.seed = HH__hmapseed(map_hdr);
     if(opt.key_f.comp == NULL) map_hdr->opt.key_f.comp = memcmp;
+    HH__hmapwordinit(map_hdr);
+    if(opt.max_load <= 0.0) map_hdr->opt.max_load = (opt.layout == HH_HMAP_FLAT) ? \
+        HH_HMAP_FLAT_MAX_LOAD : HH_HMAP_MAX_LOAD;
     map_hdr->cap = cap;
     map_hdr->last = SIZE_MAX;
-    if(opt.bucket_count == 0) map_hdr->opt.bucket_count = HH_BUCKET_COUNT;
-    map_hdr->buckets = calloc(map_hdr->opt.bucket_count, sizeof(size_t*));
-    HH_ASSERT(map_hdr != NULL, "hmapinsert failed to allocate");
+    map_hdr->hashes = HH__alloc(opt.alloc, cap * sizeof(size_t), "hmapinsert");
+    map_hdr->pos = HH__alloc(opt.alloc, cap * sizeof(size_t), "hmapinsert");
     map_ptr[0] = (void*) (map_hdr + 1);
+    if(opt.filter_fpr > 0.0) HH__hmapfilter(map_hdr, opt.reserve);
+    if(opt.layout == HH_HMAP_FLAT) {
+        HH_ASSERT(map_hdr->opt.max_load < 1.0, "HH_HMAP_FLAT requires a max_load below 1.0");
+        // slot count is a power of two that fits `reserve` entries without resizing
+        size_t slot_count = HH__HMAP_GROUP;
+        while(slot_count < opt.bucket_count || 
+            (double) slot_count * map_hdr->opt.max_load < (double) opt.reserve) slot_count *= 2;
+        HH__hmapflatresize(map_hdr, slot_count);
+        return map_hdr;
+    }
+    // size the table so that `reserve` entries fit without rehashing
+    if(opt.bucket_count == 0) {
+        map_hdr->opt.bucket_count = HH_BUCKET_COUNT;
+        while((double) map_hdr->opt.bucket_count * map_hdr->opt.max_load < (double) opt.reserve)
+            map_hdr->opt.bucket_count *= 2;
+    }
+    map_hdr->bucket_count = map_hdr->opt.bucket_count;
+    map_hdr->buckets = HH__alloc(opt.alloc, map_hdr->bucket_count * sizeof(hh_hmapslot_t*), "hmapinsert");
     return map_hdr;
 }
 
-static inline size_t
-HH__hmapbucketindex(const hh_hmapheader_t* map_hdr, const void* ptr) {
-    return (map_hdr->opt.key_f.hash)(ptr, map_hdr->prop.sz_key) % map_hdr->opt.bucket_count;
+// migrates up to `steps` old buckets into the new table
+// passing SIZE_MAX finishes the rehash
+static void
+HH__hmaprehashstep(const void* map, size_t steps) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    hh_hmapslot_t* bucket;
+    hh_hmapslot_t** dst;
+    while(map_hdr->buckets_old != NULL && steps-- > 0) {
+        bucket = map_hdr->buckets_old[map_hdr->rehash];
+        for(size_t i = 0; i < hh_darrlen(bucket); ++i) {
+            dst = &(map_hdr->buckets[HH__hmapbucketidx(map_hdr->hashes[bucket[i].idx], map_hdr->bucket_count)]);
+            map_hdr->pos[bucket[i].idx] = hh_darrlen(*dst);
+            if(*dst == NULL) hh_darrinit(*dst, map_hdr->opt.alloc);
+            hh_darrput(*dst, bucket[i]);
+        }
+        hh_darrfree(bucket);
+        map_hdr->buckets_old[map_hdr->rehash] = NULL;
+        if(++(map_hdr->rehash) == map_hdr->bucket_count_old) {
+            HH__release(map_hdr->opt.alloc, map_hdr->buckets_old, map_hdr->bucket_count_old * sizeof(hh_hmapslot_t*));
+            map_hdr->buckets_old = NULL;
+            map_hdr->bucket_count_old = 0;
+            map_hdr->rehash = 0;
+        }
+    }
 }
 
-static inline size_t*
-HH__hmapbucket(const hh_hmapheader_t* map_hdr, const void* ptr) {
-    return map_hdr->buckets[HH__hmapbucketindex(map_hdr, ptr)];
+// advances any rehash in progress and starts a new one once the load factor is exceeded
+// HH_HMAP_FLAT resizes all at once in HH__hmaplink instead
+static void
+HH__hmaprehash(const void* map) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) return;
+    HH__hmaprehashstep(map, HH_HMAP_REHASH_STEP);
+    if((double) map_hdr->len <= (double) map_hdr->bucket_count * map_hdr->opt.max_load) return;
+    // the previous rehash must be complete before the table is doubled again
+    HH__hmaprehashstep(map, SIZE_MAX);
+    HH__HMAP_COUNT(map_hdr, rehashes);
+    map_hdr->buckets_old = map_hdr->buckets;
+    map_hdr->bucket_count_old = map_hdr->bucket_count;
+    map_hdr->rehash = 0;
+    map_hdr->bucket_count *= 2;
+    map_hdr->buckets = HH__alloc(map_hdr->opt.alloc, map_hdr->bucket_count * sizeof(hh_hmapslot_t*), "hmaprehash");
+    HH__hmaprehashstep(map, HH_HMAP_REHASH_STEP);
 }
 
-_Bool
-HH__hmapinsert(void** map_ptr, hh_hmapprop_t prop, const void* key) {
-    HH_ASSERT_INVARIANT(map_ptr != NULL);
-    hh_hmapheader_t* map_hdr = (map_ptr[0] == NULL) ? \
-        HH__hmapconfig(map_ptr, prop, (hh_hmap_opt) {0}) : \
-        hh_hmapheader(map_ptr[0]);
-    map_hdr = HH__hmapgrow(map_ptr, 1);
-    map_hdr->last = SIZE_MAX;
+// bitmask of the slots in a group that are empty or deleted (high bit set)
+static inline unsigned
+HH__hmapgroupfree(const unsigned char* group) {
+#if defined(HH__HMAP_SSE2)
+    return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+#elif defined(HH__HMAP_NEON)
+    static const uint8_t bits[HH__HMAP_GROUP] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t hi = vandq_u8(vshrq_n_u8(vld1q_u8(group), 7), vld1q_u8(bits));
+    return (unsigned) vaddv_u8(vget_low_u8(hi)) | ((unsigned) vaddv_u8(vget_high_u8(hi)) << 8);
+#else
+    unsigned mask = 0;
+    for(unsigned i = 0; i < HH__HMAP_GROUP; ++i) mask |= (unsigned) (group[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+static void
+HH__hmapflatlink(hh_hmapheader_t* map_hdr, size_t hash, size_t idx) {
+    size_t mix = HH__hmapmix(hash);
+    size_t mask = map_hdr->slot_count / HH__HMAP_GROUP - 1;
+    size_t group = (mix >> 7) & mask;
+    for(size_t step = 1;; group = (group + step++) & mask) {
+        unsigned avail = HH__hmapgroupfree(map_hdr->ctrl + group * HH__HMAP_GROUP);
+        if(avail == 0) continue;
+        size_t slot = group * HH__HMAP_GROUP + HH__ctz(avail);
+        if(map_hdr->ctrl[slot] == HH__HMAP_EMPTY) --(map_hdr->slot_free);
+        map_hdr->ctrl[slot] = (unsigned char) (mix & 0x7F);
+        map_hdr->slots[slot] = (hh_hmapslot_t) { .idx = (uint32_t) idx, .tag = HH__hmaptag(hash) };
+        map_hdr->pos[idx] = slot;
+        return;
+    }
+}
+
+static void
+HH__hmapflatresize(hh_hmapheader_t* map_hdr, size_t slot_count) {
+    // the initial allocation in HH__hmapconfig doesn't count as a rehash
+    if(map_hdr->ctrl != NULL) HH__HMAP_COUNT(map_hdr, rehashes);
+    HH__release(map_hdr->opt.alloc, map_hdr->ctrl, map_hdr->slot_count);
+    HH__release(map_hdr->opt.alloc, map_hdr->slots, map_hdr->slot_count * sizeof(hh_hmapslot_t));
+    map_hdr->ctrl = HH__alloc(map_hdr->opt.alloc, slot_count, "hmapflatresize");
+    map_hdr->slots = HH__alloc(map_hdr->opt.alloc, slot_count * sizeof(hh_hmapslot_t), "hmapflatresize");
+    memset(map_hdr->ctrl, HH__HMAP_EMPTY, slot_count);
+    map_hdr->slot_count = slot_count;
+    // at least one slot must remain empty for probing to terminate
+    map_hdr->slot_free = HH_MIN((size_t) ((double) slot_count * map_hdr->opt.max_load), slot_count - 1);
+    for(size_t i = 0; i < map_hdr->len; ++i) HH__hmapflatlink(map_hdr, map_hdr->hashes[i], i);
+}
+
+// adds entry `idx` to the index
+static void
+HH__hmaplink(const void* map, size_t hash, size_t idx) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    map_hdr->hashes[idx] = hash;
+    if(map_hdr->filter.blocks != NULL) {
+        // keep the false-positive rate by doubling the filter once it is full
+        if(map_hdr->filter.count >= map_hdr->filter.capacity) HH__hmapfilter(map_hdr, 2 * (map_hdr->len + 1));
+        hh_bloom_add(&(map_hdr->filter), hash);
+    }
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        if(map_hdr->slot_free == 0) {
+            // only grow if tombstones aren't the reason the table is full
+            size_t slot_count = map_hdr->slot_count;
+            if((double) map_hdr->len >= (double) slot_count * map_hdr->opt.max_load / 2.0) slot_count *= 2;
+            HH__hmapflatresize(map_hdr, slot_count);
+        }
+        HH__hmapflatlink(map_hdr, hash, idx);
+        return;
+    }
+    hh_hmapslot_t** bucket = HH__hmapbucketref(map_hdr, hash);
+    map_hdr->pos[idx] = hh_darrlen(*bucket);
+    if(*bucket == NULL) hh_darrinit(*bucket, map_hdr->opt.alloc);
+    hh_darrput(*bucket, ((hh_hmapslot_t) { .idx = (uint32_t) idx, .tag = HH__hmaptag(hash) }));
+}
+
+// removes entry `idx` from the index, located through its cached hash and position
+static void
+HH__hmapunlink(const void* map, size_t idx) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    size_t pos = map_hdr->pos[idx];
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        size_t slot = pos;
+        // probes stop at any group containing an empty slot,
+        // so no other key depends on this slot staying occupied
+        if(HH__hmapgroupmatch(map_hdr->ctrl + (slot & ~(size_t) (HH__HMAP_GROUP - 1)), HH__HMAP_EMPTY)) {
+            map_hdr->ctrl[slot] = HH__HMAP_EMPTY;
+            ++(map_hdr->slot_free);
+        } else map_hdr->ctrl[slot] = HH__HMAP_DELETED;
+        return;
+    }
+    hh_hmapslot_t* bucket = *HH__hmapbucketref(map_hdr, map_hdr->hashes[idx]);
+    HH_ASSERT_INVARIANT(pos < hh_darrlen(bucket) && bucket[pos].idx == idx);
+    hh_darrswapdel(bucket, pos);
+    // the bucket's last slot was moved into the gap
+    if(pos < hh_darrlen(bucket)) map_hdr->pos[bucket[pos].idx] = pos;
+}
+
+// points the index at the new location of an entry moved from `from` to `to`
+static void
+HH__hmapmove(const void* map, size_t from, size_t to) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    size_t hash = map_hdr->hashes[to] = map_hdr->hashes[from];
+    size_t pos = map_hdr->pos[to] = map_hdr->pos[from];
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        map_hdr->slots[pos].idx = (uint32_t) to;
+        return;
+    }
+    (*HH__hmapbucketref(map_hdr, hash))[pos].idx = (uint32_t) to;
+}
+
+// writes a new zero-initialized entry for key at the end of the map and indexes it
+// returns the index of the new entry
+size_t
+HH__hmapappend(void** map_ptr, const void* key, size_t hash) {
+    hh_hmapheader_t* map_hdr = HH__hmapgrow(map_ptr, 1);
     char* entry_start = ((char*) map_ptr[0]) + map_hdr->prop.sz_entry * map_hdr->len;
-    // check if element exists in the map
-    size_t idx = hh_hmapget(map_ptr[0], key);
-    if(idx < map_hdr->len) {
-        // if it does, copy that element to the end so we can return it
-        // this prevents data loss
-        char* entry_old = ((char*) map_ptr[0]) + map_hdr->prop.sz_entry * idx;
-        if(map_hdr->opt.key_f.free != NULL) 
-            (map_hdr->opt.key_f.free)(*((void**) entry_old + map_hdr->prop.off_key));
-        if(map_hdr->opt.val_f.free != NULL) 
-            (map_hdr->opt.val_f.free)(*((void**) entry_old + map_hdr->prop.off_val));
-        memcpy(entry_start, entry_old, map_hdr->prop.sz_entry);
-        entry_start = entry_old;
-        // save the index for use in macro
-        map_hdr->last = idx;
-    }
-    // add the new element
     memset(entry_start, 0, map_hdr->prop.sz_entry);
     if(map_hdr->opt.key_f.copy == NULL) {
         memcpy(entry_start + map_hdr->prop.off_key, key, map_hdr->prop.sz_key);
     } else {
         (map_hdr->opt.key_f.copy)(entry_start + map_hdr->prop.off_key, key, map_hdr->prop.sz_key);
     }
-    // add the corresponding bucket entry
-    if(idx == SIZE_MAX) {
-        hh_darrput(map_hdr->buckets[HH__hmapbucketindex(map_hdr, key)], map_hdr->len);
-        // increment length and save the index for use in macro
-        map_hdr->last = map_hdr->len++;
+    HH__hmaplink(map_ptr[0], hash, map_hdr->len);
+    HH__HMAP_COUNT(map_hdr, inserts);
+    map_hdr->last = map_hdr->len++;
+    HH__hmaprehash(map_ptr[0]);
+    return map_hdr->last;
+}
+
+static hh_hmapheader_t*
+HH__hmapdetach(void** map_ptr) {
+    hh_hmapheader_t* mapped = hh_hmapheader(map_ptr[0]);
+    hh_hmap_opt opt = mapped->opt;
+    opt.reserve = mapped->len + 1;
+    void* map = NULL;
+    hh_hmapheader_t* map_hdr = HH__hmapconfig(&map, mapped->prop, opt);
+    // the cached hashes are reused, so the seed must not change
+    map_hdr->opt.seed = mapped->opt.seed;
+    HH__hmapwordinit(map_hdr);
+    memcpy(map, map_ptr[0], mapped->len * mapped->prop.sz_entry);
+    for(size_t i = 0; i < mapped->len; ++i) {
+        HH__hmaplink(map, mapped->hashes[i], i);
+        map_hdr->len = i + 1;
+    }
+    // the mapping is kept until the map is freed, string keys point into it
+    map_hdr->mapping = mapped->mapping;
+    map_hdr->mapping_size = mapped->mapping_size;
+    map_ptr[0] = map;
+    return map_hdr;
+}
+
+// replaces entry `idx` with a zero-initialized entry for key (copied like HH__hmapappend does),
+// its index entry (and cached hash) stay valid
+// the old key/value are released and the old entry is copied past the end of the map,
+// so it can be returned to the caller, returns a pointer to the copy
+void*
+HH__hmapreplace(void** map_ptr, size_t idx, const void* key) {
+    // makes room for the copy, and moves mapped maps to the heap
+    hh_hmapheader_t* map_hdr = HH__hmapgrow(map_ptr, 1);
+    char* entry_start = (char*) map_ptr[0] + map_hdr->prop.sz_entry * map_hdr->len;
+    char* entry_old = (char*) map_ptr[0] + map_hdr->prop.sz_entry * idx;
+    HH__HMAP_COUNT(map_hdr, replaces);
+    if(map_hdr->opt.key_f.free != NULL) 
+        (map_hdr->opt.key_f.free)(*((void**) (entry_old + map_hdr->prop.off_key)));
+    if(map_hdr->opt.val_f.free != NULL) 
+        (map_hdr->opt.val_f.free)(*((void**) (entry_old + map_hdr->prop.off_val)));
+    memcpy(entry_start, entry_old, map_hdr->prop.sz_entry);
+    memset(entry_old, 0, map_hdr->prop.sz_entry);
+    if(map_hdr->opt.key_f.copy == NULL) {
+        memcpy(entry_old + map_hdr->prop.off_key, key, map_hdr->prop.sz_key);
+    } else {
+        (map_hdr->opt.key_f.copy)(entry_old + map_hdr->prop.off_key, key, map_hdr->prop.sz_key);
+    }
+    map_hdr->last = idx;
+    return entry_start;
+}
+
+_Bool
+HH__hmapinsert(void** map_ptr, hh_hmapprop_t prop, const void* key) {
+    HH_ASSERT_INVARIANT(map_ptr != NULL);
+    hh_hmapheader_t* map_hdr = (map_ptr[0] == NULL) ? \
+        HH__hmapconfig(map_ptr, prop, (hh_hmap_opt) {0}) : \
+        hh_hmapheader(map_ptr[0]);
+    return HH__hmapinsert_hashed(map_ptr, key, HH__hmaphashkey(map_hdr, key));
+}
+
+_Bool
+HH__hmapinsert_hashed(void** map_ptr, const void* key, size_t hash) {
+    HH_ASSERT_INVARIANT(map_ptr != NULL);
+    HH_ASSERT(map_ptr[0] != NULL, "hh_hmapinsert_hashed requires a map configured with hh_hmapconfig");
+    // check if element exists in the map
+    size_t idx = HH__hmapfind(map_ptr[0], hash, key, HH__hmapcomp(hh_hmapheader(map_ptr[0])));
+    if(idx == SIZE_MAX) {
+        HH__hmapappend(map_ptr, key, hash);
+        return 0;
+    }
+    // also saves the index for use in macro
+    HH__hmapreplace(map_ptr, idx, key);
+    return 1;
+}
+
+void
+HH__hmapupsert(void** map_ptr, hh_hmapprop_t prop, const void* key) {
+    HH_ASSERT_INVARIANT(map_ptr != NULL);
+    hh_hmapheader_t* map_hdr = (map_ptr[0] == NULL) ? \
+        HH__hmapconfig(map_ptr, prop, (hh_hmap_opt) {0}) : \
+        hh_hmapheader(map_ptr[0]);
+    size_t hash = HH__hmaphashkey(map_hdr, key);
+    size_t idx = HH__hmapfind(map_ptr[0], hash, key, HH__hmapcomp(hh_hmapheader(map_ptr[0])));
+    if(idx == SIZE_MAX) idx = HH__hmapappend(map_ptr, key, hash);
+    // the map may have been reallocated by HH__hmapappend
+    hh_hmapheader(map_ptr[0])->last = idx;
+}
+
+// makes room in the index for n more entries, so that a batch triggers at most one resize
+static void
+HH__hmapreserve(const void* map, size_t n) {
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    HH_ASSERT_INVARIANT(!map_hdr->mapped);
+    size_t len = map_hdr->len + n;
+    if(map_hdr->filter.blocks != NULL && map_hdr->filter.count + n > map_hdr->filter.capacity) 
+        HH__hmapfilter(map_hdr, 2 * len);
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        if(n <= map_hdr->slot_free) return;
+        size_t slot_count = map_hdr->slot_count;
+        while((double) slot_count * map_hdr->opt.max_load < (double) len) slot_count *= 2;
+        HH__hmapflatresize(map_hdr, slot_count);
+        return;
+    }
+    if((double) len <= (double) map_hdr->bucket_count * map_hdr->opt.max_load) return;
+    HH__hmaprehashstep(map, SIZE_MAX);
+    HH__HMAP_COUNT(map_hdr, rehashes);
+    map_hdr->buckets_old = map_hdr->buckets;
+    map_hdr->bucket_count_old = map_hdr->bucket_count;
+    map_hdr->rehash = 0;
+    while((double) map_hdr->bucket_count * map_hdr->opt.max_load < (double) len) map_hdr->bucket_count *= 2;
+    map_hdr->buckets = HH__alloc(map_hdr->opt.alloc, map_hdr->bucket_count * sizeof(hh_hmapslot_t*), "hmapreserve");
+    HH__hmaprehashstep(map, SIZE_MAX);
+}
+
+// hashes a batch of keys, prefetching the index lines each of them will probe
+static void
+HH__hmapprefetch(const void* map, const char* keys, size_t n, size_t* hashes) {
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    for(size_t i = 0; i < n; ++i) {
+        hashes[i] = HH__hmaphashkey(map_hdr, keys + i * map_hdr->prop.sz_key);
+        if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+            size_t group = (HH__hmapmix(hashes[i]) >> 7) & (map_hdr->slot_count / HH__HMAP_GROUP - 1);
+            HH__PREFETCH(map_hdr->ctrl + group * HH__HMAP_GROUP);
+            HH__PREFETCH(map_hdr->slots + group * HH__HMAP_GROUP);
+        } else HH__PREFETCH(HH__hmapbucketref(map_hdr, hashes[i]));
+    }
+    // second level: the bucket contents, or the entry behind the first matching slot
+    for(size_t i = 0; i < n; ++i) {
+        if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+            size_t mix = HH__hmapmix(hashes[i]);
+            size_t group = (mix >> 7) & (map_hdr->slot_count / HH__HMAP_GROUP - 1);
+            unsigned match = HH__hmapgroupmatch(map_hdr->ctrl + group * HH__HMAP_GROUP, (unsigned char) (mix & 0x7F));
+            if(match == 0) continue;
+            size_t idx = map_hdr->slots[group * HH__HMAP_GROUP + HH__ctz(match)].idx;
+            HH__PREFETCH((const char*) map + idx * map_hdr->prop.sz_entry);
+        } else {
+            const hh_hmapslot_t* bucket = *HH__hmapbucketref(map_hdr, hashes[i]);
+            if(bucket != NULL) HH__PREFETCH(bucket);
+        }
+    }
+}
+
+void
+HH__hmapget_many(const void* map, const void* keys, size_t n, size_t** out) {
+    HH_ASSERT_INVARIANT(out != NULL);
+    HH_ASSERT(n == 0 || keys != NULL, "hh_hmapget_many requires an array of keys");
+    size_t off = hh_darradd(*out, n);
+    if(map == NULL) {
+        for(size_t i = 0; i < n; ++i) (*out)[off + i] = SIZE_MAX;
+        return;
+    }
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    size_t hashes[HH_HMAP_BATCH];
+    const char* key;
+    for(size_t i = 0; i < n; i += HH_HMAP_BATCH) {
+        size_t batch = HH_MIN(n - i, (size_t) HH_HMAP_BATCH);
+        key = (const char*) keys + i * map_hdr->prop.sz_key;
+        HH__hmapprefetch(map, key, batch, hashes);
+        for(size_t j = 0; j < batch; ++j, key += map_hdr->prop.sz_key)
+            (*out)[off + i + j] = HH__hmapfind(map, hashes[j], key, HH__hmapcomp(map_hdr));
     }
-    return map_hdr->last == idx;
 }
 
 size_t
-hh_hmapget(const void* map, const void* key) {
+HH__hmapinsert_many(void** map_ptr, hh_hmapprop_t prop, const void* keys, const void* vals, size_t n) {
+    HH_ASSERT_INVARIANT(map_ptr != NULL);
+    HH_ASSERT(n == 0 || (keys != NULL && vals != NULL), "hh_hmapinsert_many requires arrays of keys and values");
+    hh_hmapheader_t* map_hdr = (map_ptr[0] == NULL) ? \
+        HH__hmapconfig(map_ptr, prop, (hh_hmap_opt) { .reserve = n + 1 }) : \
+        hh_hmapheader(map_ptr[0]);
+    // grow entries and index up front, so the loop below never reallocates
+    map_hdr = HH__hmapgrow(map_ptr, n);
+    HH__hmapreserve(map_ptr[0], n);
+    size_t hashes[HH_HMAP_BATCH];
+    size_t added = 0;
+    const char* key;
+    const char* val;
+    for(size_t i = 0; i < n; i += HH_HMAP_BATCH) {
+        size_t batch = HH_MIN(n - i, (size_t) HH_HMAP_BATCH);
+        key = (const char*) keys + i * prop.sz_key;
+        val = (const char*) vals + i * prop.sz_val;
+        HH__hmapprefetch(map_ptr[0], key, batch, hashes);
+        for(size_t j = 0; j < batch; ++j, key += prop.sz_key, val += prop.sz_val) {
+            added += !HH__hmapinsert_hashed(map_ptr, key, hashes[j]);
+            memcpy((char*) map_ptr[0] + map_hdr->last * prop.sz_entry + prop.off_val, val, prop.sz_val);
+        }
+    }
+    return added;
+}
+
+size_t
+hh_hmaphash(const void* map, const void* key) {
     HH_ASSERT_INVARIANT(key != NULL);
+    HH_ASSERT(map != NULL, "hh_hmaphash requires a map configured with hh_hmapconfig");
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    return HH__hmaphashkey(map_hdr, key);
+}
+
+size_t
+hh_hmapget_probe(const void* map, const void* probe) {
+    HH_ASSERT_INVARIANT(probe != NULL);
     if(map == NULL) return SIZE_MAX;
     hh_hmapheader_t* map_hdr = hh_hmapheader(map);
-    size_t* bucket = HH__hmapbucket(map_hdr, key);
-    char* other;
-    for(size_t i = 0; i < hh_darrlen(bucket); ++i) {
-        // calculate byte offset to entry's key
-        other = (char*) map + bucket[i] * map_hdr->prop.sz_entry + map_hdr->prop.off_key;
-        if((map_hdr->opt.key_f.comp)(key, other, map_hdr->prop.sz_key) == 0) 
-            return bucket[i];
+    HH_ASSERT(map_hdr->opt.probe_f.hash != NULL && map_hdr->opt.probe_f.comp != NULL, 
+        "hh_hmapget_probe requires .probe_f.hash and .probe_f.comp");
+    size_t hash = (map_hdr->opt.probe_f.hash)(probe, map_hdr->prop.sz_key, map_hdr->opt.seed);
+    return HH__hmapfind(map, hash, probe, map_hdr->opt.probe_f.comp);
+}
+
+// adds a chain (or probe distance) of length `len` to the stats histogram
+static void
+HH__hmapstatschain(hh_hmapstats_t* stats, size_t len) {
+    ++(stats->hist[HH_MIN(len, (size_t) HH_HMAP_STATS_BINS - 1)]);
+    if(len > stats->max_chain) stats->max_chain = len;
+}
+
+hh_hmapstats_t
+hh_hmapstats(const void* map) {
+    hh_hmapstats_t stats = {0};
+    if(map == NULL) return stats;
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    stats.len = map_hdr->len;
+    stats.cap = map_hdr->cap;
+    stats.bytes_entries = map_hdr->len * map_hdr->prop.sz_entry;
+    stats.bytes_slack = (map_hdr->cap - map_hdr->len) * map_hdr->prop.sz_entry;
+    // hashes, pos and the filter
+    stats.bytes_index = 2 * map_hdr->cap * sizeof(size_t) + map_hdr->filter.block_count * HH__BLOOM_WORDS * sizeof(uint64_t);
+    if(map_hdr->opt.layout == HH_HMAP_FLAT) {
+        stats.buckets = map_hdr->slot_count;
+        stats.bytes_index += map_hdr->slot_count * (1 + sizeof(hh_hmapslot_t));
+        size_t mask = map_hdr->slot_count / HH__HMAP_GROUP - 1;
+        for(size_t i = 0; i < map_hdr->len; ++i) {
+            // walk the probe sequence until it reaches the entry's group
+            size_t group = (HH__hmapmix(map_hdr->hashes[i]) >> 7) & mask, dist = 0;
+            while(group != map_hdr->pos[i] / HH__HMAP_GROUP) group = (group + ++dist) & mask;
+            HH__hmapstatschain(&stats, dist);
+        }
+    } else {
+        stats.buckets = map_hdr->bucket_count;
+        stats.bytes_index += (map_hdr->bucket_count + map_hdr->bucket_count_old) * sizeof(hh_hmapslot_t*);
+        for(size_t i = 0; i < map_hdr->bucket_count; ++i) {
+            HH__hmapstatschain(&stats, hh_darrlen(map_hdr->buckets[i]));
+            if(map_hdr->buckets[i] == NULL) continue;
+            stats.bytes_index += sizeof(hh_darrheader_t) + hh_darrcap(map_hdr->buckets[i]) * sizeof(hh_hmapslot_t);
+        }
+        // old buckets that haven't been migrated yet
+        for(size_t i = map_hdr->rehash; map_hdr->buckets_old != NULL && i < map_hdr->bucket_count_old; ++i) {
+            HH__hmapstatschain(&stats, hh_darrlen(map_hdr->buckets_old[i]));
+            if(map_hdr->buckets_old[i] == NULL) continue;
+            stats.bytes_index += sizeof(hh_darrheader_t) + hh_darrcap(map_hdr->buckets_old[i]) * sizeof(hh_hmapslot_t);
+        }
     }
-    return SIZE_MAX;
+    stats.load = (double) map_hdr->len / (double) stats.buckets;
+    stats.inserts = map_hdr->inserts;
+    stats.replaces = map_hdr->replaces;
+    stats.removes = map_hdr->removes;
+    stats.rehashes = map_hdr->rehashes;
+    stats.comparisons = map_hdr->comparisons;
+    return stats;
+}
+
+// string key representation used by hh_hmapsave
+static uint32_t
+HH__hmapfilekeys(const hh_hmapheader_t* map_hdr) {
+    // keys filled in by .key_f.copy are stored inline
+    if(map_hdr->opt.key_f.copy != NULL) return HH__HMAPFILE_RAW;
+    if(map_hdr->opt.key_f.comp == hh_comp_cstr) return HH__HMAPFILE_CSTR;
+#ifdef HH__HMAPFILE_SPAN_COMP
+    if(map_hdr->opt.key_f.comp == HH__HMAPFILE_SPAN_COMP) return HH__HMAPFILE_SPAN;
+#endif // HH__HMAPFILE_SPAN_COMP
+    return HH__HMAPFILE_RAW;
+}
+
+static inline uint64_t
+HH__hmapfilealign(uint64_t off) {
+    return (off + HH__HMAPFILE_ALIGN - 1) & ~(uint64_t) (HH__HMAPFILE_ALIGN - 1);
+}
+
+// the string pointers inside a key, `end` is only used by span keys
+static inline void
+HH__hmapfilestr(const char* key, uint32_t keys, uintptr_t* ptr, uintptr_t* end) {
+    memcpy(ptr, key, sizeof(uintptr_t));
+    if(keys == HH__HMAPFILE_SPAN) memcpy(end, key + sizeof(uintptr_t), sizeof(uintptr_t));
+}
+
+_Bool
+hh_hmapsave(const void* map, const char* path) {
+    HH_ASSERT(map != NULL, "hh_hmapsave requires a configured map");
+    const hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    hh_hmapfile_t file = { .magic = HH__HMAPFILE_MAGIC, .version = HH__HMAPFILE_VERSION, 
+        .endian = HH__HMAPFILE_ENDIAN, .word = (uint32_t) sizeof(size_t) };
+    file.keys = HH__hmapfilekeys(map_hdr);
+    file.len = map_hdr->len;
+    file.seed = map_hdr->opt.seed;
+    file.sz_entry = map_hdr->prop.sz_entry;
+    file.sz_key = map_hdr->prop.sz_key;
+    file.off_key = map_hdr->prop.off_key;
+    file.sz_val = map_hdr->prop.sz_val;
+    file.off_val = map_hdr->prop.off_val;
+    // a flat index is always written, chained maps get a temporary one
+    hh_hmapheader_t flat = *map_hdr;
+    if(map_hdr->opt.layout != HH_HMAP_FLAT) {
+        flat.opt.layout = HH_HMAP_FLAT;
+        flat.opt.max_load = HH_HMAP_FLAT_MAX_LOAD;
+        flat.ctrl = NULL;
+        flat.slots = NULL;
+        flat.pos = HH__alloc(flat.opt.alloc, (flat.len + 1) * sizeof(size_t), "hmapsave");
+        size_t slot_count = HH__HMAP_GROUP;
+        while((double) slot_count * flat.opt.max_load < (double) (flat.len + 1)) slot_count *= 2;
+        HH__hmapflatresize(&flat, slot_count);
+    }
+    file.slot_count = flat.slot_count;
+    // string heap
+    uint64_t heap_size = 0;
+    uintptr_t ptr, end;
+    const char* key;
+    for(size_t i = 0; i < map_hdr->len && file.keys != HH__HMAPFILE_RAW; ++i) {
+        HH__hmapfilestr((const char*) map + i * file.sz_entry + file.off_key, file.keys, &ptr, &end);
+        heap_size += ((file.keys == HH__HMAPFILE_CSTR) ? strlen((const char*) ptr) : (size_t) (end - ptr)) + 1;
+    }
+    file.off_entries = HH__hmapfilealign(sizeof(hh_hmapfile_t) + sizeof(hh_hmapheader_t));
+    file.off_hashes = HH__hmapfilealign(file.off_entries + (file.len + 1) * file.sz_entry);
+    file.off_pos = HH__hmapfilealign(file.off_hashes + file.len * sizeof(size_t));
+    file.off_ctrl = HH__hmapfilealign(file.off_pos + file.len * sizeof(size_t));
+    file.off_slots = HH__hmapfilealign(file.off_ctrl + file.slot_count);
+    file.off_heap = HH__hmapfilealign(file.off_slots + file.slot_count * sizeof(hh_hmapslot_t));
+    file.size = file.off_heap + heap_size;
+#if UINTPTR_MAX > 0xFFFFFFFFu
+    // preferred load address, spread out so that several files can be mapped at once
+    file.base = 0x100000000000ULL + ((uint64_t) (file.seed >> 16) & 0xFFF) * 0x100000000ULL;
+#endif // UINTPTR_MAX > 0xFFFFFFFFu
+    char* image = HH__alloc(NULL, (size_t) file.size, "hmapsave");
+    memcpy(image + file.off_entries, map, (size_t) (file.len * file.sz_entry));
+    memcpy(image + file.off_hashes, flat.hashes, (size_t) (file.len * sizeof(size_t)));
+    memcpy(image + file.off_pos, flat.pos, (size_t) (file.len * sizeof(size_t)));
+    memcpy(image + file.off_ctrl, flat.ctrl, (size_t) file.slot_count);
+    memcpy(image + file.off_slots, flat.slots, (size_t) (file.slot_count * sizeof(hh_hmapslot_t)));
+    // copy strings into the heap and point the keys at them
+    uint64_t heap_off = file.off_heap;
+    for(size_t i = 0; i < map_hdr->len && file.keys != HH__HMAPFILE_RAW; ++i) {
+        key = image + file.off_entries + i * file.sz_entry + file.off_key;
+        HH__hmapfilestr(key, file.keys, &ptr, &end);
+        size_t len = (file.keys == HH__HMAPFILE_CSTR) ? strlen((const char*) ptr) : (size_t) (end - ptr);
+        memcpy(image + heap_off, (const char*) ptr, len);
+        ptr = (uintptr_t) (file.base + heap_off);
+        end = ptr + len;
+        memcpy((char*) key, &ptr, sizeof(uintptr_t));
+        if(file.keys == HH__HMAPFILE_SPAN) memcpy((char*) key + sizeof(uintptr_t), &end, sizeof(uintptr_t));
+        heap_off += len + 1;
+    }
+    if(map_hdr->opt.layout != HH_HMAP_FLAT) {
+        HH__release(flat.opt.alloc, flat.ctrl, flat.slot_count);
+        HH__release(flat.opt.alloc, flat.slots, flat.slot_count * sizeof(hh_hmapslot_t));
+        HH__release(flat.opt.alloc, flat.pos, (flat.len + 1) * sizeof(size_t));
+    }
+    file.checksum = (uint64_t) hh_hash_wide(image + sizeof(hh_hmapfile_t), (size_t) file.size - sizeof(hh_hmapfile_t), 0);
+    memcpy(image, &file, sizeof(hh_hmapfile_t));
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) {
+        HH_ERR("Failed to open file at path [%s].", path);
+        HH__release(NULL, image, (size_t) file.size);
+        return 0;
+    }
+    _Bool ok = fwrite(image, 1, (size_t) file.size, f) == file.size;
+    ok = (fclose(f) == 0) && ok;
+    if(!ok) {
+        HH_ERR("Failed to write hmap to file [%s].", path);
+    }
+    HH__release(NULL, image, (size_t) file.size);
+    return ok;
+}
+
+// maps an entire file copy-on-write, preferably at `hint`
+static char*
+HH__hmapmap(const char* path, uint64_t hint, size_t* size) {
+#ifdef _WIN32
+    // no mapping, the file is read into memory instead
+    (void) hint;
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+    char* buf = NULL;
+    long size_temp;
+    if(fseek(f, 0, SEEK_END) || (size_temp = ftell(f)) < 0) goto failure;
+    *size = (size_t) size_temp;
+    rewind(f);
+    buf = malloc(*size + 1);
+    if(buf == NULL || fread(buf, 1, *size, f) != *size) goto failure;
+    fclose(f);
+    return buf;
+failure:
+    fclose(f);
+    free(buf);
+    return NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+        *size = (size_t) st.st_size;
+        mapping = mmap((void*) (uintptr_t) hint, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    return (mapping == MAP_FAILED) ? NULL : mapping;
+#endif // _WIN32
+}
+
+static void
+HH__hmapunmap(void* mapping, size_t size) {
+#ifdef _WIN32
+    (void) size;
+    free(mapping);
+#else
+    munmap(mapping, size);
+#endif // _WIN32
+}
+
+// returns a description of the first problem with a mapped file, NULL if it is usable
+static const char*
+HH__hmapfilecheck(const char* base, size_t size, hh_hmapprop_t prop) {
+    if(size < sizeof(hh_hmapfile_t)) return "file is truncated";
+    hh_hmapfile_t file;
+    memcpy(&file, base, sizeof(hh_hmapfile_t));
+    if(memcmp(file.magic, HH__HMAPFILE_MAGIC, sizeof(HH__HMAPFILE_MAGIC)) != 0) return "not an hmap file";
+    if(file.version != HH__HMAPFILE_VERSION) return "unsupported version";
+    if(file.endian != HH__HMAPFILE_ENDIAN || file.word != sizeof(size_t)) return "saved on an incompatible platform";
+    if(file.size != size) return "file is truncated";
+    if(file.sz_entry != prop.sz_entry || file.sz_key != prop.sz_key || file.off_key != prop.off_key || 
+        file.sz_val != prop.sz_val || file.off_val != prop.off_val) return "entry layout doesn't match the map";
+    // keeps the section bounds below from overflowing
+    if(file.len >= size / file.sz_entry || file.slot_count >= size) return "sections are out of bounds";
+    if(file.off_entries < sizeof(hh_hmapfile_t) + sizeof(hh_hmapheader_t) || 
+        file.off_entries + (file.len + 1) * file.sz_entry > file.off_hashes ||
+        file.off_hashes + file.len * sizeof(size_t) > file.off_pos ||
+        file.off_pos + file.len * sizeof(size_t) > file.off_ctrl ||
+        file.off_ctrl + file.slot_count > file.off_slots || 
+        file.off_slots + file.slot_count * sizeof(hh_hmapslot_t) > file.off_heap || 
+        file.off_heap > file.size) return "sections are out of bounds";
+    if(file.slot_count < HH__HMAP_GROUP || (file.slot_count & (file.slot_count - 1)) || 
+        file.len >= file.slot_count || file.len >= UINT32_MAX) return "index is malformed";
+    if(file.keys > HH__HMAPFILE_SPAN) return "unknown key representation";
+    size_t checksum = hh_hash_wide(base + sizeof(hh_hmapfile_t), size - sizeof(hh_hmapfile_t), 0);
+    if((uint64_t) checksum != file.checksum) return "checksum mismatch";
+    // the checksum isn't keyed, so the index and keys are checked before lookups use them unchecked
+    const unsigned char* ctrl = (const unsigned char*) (base + file.off_ctrl);
+    const hh_hmapslot_t* slots = (const hh_hmapslot_t*) (base + file.off_slots);
+    const size_t* pos = (const size_t*) (base + file.off_pos);
+    size_t empty = 0;
+    for(size_t i = 0; i < file.slot_count; ++i) {
+        empty += ctrl[i] == HH__HMAP_EMPTY;
+        if(!(ctrl[i] & 0x80) && slots[i].idx >= file.len) return "index is malformed";
+    }
+    // probes end at an empty slot
+    if(empty == 0) return "index is malformed";
+    for(size_t i = 0; i < file.len; ++i) if(pos[i] >= file.slot_count) return "index is malformed";
+    if(file.keys == HH__HMAPFILE_RAW || file.len == 0) return NULL;
+    // every cstr key ends before the end of the file
+    if(file.keys == HH__HMAPFILE_CSTR && base[size - 1] != '\0') return "string heap is malformed";
+    uintptr_t ptr, end = 0;
+    for(size_t i = 0; i < file.len; ++i) {
+        HH__hmapfilestr(base + file.off_entries + i * file.sz_entry + file.off_key, file.keys, &ptr, &end);
+        // offsets into the file, out of range values wrap around
+        ptr -= (uintptr_t) file.base;
+        end -= (uintptr_t) file.base;
+        if(ptr < file.off_heap || ptr >= size) return "string key is out of bounds";
+        if(file.keys == HH__HMAPFILE_SPAN && (end < ptr || end > size)) return "string key is out of bounds";
+    }
+    return NULL;
+}
+
+_Bool
+HH__hmapload_mapped(void** map_ptr, hh_hmapprop_t prop, const char* path) {
+    HH_ASSERT_INVARIANT(map_ptr != NULL);
+    hh_hmap_opt opt = (map_ptr[0] == NULL) ? (hh_hmap_opt) {0} : hh_hmapheader(map_ptr[0])->opt;
+    // peek at the preferred address before mapping the whole file
+    hh_hmapfile_t file = {0};
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+        HH_ERR("Failed to open file at path [%s].", path);
+        return 0;
+    }
+    size_t read_size = fread(&file, 1, sizeof(hh_hmapfile_t), f);
+    fclose(f);
+    size_t size = 0;
+    char* base = (read_size == sizeof(hh_hmapfile_t)) ? HH__hmapmap(path, file.base, &size) : NULL;
+    if(base == NULL) {
+        HH_ERR("Failed to map hmap file [%s].", path);
+        return 0;
+    }
+    const char* err = HH__hmapfilecheck(base, size, prop);
+    if(err != NULL) {
+        HH_ERR("Failed to load hmap file [%s]: %s.", path, err);
+        HH__hmapunmap(base, size);
+        return 0;
+    }
+    char* map = base + file.off_entries;
+    // string keys only need fixing up if the file couldn't be mapped where it expected
+    uintptr_t delta = (uintptr_t) base - (uintptr_t) file.base, ptr;
+    for(size_t i = 0; i < file.len && delta != 0 && file.keys != HH__HMAPFILE_RAW; ++i) {
+        char* key = map + i * file.sz_entry + file.off_key;
+        for(size_t j = 0; j < ((file.keys == HH__HMAPFILE_SPAN) ? 2u : 1u); ++j) {
+            memcpy(&ptr, key + j * sizeof(uintptr_t), sizeof(uintptr_t));
+            ptr += delta;
+            memcpy(key + j * sizeof(uintptr_t), &ptr, sizeof(uintptr_t));
+        }
+    }
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    memset(map_hdr, 0, sizeof(hh_hmapheader_t));
+    map_hdr->prop = prop;
+    map_hdr->opt = opt;
+    if(opt.key_f.hash == NULL) map_hdr->opt.key_f.hash = hh_hash_wide;
+    if(opt.key_f.comp == NULL) map_hdr->opt.key_f.comp = memcmp;
+    // the mapping owns the keys
+    map_hdr->opt.key_f.copy = NULL;
+    map_hdr->opt.key_f.free = NULL;
+    map_hdr->opt.val_f.free = NULL;
+    map_hdr->opt.layout = HH_HMAP_FLAT;
+    map_hdr->opt.max_load = HH_HMAP_FLAT_MAX_LOAD;
+    map_hdr->opt.seed = (size_t) file.seed;
+    HH__hmapwordinit(map_hdr);
+    map_hdr->len = (size_t) file.len;
+    map_hdr->cap = map_hdr->len + 1;
+    map_hdr->last = SIZE_MAX;
+    map_hdr->hashes = (size_t*) (base + file.off_hashes);
+    map_hdr->pos = (size_t*) (base + file.off_pos);
+    map_hdr->ctrl = (unsigned char*) (base + file.off_ctrl);
+    map_hdr->slots = (hh_hmapslot_t*) (base + file.off_slots);
+    map_hdr->slot_count = (size_t) file.slot_count;
+    map_hdr->mapping = base;
+    map_hdr->mapping_size = size;
+    map_hdr->mapped = 1;
+    // catch a map configured with different key functions than the saved one
+    if(file.len > 0 && (map_hdr->opt.key_f.hash)(map + file.off_key, prop.sz_key, map_hdr->opt.seed) != map_hdr->hashes[0]) {
+        HH_ERR("Failed to load hmap file [%s]: .key_f.hash doesn't match the saved map.", path);
+        HH__hmapunmap(base, size);
+        return 0;
+    }
+    hh_hmapfree(map_ptr[0]);
+    map_ptr[0] = map;
+    return 1;
 }
 
 // TODO: Should shadow with macro to set map to NULL
@@ -1194,6 +3874,14 @@ void
 hh_hmapfree(const void* map) {
     if(map == NULL) return;
     hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    // everything, including the header, lives in the mapping
+    if(map_hdr->mapped) {
+        HH__hmapunmap(map_hdr->mapping, map_hdr->mapping_size);
+        return;
+    }
+    // a map moved out of its mapping still has string keys pointing into it
+    void* mapping = map_hdr->mapping;
+    size_t mapping_size = map_hdr->mapping_size;
     if(map_hdr->opt.key_f.free != NULL) {
         char* key;
         for(size_t i = 0; i < map_hdr->len; ++i) {
@@ -1208,11 +3896,24 @@ hh_hmapfree(const void* map) {
             (map_hdr->opt.val_f.free)(*((void**) val));
         }
     }
-    for(size_t i = 0; i < map_hdr->opt.bucket_count; ++i) {
+    const hh_allocator_t* alloc = map_hdr->opt.alloc;
+    for(size_t i = 0; i < map_hdr->bucket_count; ++i) {
         hh_darrfree(map_hdr->buckets[i]);
     }
-    free(map_hdr->buckets);
-    free(map_hdr);
+    HH__release(alloc, map_hdr->buckets, map_hdr->bucket_count * sizeof(hh_hmapslot_t*));
+    if(map_hdr->buckets_old != NULL) {
+        for(size_t i = map_hdr->rehash; i < map_hdr->bucket_count_old; ++i) {
+            hh_darrfree(map_hdr->buckets_old[i]);
+        }
+        HH__release(alloc, map_hdr->buckets_old, map_hdr->bucket_count_old * sizeof(hh_hmapslot_t*));
+    }
+    HH__release(alloc, map_hdr->ctrl, map_hdr->slot_count);
+    HH__release(alloc, map_hdr->slots, map_hdr->slot_count * sizeof(hh_hmapslot_t));
+    HH__release(alloc, map_hdr->hashes, map_hdr->cap * sizeof(size_t));
+    HH__release(alloc, map_hdr->pos, map_hdr->cap * sizeof(size_t));
+    hh_bloom_free(&(map_hdr->filter));
+    HH__release(alloc, map_hdr, sizeof(hh_hmapheader_t) + map_hdr->cap * map_hdr->prop.sz_entry);
+    if(mapping != NULL) HH__hmapunmap(mapping, mapping_size);
 }
 
 void*
@@ -1223,45 +3924,35 @@ hh_hmapremove(const void* map, const void* key) {
     // make sure key exists in the map
     size_t idx = hh_hmapget(map, key);
     if(idx == SIZE_MAX) return NULL;
+    return HH__hmapremoveat(map, idx);
+}
+
+// removes entry `idx`, returns a pointer to the removed entry
+void*
+HH__hmapremoveat(const void* map, size_t idx) {
     // perform deletion
     hh_hmapheader_t* map_hdr = hh_hmapheader(map);
-    (map_hdr->len)--;
-    char* fst = (char*) map + idx * map_hdr->prop.sz_entry;
-    char* snd = (char*) map + map_hdr->len * map_hdr->prop.sz_entry;
-    // remove the bucket entry for the deleted entry
-    size_t* bucket = HH__hmapbucket(map_hdr, fst + map_hdr->prop.off_key);
-    _Bool found = 0;
-    for(size_t i = 0; i < hh_darrlen(bucket); ++i) {
-        if(bucket[i] == idx) {
-            hh_darrswapdel(bucket, i);
-            found = 1;
-            break;
-        }
-    }
-    HH_ASSERT(found);
-    // if there are >1 elements in the map we do swap deletion
-    _Bool swap = (idx < map_hdr->len);
-    if(swap) {
-        char* fst_end = fst + map_hdr->prop.sz_entry;
-        char* snd_end = snd + map_hdr->prop.sz_entry;
-        hh_memswap(fst, fst_end, snd, snd_end);
-        // update the bucket entry for the moved entry
-        bucket = HH__hmapbucket(map_hdr, fst + map_hdr->prop.off_key);
-        found = 0;
-        for(size_t i = 0; i < hh_darrlen(bucket); ++i) {
-            if(bucket[i] == map_hdr->len) {
-                bucket[i] = idx;
-                found = 1;
-                break;
-            }
-        }
-        HH_ASSERT(found);
+    // works in place on mapped maps too, their entries section ends in a spare slot
+    char* entry_start = (char*) map + idx * map_hdr->prop.sz_entry;
+    // remove the index entry for the deleted entry
+    HH__hmapunlink(map, idx);
+    HH__HMAP_COUNT(map_hdr, removes);
+    // if there are >1 elements in the map we fill the gap with the last entry
+    // the removed entry is kept in the spare slot past the end of the map
+    if(idx < --(map_hdr->len)) {
+        char* last = (char*) map + map_hdr->len * map_hdr->prop.sz_entry;
+        char* spare = last + map_hdr->prop.sz_entry;
+        memcpy(spare, entry_start, map_hdr->prop.sz_entry);
+        memcpy(entry_start, last, map_hdr->prop.sz_entry);
+        // update the index entry for the moved entry
+        HH__hmapmove(map, map_hdr->len, idx);
+        entry_start = spare;
     }
-    char* entry_start = (swap ? snd : fst);
     if(map_hdr->opt.key_f.free != NULL) 
         (map_hdr->opt.key_f.free)(*((void**) (entry_start + map_hdr->prop.off_key)));
     if(map_hdr->opt.val_f.free != NULL) 
         (map_hdr->opt.val_f.free)(*((void**) (entry_start + map_hdr->prop.off_val)));
+    HH__hmaprehash(map);
     // return pointer to the removed entry
     return entry_start;
 }
@@ -1285,183 +3976,1348 @@ hh_read_entire_file(const char* path) {
     }
     unsigned long size = (unsigned long) size_temp;
     rewind(f);
-    buf = calloc(size + 1, sizeof(char*));
-    if(buf == NULL) {
-        HH_ERR("Failed to allocate buffer for file contents [%s].", path);
-        goto failure;
-    }
+    // reserving makes room for the null-terminator past the contents
+    hh_darrreserve(buf, (size_t) size);
     size_t read_size = fread(buf, 1, size, f);
     if(read_size != size) {
         HH_ERR("Failed to read entire file into buffer [%s].", path);
         goto failure;
     }
+    buf[size] = '\0';
+    hh_darrheader(buf)->len = (size_t) size;
     fclose(f);
     return buf;
 failure:
     fclose(f);
-    free(buf);
+    hh_darrfree(buf);
     return NULL;
 }
 
-const char*
-hh_skip_whitespace(const char* ptr) {
-    while(strchr(" \t\r\n", *ptr) && (*ptr) != '\0') ++ptr;
-    return ptr;
+const char*
+hh_skip_whitespace(const char* ptr) {
+    while(strchr(" \t\r\n", *ptr) && (*ptr) != '\0') ++ptr;
+    return ptr;
+}
+
+_Bool
+hh_has_prefix(const char* str, const char* prefix) {
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+_Bool
+hh_has_suffix(const char* str, const char* suffix) {
+    size_t len_str = strlen(str);
+    size_t len_suffix = strlen(suffix);
+    return len_suffix <= len_str && !strcmp(str + len_str - len_suffix, suffix);
+}
+
+// NOTE: Great information by Raymond Chen found here:
+// https://devblogs.microsoft.com/oldnewthing/20260101-00/?p=111955
+void
+hh_memswap(char* fst, char* fst_end, char* snd, const char* snd_end) {
+    HH_ASSERT_INVARIANT(fst != NULL);
+    HH_ASSERT_INVARIANT(fst_end != NULL);
+    HH_ASSERT_INVARIANT(snd != NULL);
+    HH_ASSERT_INVARIANT(snd_end != NULL);
+    HH_ASSERT_INVARIANT(fst <= fst_end);
+    HH_ASSERT_INVARIANT(fst_end <= snd);
+    HH_ASSERT_INVARIANT(snd <= snd_end);
+    hh_memflip(fst, fst_end);
+    hh_memflip(fst_end, snd);
+    hh_memflip(snd, snd_end);
+    hh_memflip(fst, snd_end);
+}
+
+void 
+hh_memflip(char* ptr, const char* end) {
+    HH_ASSERT_INVARIANT(ptr != NULL);
+    HH_ASSERT_INVARIANT(end != NULL);
+    HH_ASSERT_INVARIANT(ptr <= end);
+    hh_memflipn(ptr, (size_t) (end - ptr));
+}
+
+void 
+hh_memflipn(char* ptr, size_t n) {
+    HH_ASSERT_INVARIANT(ptr != NULL);
+    if(n == 0) return;
+    char temp;
+    for(size_t i = 0; i < n / 2; ++i) {
+        temp = ptr[i];
+        ptr[i] = ptr[n - 1 - i];
+        ptr[n - 1 - i] = temp;
+    }
+}
+
+/*-
+ * Copyright (c) 2011 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * This code is derived from software contributed to The NetBSD Foundation
+ * by Christos Zoulas.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+ptrdiff_t
+hh_getdelim(char** buf, size_t* bufsiz, int delimiter, FILE* fp) {
+    char *ptr, *eptr;
+    if(*buf == NULL || *bufsiz == 0) {
+        *bufsiz = BUFSIZ;
+        if((*buf = (char*) malloc(*bufsiz)) == NULL) return -1;
+    }
+    for(ptr = *buf, eptr = *buf + *bufsiz;;) {
+        int c = fgetc(fp);
+        if(c == -1) {
+            if(feof(fp)) {
+                ptrdiff_t diff = ptr - *buf;
+                if(diff != 0) {
+                    *ptr = '\0';
+                    return diff;
+                }
+            }
+            return -1;
+        }
+        *ptr++ = (char) c;
+        if(c == delimiter) {
+            *ptr = '\0';
+            return ptr - *buf;
+        }
+        if(ptr + 2 >= eptr) {
+            char *nbuf;
+            size_t nbufsiz = *bufsiz * 2;
+            ptrdiff_t d = ptr - *buf;
+            if((nbuf = (char*) realloc(*buf, nbufsiz)) == NULL) return -1;
+            *buf = nbuf;
+            *bufsiz = nbufsiz;
+            eptr = nbuf + nbufsiz;
+            ptr = nbuf + d;
+        }
+    }
+}
+
+ptrdiff_t
+hh_getline(char** buf, size_t* bufsiz, FILE* fp) {
+    return hh_getdelim(buf, bufsiz, '\n', fp);
+}
+
+/*-
+ * Copyright (c) 2009 David Schultz <das@FreeBSD.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+size_t
+hh_strnlen(const char *s, size_t maxlen) {
+	size_t len;
+	for(len = 0; len < maxlen; len++, s++) {
+		if(!*s) break;
+	}
+	return (len);
+}
+
+#define HH__BTREE_KEYS(node) ((char*) ((node) + 1))
+
+// takes a block from a free list, or a new one from the arena
+static void*
+HH__btree_alloc(hh_btree_t* tree, void** free_list, size_t sz) {
+    void* ptr = *free_list;
+    if(ptr != NULL) {
+        memcpy(free_list, ptr, sizeof(void*));
+        return ptr;
+    }
+    // keep every allocation word-aligned, nodes hold pointers
+    ptr = hh_arena_alloc(&(tree->arena), (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1));
+    HH_ASSERT(ptr != NULL, "hh_btree failed to allocate");
+    return ptr;
+}
+
+// the first word of a freed block links it to the rest of the list
+static inline void
+HH__btree_recycle(void** free_list, void* ptr) {
+    memcpy(ptr, free_list, sizeof(void*));
+    *free_list = ptr;
+}
+
+// size class of a string key block of sz bytes
+static inline size_t
+HH__btree_class(size_t sz) {
+    size_t c = 0;
+    while(((size_t) 16 << c) < sz) ++c;
+    return c;
+}
+
+// fan-out and layout, computed once the options can no longer change
+static void
+HH__btree_layout(hh_btree_t* tree) {
+    if(tree->key_size != 0) return;
+    tree->key_size = (tree->opt.kind == HH_BTREE_STR) ? sizeof(HH__btree_str_t) : sizeof(int64_t);
+    size_t room = HH_BTREE_NODE_SIZE - sizeof(HH__btree_node_t);
+    tree->leaf_cap = room / (tree->key_size + tree->opt.val_size);
+    tree->inner_cap = (room - sizeof(void*)) / (tree->key_size + sizeof(void*));
+    HH_ASSERT(tree->leaf_cap >= 4 && tree->inner_cap >= 4,
+        "hh_btree values are too large for HH_BTREE_NODE_SIZE");
+    tree->off_vals = tree->leaf_cap * tree->key_size;
+}
+
+static HH__btree_node_t*
+HH__btree_node(hh_btree_t* tree, _Bool leaf) {
+    HH__btree_node_t* node = HH__btree_alloc(tree, &(tree->free_nodes), HH_BTREE_NODE_SIZE);
+    node->next = NULL;
+    node->len = 0;
+    node->leaf = leaf;
+    return node;
+}
+
+static inline HH__btree_node_t**
+HH__btree_children(const hh_btree_t* tree, const HH__btree_node_t* node) {
+    return (HH__btree_node_t**) (HH__BTREE_KEYS(node) + tree->inner_cap * tree->key_size);
+}
+
+static inline char*
+HH__btree_vals(const hh_btree_t* tree, const HH__btree_node_t* node) {
+    return HH__BTREE_KEYS(node) + tree->off_vals;
+}
+
+static int
+HH__btree_comp(const hh_btree_t* tree, const void* fst, const void* snd) {
+    if(tree->opt.kind == HH_BTREE_INT) {
+        int64_t key_fst, key_snd;
+        memcpy(&key_fst, fst, sizeof(int64_t));
+        memcpy(&key_snd, snd, sizeof(int64_t));
+        return (key_fst > key_snd) - (key_fst < key_snd);
+    }
+    const HH__btree_str_t* str_fst = fst;
+    const HH__btree_str_t* str_snd = snd;
+    int ret = memcmp(str_fst->ptr, str_snd->ptr, HH_MIN(str_fst->len, str_snd->len));
+    if(ret != 0) return ret;
+    return (str_fst->len > str_snd->len) - (str_fst->len < str_snd->len);
+}
+
+// number of keys in node that are < key (or <= key when upper is set)
+static size_t
+HH__btree_search(const hh_btree_t* tree, const HH__btree_node_t* node, const void* key, _Bool upper) {
+    size_t lo = 0, hi = node->len;
+    const char* keys = HH__BTREE_KEYS(node);
+    if(tree->opt.kind == HH_BTREE_INT) {
+        int64_t k;
+        memcpy(&k, key, sizeof(int64_t));
+        const int64_t* ints = (const int64_t*) keys;
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(ints[mid] < k || (upper && ints[mid] == k)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int comp = HH__btree_comp(tree, keys + mid * tree->key_size, key);
+        if(comp < 0 || (upper && comp == 0)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// leaf that holds (or would hold) key
+static HH__btree_node_t*
+HH__btree_leaf(const hh_btree_t* tree, const void* key) {
+    HH__btree_node_t* node = tree->root;
+    while(node != NULL && !node->leaf) {
+        // a separator equal to key is the first key of the right child
+        node = HH__btree_children(tree, node)[HH__btree_search(tree, node, key, 1)];
+    }
+    return node;
+}
+
+// skips past the end of a leaf (only an empty root leaf is left by removal)
+static hh_btree_cursor_t
+HH__btree_cursor(const hh_btree_t* tree, HH__btree_node_t* leaf, size_t idx) {
+    while(leaf != NULL && idx >= leaf->len) {
+        leaf = leaf->next;
+        idx = 0;
+    }
+    return (hh_btree_cursor_t) { .tree = tree, .leaf = leaf, .idx = idx };
+}
+
+static hh_btree_cursor_t
+HH__btree_bound(const hh_btree_t* tree, const void* key, _Bool upper) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* leaf = HH__btree_leaf(tree, key);
+    if(leaf == NULL) return (hh_btree_cursor_t) { .tree = tree };
+    return HH__btree_cursor(tree, leaf, HH__btree_search(tree, leaf, key, upper));
+}
+
+static void*
+HH__btree_get(const hh_btree_t* tree, const void* key) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* leaf = HH__btree_leaf(tree, key);
+    if(leaf == NULL) return NULL;
+    size_t idx = HH__btree_search(tree, leaf, key, 0);
+    if(idx == leaf->len || HH__btree_comp(tree, HH__BTREE_KEYS(leaf) + idx * tree->key_size, key) != 0) return NULL;
+    return HH__btree_vals(tree, leaf) + idx * tree->opt.val_size;
+}
+
+// copies a new key into the tree (string bytes go to the arena)
+static void
+HH__btree_keycopy(hh_btree_t* tree, void* dst, const void* key) {
+    if(tree->opt.kind == HH_BTREE_STR) {
+        HH__btree_str_t str = *((const HH__btree_str_t*) key);
+        HH_ASSERT(str.len < SIZE_MAX / 2, "hh_btree received a key of %zu bytes", str.len);
+        size_t c = HH__btree_class(str.len + 1);
+        char* copy = HH__btree_alloc(tree, &(tree->free_keys[c]), (size_t) 16 << c);
+        if(str.len > 0) memcpy(copy, str.ptr, str.len);
+        copy[str.len] = '\0';
+        str.ptr = copy;
+        memcpy(dst, &str, sizeof(HH__btree_str_t));
+        return;
+    }
+    memcpy(dst, key, tree->key_size);
+}
+
+// releases the bytes of a key copied by HH__btree_keycopy
+static void
+HH__btree_keyfree(hh_btree_t* tree, const void* key) {
+    if(tree->opt.kind != HH_BTREE_STR) return;
+    HH__btree_str_t str;
+    memcpy(&str, key, sizeof(HH__btree_str_t));
+    HH__btree_recycle(&(tree->free_keys[HH__btree_class(str.len + 1)]), (char*) str.ptr);
+}
+
+static void
+HH__btree_valcopy(const hh_btree_t* tree, void* dst, const void* val) {
+    if(tree->opt.val_size == 0) return;
+    if(val == NULL) memset(dst, 0, tree->opt.val_size);
+    else memcpy(dst, val, tree->opt.val_size);
+}
+
+// inserts into a leaf with room for one more entry
+static void
+HH__btree_leafinsert(hh_btree_t* tree, HH__btree_node_t* leaf, size_t idx, const void* key, const void* val) {
+    char* keys = HH__BTREE_KEYS(leaf);
+    char* vals = HH__btree_vals(tree, leaf);
+    size_t ks = tree->key_size, vs = tree->opt.val_size;
+    memmove(keys + (idx + 1) * ks, keys + idx * ks, (leaf->len - idx) * ks);
+    if(vs > 0) memmove(vals + (idx + 1) * vs, vals + idx * vs, (leaf->len - idx) * vs);
+    HH__btree_keycopy(tree, keys + idx * ks, key);
+    HH__btree_valcopy(tree, vals + idx * vs, val);
+    ++(leaf->len);
+}
+
+// inserts a separator and the child to its right into an inner node with room for them
+static void
+HH__btree_innerinsert(hh_btree_t* tree, HH__btree_node_t* node, size_t idx, const void* sep, HH__btree_node_t* child) {
+    char* keys = HH__BTREE_KEYS(node);
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    size_t ks = tree->key_size;
+    memmove(keys + (idx + 1) * ks, keys + idx * ks, (node->len - idx) * ks);
+    memmove(children + idx + 2, children + idx + 1, (node->len - idx) * sizeof(void*));
+    memcpy(keys + idx * ks, sep, ks);
+    children[idx + 1] = child;
+    ++(node->len);
+}
+
+// inserts key into the subtree at node
+// returns the new right sibling when node had to be split, its smallest key is copied to sep
+static HH__btree_node_t*
+HH__btree_insertat(hh_btree_t* tree, HH__btree_node_t* node, const void* key, const void* val, void* sep, _Bool* added) {
+    size_t ks = tree->key_size;
+    if(node->leaf) {
+        size_t idx = HH__btree_search(tree, node, key, 0);
+        if(idx < node->len && HH__btree_comp(tree, HH__BTREE_KEYS(node) + idx * ks, key) == 0) {
+            HH__btree_valcopy(tree, HH__btree_vals(tree, node) + idx * tree->opt.val_size, val);
+            *added = 0;
+            return NULL;
+        }
+        *added = 1;
+        if(node->len < tree->leaf_cap) {
+            HH__btree_leafinsert(tree, node, idx, key, val);
+            return NULL;
+        }
+        // move the upper half into a new leaf
+        HH__btree_node_t* right = HH__btree_node(tree, 1);
+        size_t mid = node->len / 2, vs = tree->opt.val_size;
+        right->len = node->len - (uint32_t) mid;
+        memcpy(HH__BTREE_KEYS(right), HH__BTREE_KEYS(node) + mid * ks, right->len * ks);
+        if(vs > 0) memcpy(HH__btree_vals(tree, right), HH__btree_vals(tree, node) + mid * vs, right->len * vs);
+        node->len = (uint32_t) mid;
+        right->next = node->next;
+        node->next = right;
+        if(idx <= mid) HH__btree_leafinsert(tree, node, idx, key, val);
+        else HH__btree_leafinsert(tree, right, idx - mid, key, val);
+        HH__btree_keycopy(tree, sep, HH__BTREE_KEYS(right));
+        return right;
+    }
+    size_t idx = HH__btree_search(tree, node, key, 1);
+    char child_sep[sizeof(HH__btree_str_t)];
+    HH__btree_node_t* child = HH__btree_insertat(tree, HH__btree_children(tree, node)[idx], key, val, child_sep, added);
+    if(child == NULL) return NULL;
+    if(node->len < tree->inner_cap) {
+        HH__btree_innerinsert(tree, node, idx, child_sep, child);
+        return NULL;
+    }
+    // the middle key moves up, the keys and children after it move right
+    HH__btree_node_t* right = HH__btree_node(tree, 0);
+    size_t mid = node->len / 2;
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    right->len = node->len - (uint32_t) mid - 1;
+    memcpy(sep, HH__BTREE_KEYS(node) + mid * ks, ks);
+    memcpy(HH__BTREE_KEYS(right), HH__BTREE_KEYS(node) + (mid + 1) * ks, right->len * ks);
+    memcpy(HH__btree_children(tree, right), children + mid + 1, (right->len + 1) * sizeof(void*));
+    node->len = (uint32_t) mid;
+    if(idx <= mid) HH__btree_innerinsert(tree, node, idx, child_sep, child);
+    else HH__btree_innerinsert(tree, right, idx - mid - 1, child_sep, child);
+    return right;
+}
+
+static _Bool
+HH__btree_put(hh_btree_t* tree, const void* key, const void* val) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_layout(tree);
+    if(tree->root == NULL) tree->root = HH__btree_node(tree, 1);
+    _Bool added = 0;
+    char sep[sizeof(HH__btree_str_t)];
+    HH__btree_node_t* right = HH__btree_insertat(tree, tree->root, key, val, sep, &added);
+    if(right != NULL) {
+        // the root was split, the tree grows by one level
+        HH__btree_node_t* root = HH__btree_node(tree, 0);
+        HH__btree_children(tree, root)[0] = tree->root;
+        HH__btree_innerinsert(tree, root, 0, sep, right);
+        tree->root = root;
+    }
+    tree->len += added;
+    return added;
+}
+
+// merges child i + 1 of node into child i when their entries fit in one node
+static void
+HH__btree_merge(hh_btree_t* tree, HH__btree_node_t* node, size_t i) {
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    HH__btree_node_t* left = children[i];
+    HH__btree_node_t* right = children[i + 1];
+    size_t ks = tree->key_size, vs = tree->opt.val_size;
+    char* sep = HH__BTREE_KEYS(node) + i * ks;
+    if(left->leaf) {
+        if(left->len + right->len > tree->leaf_cap) return;
+        memcpy(HH__BTREE_KEYS(left) + left->len * ks, HH__BTREE_KEYS(right), right->len * ks);
+        if(vs > 0) memcpy(HH__btree_vals(tree, left) + left->len * vs, HH__btree_vals(tree, right), right->len * vs);
+        left->next = right->next;
+        HH__btree_keyfree(tree, sep);
+    } else {
+        // the separator moves down between the two halves
+        if(left->len + 1 + right->len > tree->inner_cap) return;
+        memcpy(HH__BTREE_KEYS(left) + left->len * ks, sep, ks);
+        memcpy(HH__BTREE_KEYS(left) + (left->len + 1) * ks, HH__BTREE_KEYS(right), right->len * ks);
+        memcpy(HH__btree_children(tree, left) + left->len + 1, HH__btree_children(tree, right), (right->len + 1) * sizeof(void*));
+        ++(left->len);
+    }
+    left->len += right->len;
+    memmove(sep, sep + ks, (node->len - i - 1) * ks);
+    memmove(children + i + 1, children + i + 2, (node->len - i - 1) * sizeof(void*));
+    --(node->len);
+    HH__btree_recycle(&(tree->free_nodes), right);
+}
+
+// removes key from the subtree at node, returns truthy if it was present
+// a child left under half full is merged with a sibling
+static _Bool
+HH__btree_removeat(hh_btree_t* tree, HH__btree_node_t* node, const void* key) {
+    size_t ks = tree->key_size;
+    if(node->leaf) {
+        size_t idx = HH__btree_search(tree, node, key, 0);
+        size_t vs = tree->opt.val_size;
+        char* keys = HH__BTREE_KEYS(node);
+        if(idx == node->len || HH__btree_comp(tree, keys + idx * ks, key) != 0) return 0;
+        HH__btree_keyfree(tree, keys + idx * ks);
+        memmove(keys + idx * ks, keys + (idx + 1) * ks, (node->len - idx - 1) * ks);
+        char* vals = HH__btree_vals(tree, node);
+        if(vs > 0) memmove(vals + idx * vs, vals + (idx + 1) * vs, (node->len - idx - 1) * vs);
+        --(node->len);
+        return 1;
+    }
+    size_t idx = HH__btree_search(tree, node, key, 1);
+    HH__btree_node_t* child = HH__btree_children(tree, node)[idx];
+    if(!HH__btree_removeat(tree, child, key)) return 0;
+    size_t cap = child->leaf ? tree->leaf_cap : tree->inner_cap;
+    // the last child merges into its left sibling
+    if(child->len < cap / 2 && node->len > 0) HH__btree_merge(tree, node, (idx < node->len) ? idx : idx - 1);
+    return 1;
+}
+
+static _Bool
+HH__btree_remove(hh_btree_t* tree, const void* key) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    if(tree->root == NULL || !HH__btree_removeat(tree, tree->root, key)) return 0;
+    // an inner root left with one child is replaced by it, the tree shrinks by one level
+    while(!tree->root->leaf && tree->root->len == 0) {
+        HH__btree_node_t* root = tree->root;
+        tree->root = HH__btree_children(tree, root)[0];
+        HH__btree_recycle(&(tree->free_nodes), root);
+    }
+    --(tree->len);
+    return 1;
+}
+
+void
+HH__btree_config(hh_btree_t* tree, hh_btree_opt opt) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH_ASSERT(tree->root == NULL, "hh_btree_config requires an empty tree");
+    HH_ASSERT(opt.kind == HH_BTREE_INT || opt.kind == HH_BTREE_STR, "hh_btree_config received an unknown kind");
+    tree->opt = opt;
+    tree->key_size = 0;
+}
+
+_Bool
+hh_btree_put_int(hh_btree_t* tree, int64_t key, const void* val) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_put_int requires HH_BTREE_INT keys");
+    return HH__btree_put(tree, &key, val);
+}
+
+void*
+hh_btree_get_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_get_int requires HH_BTREE_INT keys");
+    return HH__btree_get(tree, &key);
+}
+
+_Bool
+hh_btree_remove_int(hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_remove_int requires HH_BTREE_INT keys");
+    return HH__btree_remove(tree, &key);
+}
+
+hh_btree_cursor_t
+hh_btree_lower_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_lower_int requires HH_BTREE_INT keys");
+    return HH__btree_bound(tree, &key, 0);
+}
+
+hh_btree_cursor_t
+hh_btree_upper_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_upper_int requires HH_BTREE_INT keys");
+    return HH__btree_bound(tree, &key, 1);
+}
+
+_Bool
+hh_btree_put_str(hh_btree_t* tree, const char* str, size_t len, const void* val) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_put_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_put(tree, &key, val);
+}
+
+void*
+hh_btree_get_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_get_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_get(tree, &key);
+}
+
+_Bool
+hh_btree_remove_str(hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_remove_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_remove(tree, &key);
+}
+
+hh_btree_cursor_t
+hh_btree_lower_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_lower_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_bound(tree, &key, 0);
+}
+
+hh_btree_cursor_t
+hh_btree_upper_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_upper_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_bound(tree, &key, 1);
+}
+
+void
+hh_btree_load(hh_btree_t* tree, const void* keys, const void* vals) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    hh_btree_free(tree);
+    HH__btree_layout(tree);
+    size_t n = hh_darrlen(keys), ks = tree->key_size, vs = tree->opt.val_size;
+    if(n == 0) return;
+    // fill the leaves evenly, left to right
+    size_t leaves = (n + tree->leaf_cap - 1) / tree->leaf_cap, count = leaves;
+    HH__btree_node_t** level = HH__alloc(NULL, leaves * sizeof(HH__btree_node_t*), "hh_btree_load");
+    HH__btree_node_t* prev = NULL;
+    char key[sizeof(HH__btree_str_t)], last[sizeof(HH__btree_str_t)];
+    for(size_t i = 0, j = 0; i < count; ++i) {
+        HH__btree_node_t* leaf = level[i] = HH__btree_node(tree, 1);
+        size_t end = n * (i + 1) / count;
+        for(; j < end; ++j) {
+            if(tree->opt.kind == HH_BTREE_STR) {
+                const char* str = ((const char* const*) keys)[j];
+                HH__btree_str_t key_str = { .ptr = str, .len = strlen(str) };
+                memcpy(key, &key_str, sizeof(HH__btree_str_t));
+            } else memcpy(key, (const int64_t*) keys + j, sizeof(int64_t));
+            HH_ASSERT(j == 0 || HH__btree_comp(tree, last, key) < 0, "hh_btree_load requires sorted, distinct keys");
+            memcpy(last, key, ks);
+            HH__btree_keycopy(tree, HH__BTREE_KEYS(leaf) + leaf->len * ks, key);
+            HH__btree_valcopy(tree, HH__btree_vals(tree, leaf) + leaf->len * vs, (vals == NULL) ? NULL : (const char*) vals + j * vs);
+            ++(leaf->len);
+        }
+        if(prev != NULL) prev->next = leaf;
+        prev = leaf;
+    }
+    // build the inner levels bottom-up, the separator of a child is the smallest key below it
+    while(count > 1) {
+        size_t parents = (count + tree->inner_cap) / (tree->inner_cap + 1);
+        for(size_t i = 0, j = 0; i < parents; ++i) {
+            HH__btree_node_t* node = HH__btree_node(tree, 0);
+            size_t end = count * (i + 1) / parents;
+            HH__btree_children(tree, node)[0] = level[j++];
+            for(; j < end; ++j) {
+                HH__btree_node_t* leftmost = level[j];
+                while(!leftmost->leaf) leftmost = HH__btree_children(tree, leftmost)[0];
+                HH__btree_keycopy(tree, key, HH__BTREE_KEYS(leftmost));
+                HH__btree_innerinsert(tree, node, node->len, key, level[j]);
+            }
+            level[i] = node;
+        }
+        count = parents;
+    }
+    tree->root = level[0];
+    tree->len = n;
+    HH__release(NULL, level, leaves * sizeof(HH__btree_node_t*));
+}
+
+size_t
+hh_btree_len(const hh_btree_t* tree) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    return tree->len;
+}
+
+hh_btree_cursor_t
+hh_btree_first(const hh_btree_t* tree) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* node = tree->root;
+    while(node != NULL && !node->leaf) node = HH__btree_children(tree, node)[0];
+    if(node == NULL) return (hh_btree_cursor_t) { .tree = tree };
+    return HH__btree_cursor(tree, node, 0);
+}
+
+void
+hh_btree_next(hh_btree_cursor_t* cursor) {
+    HH_ASSERT_INVARIANT(cursor != NULL && cursor->leaf != NULL);
+    *cursor = HH__btree_cursor(cursor->tree, cursor->leaf, cursor->idx + 1);
+}
+
+int64_t
+hh_btree_key_int(hh_btree_cursor_t cursor) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    int64_t key;
+    memcpy(&key, HH__BTREE_KEYS((HH__btree_node_t*) cursor.leaf) + cursor.idx * sizeof(int64_t), sizeof(int64_t));
+    return key;
+}
+
+const char*
+hh_btree_key_str(hh_btree_cursor_t cursor, size_t* len) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    HH__btree_str_t key;
+    memcpy(&key, HH__BTREE_KEYS((HH__btree_node_t*) cursor.leaf) + cursor.idx * sizeof(HH__btree_str_t), sizeof(key));
+    if(len != NULL) *len = key.len;
+    return key.ptr;
+}
+
+void*
+hh_btree_val(hh_btree_cursor_t cursor) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    return HH__btree_vals(cursor.tree, cursor.leaf) + cursor.idx * cursor.tree->opt.val_size;
+}
+
+void
+hh_btree_free(hh_btree_t* tree) {
+    if(tree == NULL) return;
+    hh_arena_free(&(tree->arena));
+    hh_btree_opt opt = tree->opt;
+    memset(tree, 0, sizeof(hh_btree_t));
+    tree->opt = opt;
+}
+
+static void
+HH__hsetkeyset(void* entry, size_t sz_key, uint64_t key) {
+    switch(sz_key) {
+        case 1: *((uint8_t*) entry) = (uint8_t) key; break;
+        case 2: *((uint16_t*) entry) = (uint16_t) key; break;
+        case 4: *((uint32_t*) entry) = (uint32_t) key; break;
+        default: *((uint64_t*) entry) = key; break;
+    }
+}
+
+static inline size_t
+HH__hsetsize(size_t cap, size_t sz_entry) {
+    return sizeof(hh_hsetheader_t) + (cap + 1) * sz_entry;
+}
+
+// (re)allocates the table with `cap` slots and re-inserts every entry
+// a new set allocates through alloc (NULL for the global allocator), an existing one keeps its own
+static hh_hsetheader_t*
+HH__hsetresize(void** set_ptr, size_t sz_key, size_t sz_entry, size_t cap, const hh_allocator_t* alloc) {
+    if(set_ptr[0] != NULL) alloc = hh_hsetheader(set_ptr[0])->alloc;
+    else if(alloc == NULL) alloc = HH__allocator_global;
+    // custom allocators don't have to return zeroed memory
+    hh_hsetheader_t* set_hdr = HH__alloc(alloc, HH__hsetsize(cap, sz_entry), "hsetinsert");
+    memset(set_hdr, 0, HH__hsetsize(cap, sz_entry));
+    set_hdr->alloc = alloc;
+    set_hdr->sz_key = sz_key;
+    set_hdr->sz_entry = sz_entry;
+    set_hdr->cap = cap;
+    set_hdr->last = SIZE_MAX;
+    set_hdr->shift = 64;
+    for(size_t c = cap; c > 1; c >>= 1) --(set_hdr->shift);
+    char* slots = (char*) (set_hdr + 1);
+    if(set_ptr[0] != NULL) {
+        hh_hsetheader_t* old_hdr = hh_hsetheader(set_ptr[0]);
+        const char* old = set_ptr[0];
+        size_t mask = cap - 1;
+        for(size_t j = 0; j < old_hdr->cap && old_hdr->len > 0; ++j) {
+            uint64_t key = HH__hsetkey(old + j * sz_entry, sz_key);
+            if(key == 0) continue;
+            size_t i = HH__hsethome(set_hdr, key);
+            while(HH__hsetkey(slots + i * sz_entry, sz_key) != 0) i = (i + 1) & mask;
+            memcpy(slots + i * sz_entry, old + j * sz_entry, sz_entry);
+        }
+        memcpy(slots + cap * sz_entry, old + old_hdr->cap * sz_entry, sz_entry);
+        set_hdr->len = old_hdr->len;
+        set_hdr->zero = old_hdr->zero;
+        HH__release(alloc, old_hdr, HH__hsetsize(old_hdr->cap, old_hdr->sz_entry));
+    }
+    set_ptr[0] = slots;
+    return set_hdr;
+}
+
+// smallest table that holds n keys below HH_HSET_MAX_LOAD
+static size_t
+HH__hsetcap(size_t n) {
+    size_t cap = HH_DARR_INITIAL_CAPACITY;
+    while((double) cap * HH_HSET_MAX_LOAD < (double) n) cap *= 2;
+    return cap;
+}
+
+_Bool
+HH__hsetinsert(void** set_ptr, size_t sz_key, size_t sz_entry, uint64_t key) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    HH_ASSERT(sz_key == 1 || sz_key == 2 || sz_key == 4 || sz_key == 8,
+        "hh_hset requires integer keys, received a key of %zu bytes", sz_key);
+    hh_hsetheader_t* set_hdr = (set_ptr[0] == NULL) ? \
+        HH__hsetresize(set_ptr, sz_key, sz_entry, HH__hsetcap(0), NULL) : \
+        hh_hsetheader(set_ptr[0]);
+    // a set created by hh_hsetreserve learns its key size here
+    if(set_hdr->sz_key == 0) set_hdr->sz_key = sz_key;
+    key = HH__hsetnorm(key, sz_key);
+    size_t idx = HH__hsetfind(set_ptr[0], key);
+    if(idx != SIZE_MAX) {
+        set_hdr->last = idx;
+        return 0;
+    }
+    if(key == 0) {
+        set_hdr->zero = 1;
+        idx = set_hdr->cap;
+    } else {
+        if((double) (set_hdr->len + 1) > (double) set_hdr->cap * HH_HSET_MAX_LOAD)
+            set_hdr = HH__hsetresize(set_ptr, sz_key, sz_entry, set_hdr->cap * 2, NULL);
+        size_t mask = set_hdr->cap - 1;
+        char* slots = set_ptr[0];
+        idx = HH__hsethome(set_hdr, key);
+        while(HH__hsetkey(slots + idx * sz_entry, sz_key) != 0) idx = (idx + 1) & mask;
+    }
+    char* entry = (char*) set_ptr[0] + idx * sz_entry;
+    memset(entry, 0, sz_entry);
+    HH__hsetkeyset(entry, sz_key, key);
+    ++(set_hdr->len);
+    set_hdr->last = idx;
+    return 1;
+}
+
+_Bool
+HH__hsetremove(void* set, uint64_t key) {
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    size_t idx = HH__hsetfind(set, key);
+    if(idx == SIZE_MAX) return 0;
+    char* slots = set;
+    size_t sz_entry = set_hdr->sz_entry, mask = set_hdr->cap - 1;
+    --(set_hdr->len);
+    if(idx == set_hdr->cap) {
+        set_hdr->zero = 0;
+        memset(slots + idx * sz_entry, 0, sz_entry);
+        return 1;
+    }
+    // backward shift deletion: later keys of the run move into the gap
+    // unless that would place them in front of their home slot, so no tombstones are needed
+    for(size_t j = (idx + 1) & mask;; j = (j + 1) & mask) {
+        uint64_t other = HH__hsetkey(slots + j * sz_entry, set_hdr->sz_key);
+        if(other == 0) break;
+        size_t home = HH__hsethome(set_hdr, other);
+        // distance from home to j must cover the gap at idx
+        if(((j - home) & mask) < ((j - idx) & mask)) continue;
+        memcpy(slots + idx * sz_entry, slots + j * sz_entry, sz_entry);
+        idx = j;
+    }
+    memset(slots + idx * sz_entry, 0, sz_entry);
+    return 1;
+}
+
+void
+HH__hsetreserve(void** set_ptr, size_t sz_entry, size_t n) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    size_t cap = HH__hsetcap(n);
+    if(set_ptr[0] == NULL) {
+        // the key size (0 for now) is unknown until the first insert,
+        // no key can be found until then
+        HH__hsetresize(set_ptr, 0, sz_entry, cap, NULL);
+        return;
+    }
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set_ptr[0]);
+    if(cap > set_hdr->cap) HH__hsetresize(set_ptr, set_hdr->sz_key, sz_entry, cap, NULL);
+}
+
+void
+HH__hsetinit(void** set_ptr, size_t sz_entry, const hh_allocator_t* alloc) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    HH_ASSERT(*set_ptr == NULL, "hh_hsetinit requires an empty (NULL) set");
+    // the key size is learned on the first insert, as for hh_hsetreserve
+    HH__hsetresize(set_ptr, 0, sz_entry, HH__hsetcap(0), alloc);
+}
+
+_Bool
+HH__hsetvalid(const void* set, size_t idx) {
+    if(set == NULL) return 0;
+    const hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    if(idx == set_hdr->cap) return set_hdr->zero;
+    return idx < set_hdr->cap && HH__hsetkey((const char*) set + idx * set_hdr->sz_entry, set_hdr->sz_key) != 0;
+}
+
+void
+HH__hsetfree(void* set) {
+    if(set == NULL) return;
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    HH__release(set_hdr->alloc, set_hdr, HH__hsetsize(set_hdr->cap, set_hdr->sz_entry));
+}
+
+size_t
+HH__intern_hash(const void* ptr, size_t sz, size_t seed) {
+    (void) sz;
+    const HH__intern_key_t* key = ptr;
+    return hh_hash_wide(key->ptr, key->len, seed);
+}
+
+int
+HH__intern_comp(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    const HH__intern_key_t* key_fst = fst;
+    const HH__intern_key_t* key_snd = snd;
+    if(key_fst->len != key_snd->len) return 1;
+    return memcmp(key_fst->ptr, key_snd->ptr, key_fst->len);
+}
+
+uint32_t
+hh_intern(hh_intern_t* in, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_intern_n(in, str, strlen(str));
+}
+
+uint32_t
+hh_intern_n(hh_intern_t* in, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT_INVARIANT(str != NULL || len == 0);
+    if(in->index == NULL) {
+        hh_hmapconfig(in->index, .key_f.hash = HH__intern_hash,
+            .key_f.comp = HH__intern_comp, .layout = HH_HMAP_FLAT);
+    }
+    HH__intern_key_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    size_t hash = hh_hmaphash(in->index, &key);
+    size_t idx = hh_hmapget_hashed(in->index, &key, hash);
+    if(idx != SIZE_MAX) return (uint32_t) idx;
+    HH_ASSERT(hh_hmaplen(in->index) < HH_INTERN_NONE, "hh_intern ran out of IDs");
+    // copy the string into the arena
+    char* copy = hh_arena_alloc(&(in->arena), len + 1);
+    HH_ASSERT(copy != NULL, "hh_intern failed to allocate");
+    memcpy(copy, key.ptr, len);
+    copy[len] = '\0';
+    key.ptr = copy;
+    uint32_t id = (uint32_t) hh_hmaplen(in->index);
+    (void) hh_hmapinsert_hashed(in->index, &key, id, hash);
+    return id;
+}
+
+uint32_t
+hh_intern_find(const hh_intern_t* in, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_intern_find_n(in, str, strlen(str));
+}
+
+uint32_t
+hh_intern_find_n(const hh_intern_t* in, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    if(in->index == NULL) return HH_INTERN_NONE;
+    HH__intern_key_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    size_t idx = hh_hmapget(in->index, &key);
+    return (idx == SIZE_MAX) ? HH_INTERN_NONE : (uint32_t) idx;
+}
+
+const char*
+hh_intern_str(const hh_intern_t* in, uint32_t id) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT(id < hh_intern_count(in), "hh_intern_str received an unknown ID: %u", id);
+    return in->index[id].key.ptr;
+}
+
+size_t
+hh_intern_len(const hh_intern_t* in, uint32_t id) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT(id < hh_intern_count(in), "hh_intern_len received an unknown ID: %u", id);
+    return in->index[id].key.len;
+}
+
+void
+hh_intern_free(hh_intern_t* in) {
+    if(in == NULL) return;
+    hh_hmapfree(in->index);
+    hh_arena_free(&(in->arena));
+    memset(in, 0, sizeof(hh_intern_t));
+}
+
+size_t
+HH__lru_hash(const void* ptr, size_t sz, size_t seed) {
+    (void) sz;
+    const HH__lru_key_t* key = ptr;
+    return hh_hash_wide(key->ptr, key->len, seed);
+}
+
+int
+HH__lru_comp(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    const HH__lru_key_t* key_fst = fst;
+    const HH__lru_key_t* key_snd = snd;
+    if(key_fst->len != key_snd->len) return 1;
+    return memcmp(key_fst->ptr, key_snd->ptr, key_fst->len);
+}
+
+// size class of a key block, HH__LRU_CLASSES if it is too long for the free lists
+static size_t
+HH__lru_class(size_t len) {
+    size_t cls = 0;
+    while(cls < HH__LRU_CLASSES && ((size_t) 8 << cls) < len) ++cls;
+    return cls;
+}
+
+static const char*
+HH__lru_keycopy(hh_lru_t* lru, const void* key, size_t len) {
+    size_t cls = HH__lru_class(len);
+    char* copy;
+    if(cls == HH__LRU_CLASSES) {
+        copy = malloc(len);
+    } else if(lru->free_keys[cls] != NULL) {
+        // the first word of a free block links to the next one
+        copy = lru->free_keys[cls];
+        memcpy(&(lru->free_keys[cls]), copy, sizeof(void*));
+    } else {
+        copy = hh_arena_alloc(&(lru->arena), (size_t) 8 << cls);
+    }
+    HH_ASSERT(copy != NULL, "hh_lru_put failed to allocate");
+    if(len > 0) memcpy(copy, key, len);
+    return copy;
+}
+
+static void
+HH__lru_keyfree(hh_lru_t* lru, const HH__lru_key_t* key) {
+    size_t cls = HH__lru_class(key->len);
+    if(cls == HH__LRU_CLASSES) {
+        free((void*) key->ptr);
+        return;
+    }
+    memcpy((void*) key->ptr, &(lru->free_keys[cls]), sizeof(void*));
+    lru->free_keys[cls] = (void*) key->ptr;
+}
+
+// takes entry idx off the recency list
+static void
+HH__lru_unlink(hh_lru_t* lru, size_t idx) {
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    if(node->prev == SIZE_MAX) lru->head = node->next;
+    else lru->index[node->prev].val.next = node->next;
+    if(node->next == SIZE_MAX) lru->tail = node->prev;
+    else lru->index[node->next].val.prev = node->prev;
+}
+
+// puts entry idx at the front of the recency list
+static void
+HH__lru_link(hh_lru_t* lru, size_t idx) {
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    node->prev = SIZE_MAX;
+    // idx is the only linked entry
+    if(hh_hmaplen(lru->index) == 1) {
+        node->next = SIZE_MAX;
+        lru->head = lru->tail = idx;
+        return;
+    }
+    node->next = lru->head;
+    lru->index[lru->head].val.prev = idx;
+    lru->head = idx;
 }
 
-_Bool
-hh_has_prefix(const char* str, const char* prefix) {
-    return strncmp(str, prefix, strlen(prefix)) == 0;
+// removes (the already unlinked) entry idx from the index and releases its key
+// the hmap fills the gap with its last entry, whose neighbours are pointed at its new index
+static void
+HH__lru_removeat(hh_lru_t* lru, size_t idx) {
+    HH__lru_keyfree(lru, &(lru->index[idx].key));
+    lru->bytes -= lru->index[idx].val.size;
+    size_t last = hh_hmaplen(lru->index) - 1;
+    HH__hmapremoveat(lru->index, idx);
+    if(idx == last) return;
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    if(node->prev == SIZE_MAX) lru->head = idx;
+    else lru->index[node->prev].val.next = idx;
+    if(node->next == SIZE_MAX) lru->tail = idx;
+    else lru->index[node->next].val.prev = idx;
 }
 
-_Bool
-hh_has_suffix(const char* str, const char* suffix) {
-    size_t len_str = strlen(str);
-    size_t len_suffix = strlen(suffix);
-    return len_suffix <= len_str && !strcmp(str + len_str - len_suffix, suffix);
+// evicts least recently used entries until the cache is within its limits
+// keep_head spares the most recently used entry, i.e. the one hh_lru_put just stored
+static void
+HH__lru_trim(hh_lru_t* lru, _Bool keep_head) {
+    while(hh_hmaplen(lru->index) > (keep_head ? 1u : 0u) &&
+        ((lru->opt.max_entries > 0 && hh_hmaplen(lru->index) > lru->opt.max_entries) ||
+        (lru->opt.max_bytes > 0 && lru->bytes > lru->opt.max_bytes))) {
+        size_t idx = lru->tail;
+        HH__lru_unlink(lru, idx);
+        if(lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[idx].key.ptr, lru->index[idx].key.len, lru->index[idx].val.val, lru->opt.ctx);
+        }
+        ++(lru->evictions);
+        HH__lru_removeat(lru, idx);
+    }
 }
 
-// NOTE: Great information by Raymond Chen found here:
-// https://devblogs.microsoft.com/oldnewthing/20260101-00/?p=111955
 void
-hh_memswap(char* fst, char* fst_end, char* snd, const char* snd_end) {
-    HH_ASSERT_INVARIANT(fst != NULL);
-    HH_ASSERT_INVARIANT(fst_end != NULL);
-    HH_ASSERT_INVARIANT(snd != NULL);
-    HH_ASSERT_INVARIANT(snd_end != NULL);
-    HH_ASSERT_INVARIANT(fst <= fst_end);
-    HH_ASSERT_INVARIANT(fst_end <= snd);
-    HH_ASSERT_INVARIANT(snd <= snd_end);
-    hh_memflip(fst, fst_end);
-    hh_memflip(fst_end, snd);
-    hh_memflip(snd, snd_end);
-    hh_memflip(fst, snd_end);
+HH__lru_config(hh_lru_t* lru, hh_lru_opt opt) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    lru->opt = opt;
+    HH__lru_trim(lru, 0);
 }
 
-void 
-hh_memflip(char* ptr, const char* end) {
-    HH_ASSERT_INVARIANT(ptr != NULL);
-    HH_ASSERT_INVARIANT(end != NULL);
-    HH_ASSERT_INVARIANT(ptr <= end);
-    hh_memflipn(ptr, (size_t) (end - ptr));
+void*
+hh_lru_get(hh_lru_t* lru, const void* key, size_t len) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t idx = (lru->index == NULL) ? SIZE_MAX : hh_hmapget(lru->index, &probe);
+    if(idx == SIZE_MAX) {
+        ++(lru->misses);
+        return NULL;
+    }
+    ++(lru->hits);
+    if(idx != lru->head) {
+        HH__lru_unlink(lru, idx);
+        HH__lru_link(lru, idx);
+    }
+    return lru->index[idx].val.val;
 }
 
-void 
-hh_memflipn(char* ptr, size_t n) {
-    HH_ASSERT_INVARIANT(ptr != NULL);
-    if(n == 0) return;
-    char temp;
-    for(size_t i = 0; i < n / 2; ++i) {
-        temp = ptr[i];
-        ptr[i] = ptr[n - 1 - i];
-        ptr[n - 1 - i] = temp;
+void
+hh_lru_put(hh_lru_t* lru, const void* key, size_t len, void* val, size_t size) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    if(lru->index == NULL) {
+        hh_hmapconfig(lru->index, .key_f.hash = HH__lru_hash,
+            .key_f.comp = HH__lru_comp, .layout = HH_HMAP_FLAT);
+    }
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t hash = hh_hmaphash(lru->index, &probe);
+    size_t idx = hh_hmapget_hashed(lru->index, &probe, hash);
+    if(idx != SIZE_MAX) {
+        HH__lru_node_t* node = &(lru->index[idx].val);
+        if(node->val != val && lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[idx].key.ptr, len, node->val, lru->opt.ctx);
+        }
+        lru->bytes = lru->bytes - node->size + size;
+        node->val = val;
+        node->size = size;
+        HH__lru_unlink(lru, idx);
+    } else {
+        probe.ptr = HH__lru_keycopy(lru, probe.ptr, len);
+        (void) hh_hmapinsert_hashed(lru->index, &probe, ((HH__lru_node_t) { .val = val, .size = size }), hash);
+        idx = hh_hmaplen(lru->index) - 1;
+        lru->bytes += size;
     }
+    HH__lru_link(lru, idx);
+    HH__lru_trim(lru, 1);
 }
 
-/*-
- * Copyright (c) 2011 The NetBSD Foundation, Inc.
- * All rights reserved.
- *
- * This code is derived from software contributed to The NetBSD Foundation
- * by Christos Zoulas.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *
- * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
- * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
- * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
- * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
- * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
- * POSSIBILITY OF SUCH DAMAGE.
- */
+void*
+hh_lru_remove(hh_lru_t* lru, const void* key, size_t len) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t idx = (lru->index == NULL) ? SIZE_MAX : hh_hmapget(lru->index, &probe);
+    if(idx == SIZE_MAX) return NULL;
+    void* val = lru->index[idx].val.val;
+    HH__lru_unlink(lru, idx);
+    HH__lru_removeat(lru, idx);
+    return val;
+}
 
-ptrdiff_t
-hh_getdelim(char** buf, size_t* bufsiz, int delimiter, FILE* fp) {
-    char *ptr, *eptr;
-    if(*buf == NULL || *bufsiz == 0) {
-        *bufsiz = BUFSIZ;
-        if((*buf = (char*) malloc(*bufsiz)) == NULL) return -1;
+size_t
+hh_lru_len(const hh_lru_t* lru) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    return hh_hmaplen(lru->index);
+}
+
+hh_lru_stats_t
+hh_lru_stats(const hh_lru_t* lru) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    return (hh_lru_stats_t) {
+        .len = hh_hmaplen(lru->index), .bytes = lru->bytes,
+        .hits = lru->hits, .misses = lru->misses, .evictions = lru->evictions
+    };
+}
+
+void
+hh_lru_free(hh_lru_t* lru) {
+    if(lru == NULL) return;
+    for(size_t i = 0; i < hh_hmaplen(lru->index); ++i) {
+        if(lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[i].key.ptr, lru->index[i].key.len, lru->index[i].val.val, lru->opt.ctx);
+        }
+        // only long keys live outside the arena
+        if(HH__lru_class(lru->index[i].key.len) == HH__LRU_CLASSES) free((void*) lru->index[i].key.ptr);
     }
-    for(ptr = *buf, eptr = *buf + *bufsiz;;) {
-        int c = fgetc(fp);
-        if(c == -1) {
-            if(feof(fp)) {
-                ptrdiff_t diff = ptr - *buf;
-                if(diff != 0) {
-                    *ptr = '\0';
-                    return diff;
-                }
+    hh_hmapfree(lru->index);
+    hh_arena_free(&(lru->arena));
+    memset(lru, 0, sizeof(hh_lru_t));
+}
+
+typedef struct {
+    uint64_t hash;
+    size_t bucket, idx;
+} HH__perfectkey_t;
+
+typedef struct {
+    size_t start, len;
+} HH__perfectrange_t;
+
+static int
+HH__perfectkeycomp(const void* fst, const void* snd) {
+    const HH__perfectkey_t* key_fst = fst;
+    const HH__perfectkey_t* key_snd = snd;
+    if(key_fst->bucket != key_snd->bucket) return (key_fst->bucket > key_snd->bucket) ? 1 : -1;
+    return (key_fst->hash > key_snd->hash) - (key_fst->hash < key_snd->hash);
+}
+
+// largest buckets first, they are the hardest to place
+static int
+HH__perfectrangecomp(const void* fst, const void* snd) {
+    const HH__perfectrange_t* range_fst = fst;
+    const HH__perfectrange_t* range_snd = snd;
+    if(range_fst->len != range_snd->len) return (range_fst->len < range_snd->len) ? 1 : -1;
+    return (range_fst->start > range_snd->start) - (range_fst->start < range_snd->start);
+}
+
+// places every bucket, returns falsy if some bucket can't be placed with this seed
+static _Bool
+HH__perfectplace(const HH__perfectkey_t* order, const HH__perfectrange_t* ranges, size_t range_count,
+    size_t n, uint32_t* pilots, size_t* slot_of, unsigned char* taken) {
+    memset(taken, 0, n);
+    for(size_t r = 0; r < range_count; ++r) {
+        const HH__perfectkey_t* bucket = order + ranges[r].start;
+        size_t len = ranges[r].len;
+        uint32_t pilot = 0;
+        for(; pilot < HH__PERFECT_MAX_PILOT; ++pilot) {
+            size_t i = 0;
+            for(; i < len; ++i) {
+                size_t slot = HH__perfectslot(bucket[i].hash, pilot, n);
+                if(taken[slot]) break;
+                // claim slots as we go, so keys of the same bucket can't share one
+                taken[slot] = 1;
+                slot_of[bucket[i].idx] = slot;
             }
-            return -1;
+            if(i == len) break;
+            while(i-- > 0) taken[slot_of[bucket[i].idx]] = 0;
         }
-        *ptr++ = (char) c;
-        if(c == delimiter) {
-            *ptr = '\0';
-            return ptr - *buf;
+        if(pilot == HH__PERFECT_MAX_PILOT) return 0;
+        pilots[bucket[0].bucket] = pilot;
+    }
+    return 1;
+}
+
+_Bool
+hh_perfect_build(hh_perfect_t* table, const char* const* keys, size_t n) {
+    HH_ASSERT_INVARIANT(table != NULL);
+    HH_ASSERT_INVARIANT(keys != NULL || n == 0);
+    HH_ASSERT(n < UINT32_MAX, "hh_perfect_build received too many keys");
+    size_t bucket_count = n / HH_PERFECT_BUCKET_SIZE + 1, chars = 0;
+    for(size_t i = 0; i < n; ++i) chars += strlen(keys[i]);
+    HH_ASSERT(chars < UINT32_MAX, "hh_perfect_build received too many characters");
+    HH__perfectkey_t* order = malloc(n * sizeof(HH__perfectkey_t) + 1);
+    HH__perfectrange_t* ranges = malloc(bucket_count * sizeof(HH__perfectrange_t));
+    size_t* slot_of = malloc(n * sizeof(size_t) + 1);
+    unsigned char* taken = malloc(n + 1);
+    HH_ASSERT(order != NULL && ranges != NULL && slot_of != NULL && taken != NULL,
+        "hh_perfect_build failed to allocate");
+    // a single allocation holds the pilots, ids, offsets and characters
+    size_t size = (bucket_count + 2 * n + 1) * sizeof(uint32_t) + chars;
+    char* mem = malloc(size);
+    HH_ASSERT(mem != NULL, "hh_perfect_build failed to allocate");
+    uint32_t* pilots = (uint32_t*) mem;
+    uint32_t* ids = pilots + bucket_count;
+    uint32_t* offs = ids + n;
+    char* heap = (char*) (offs + n + 1);
+    size_t seed = 0, range_count = 0, attempt = 0;
+    for(; attempt < HH__PERFECT_MAX_SEED; ++attempt) {
+        seed = hh_hash_int(attempt, 0x5EED);
+        for(size_t i = 0; i < n; ++i) {
+            uint64_t hash = (uint64_t) hh_hash_wide(keys[i], strlen(keys[i]), seed);
+            order[i] = (HH__perfectkey_t) { .hash = hash, .bucket = HH__perfectbucket(hash, bucket_count), .idx = i };
         }
-        if(ptr + 2 >= eptr) {
-            char *nbuf;
-            size_t nbufsiz = *bufsiz * 2;
-            ptrdiff_t d = ptr - *buf;
-            if((nbuf = (char*) realloc(*buf, nbufsiz)) == NULL) return -1;
-            *buf = nbuf;
-            *bufsiz = nbufsiz;
-            eptr = nbuf + nbufsiz;
-            ptr = nbuf + d;
+        qsort(order, n, sizeof(HH__perfectkey_t), HH__perfectkeycomp);
+        // keys with equal hashes can never be separated
+        size_t i = 1;
+        for(; i < n && order[i].hash != order[i - 1].hash; ++i);
+        if(i < n) {
+            if(strcmp(keys[order[i].idx], keys[order[i - 1].idx]) != 0) continue;
+            HH_ERR("hh_perfect_build received a duplicate key [%s].", keys[order[i].idx]);
+            attempt = HH__PERFECT_MAX_SEED;
+            break;
         }
+        range_count = 0;
+        for(size_t start = 0; start < n; start = i) {
+            for(i = start + 1; i < n && order[i].bucket == order[start].bucket; ++i);
+            ranges[range_count++] = (HH__perfectrange_t) { .start = start, .len = i - start };
+        }
+        qsort(ranges, range_count, sizeof(HH__perfectrange_t), HH__perfectrangecomp);
+        memset(pilots, 0, bucket_count * sizeof(uint32_t));
+        if(HH__perfectplace(order, ranges, range_count, n, pilots, slot_of, taken)) break;
+    }
+    free(order);
+    free(ranges);
+    free(taken);
+    if(attempt == HH__PERFECT_MAX_SEED) {
+        free(slot_of);
+        free(mem);
+        return 0;
     }
+    // lay the keys out in slot order
+    for(size_t i = 0; i < n; ++i) ids[slot_of[i]] = (uint32_t) i;
+    offs[0] = 0;
+    for(size_t slot = 0; slot < n; ++slot) {
+        size_t len = strlen(keys[ids[slot]]);
+        memcpy(heap + offs[slot], keys[ids[slot]], len);
+        offs[slot + 1] = offs[slot] + (uint32_t) len;
+    }
+    free(slot_of);
+    hh_perfect_free(table);
+    *table = (hh_perfect_t) {
+        .count = n, .bucket_count = bucket_count, .seed = seed,
+        .pilots = pilots, .ids = ids, .offs = offs, .chars = heap, .mem = mem
+    };
+    return 1;
 }
 
-ptrdiff_t
-hh_getline(char** buf, size_t* bufsiz, FILE* fp) {
-    return hh_getdelim(buf, bufsiz, '\n', fp);
+uint32_t
+hh_perfect_find(const hh_perfect_t* table, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_perfect_find_n(table, str, strlen(str));
 }
 
-/*-
- * Copyright (c) 2009 David Schultz <das@FreeBSD.org>
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
- * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
- * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
- * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
- * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
- * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
- * SUCH DAMAGE.
- */
+uint32_t
+hh_perfect_find_n(const hh_perfect_t* table, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(table != NULL);
+    if(table->count == 0) return HH_PERFECT_NONE;
+    uint64_t hash = (uint64_t) hh_hash_wide(str, len, table->seed);
+    size_t slot = HH__perfectslot(hash, table->pilots[HH__perfectbucket(hash, table->bucket_count)], table->count);
+    const char* key = table->chars + table->offs[slot];
+    if(table->offs[slot + 1] - table->offs[slot] != len || memcmp(key, str, len) != 0) return HH_PERFECT_NONE;
+    return table->ids[slot];
+}
 
-size_t
-hh_strnlen(const char *s, size_t maxlen) {
-	size_t len;
-	for(len = 0; len < maxlen; len++, s++) {
-		if(!*s) break;
-	}
-	return (len);
+// writes an array of uint32_t as a C initializer
+static void
+HH__perfectemitarr(FILE* f, const char* name, const char* suffix, const uint32_t* arr, size_t n) {
+    fprintf(f, "static const uint32_t %s_%s[] = {", name, suffix);
+    for(size_t i = 0; i < n; ++i) fprintf(f, "%s%luu,", (i % 8 == 0) ? "\n    " : " ", (unsigned long) arr[i]);
+    // an empty initializer isn't valid C99
+    if(n == 0) fprintf(f, " 0");
+    fprintf(f, "\n};\n");
+}
+
+_Bool
+hh_perfect_emit(const hh_perfect_t* table, const char* name, const char* path) {
+    HH_ASSERT_INVARIANT(table != NULL && name != NULL && path != NULL);
+    FILE* f = fopen(path, "w");
+    if(f == NULL) {
+        HH_ERR("Failed to open file at path [%s].", path);
+        return 0;
+    }
+    fprintf(f, "// generated by hh_perfect_emit, %zu keys\n", table->count);
+    fprintf(f, "#if SIZE_MAX != %zuu\n#error \"%s was generated for a different word size\"\n#endif\n",
+        (size_t) SIZE_MAX, name);
+    HH__perfectemitarr(f, name, "pilots", table->pilots, table->bucket_count);
+    HH__perfectemitarr(f, name, "ids", table->ids, table->count);
+    // a table that was never built has no offsets at all
+    HH__perfectemitarr(f, name, "offs", table->offs, (table->offs == NULL) ? 0 : table->count + 1);
+    size_t chars = (table->offs == NULL) ? 0 : table->offs[table->count];
+    fprintf(f, "static const char %s_chars[] = {", name);
+    for(size_t i = 0; i < chars; ++i) fprintf(f, "%s%d,", (i % 16 == 0) ? "\n    " : " ", (int) table->chars[i]);
+    if(chars == 0) fprintf(f, " 0");
+    fprintf(f, "\n};\n");
+    fprintf(f, "static const hh_perfect_t %s = {\n", name);
+    fprintf(f, "    .count = %zu, .bucket_count = %zu, .seed = %zuu,\n", table->count, table->bucket_count, table->seed);
+    fprintf(f, "    .pilots = %s_pilots, .ids = %s_ids, .offs = %s_offs, .chars = %s_chars\n};\n",
+        name, name, name, name);
+    _Bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = 0;
+    if(!ok) {
+        HH_ERR("Failed to write file at path [%s].", path);
+    }
+    return ok;
+}
+
+void
+hh_perfect_free(hh_perfect_t* table) {
+    if(table == NULL) return;
+    free(table->mem);
+    memset(table, 0, sizeof(hh_perfect_t));
 }
 
 void
@@ -1531,19 +5387,192 @@ hh_profiler_end(hh_profiler_t* profiler) {
         hh_darrput(root->inner.stats.keys, '\0');
         HH__profiler_full_name(root, profiler);
         const char* key = root->inner.stats.keys + offset;
-        // check if it's the first iteration
-        size_t idx = hh_hmapget(root->inner.stats.inner, &key);
-        if(idx == SIZE_MAX) {
-            // insert the first data point for this profiler
-            hh_bench_t bench = { .mean = elapsed, .count = 1 };
-            hh_hmapinsert(root->inner.stats.inner, &key, bench);
+        // a zeroed bench is inserted on the first iteration
+        hh_bench_t* bench = hh_hmapupsert(root->inner.stats.inner, &key);
+        // if the key already existed, remove the one we constructed
+        if(bench->count > 0) hh_darrheader(root->inner.stats.keys)->len = offset;
+        // compute incremental mean
+        hh_bench_update(bench, elapsed);
+    }
+}
+
+#if (HH_SEG_FIRST_CHUNK & (HH_SEG_FIRST_CHUNK - 1)) != 0 || HH_SEG_FIRST_CHUNK <= 0
+#error "HH_SEG_FIRST_CHUNK must be a power of two"
+#endif
+
+#define HH__SEG_CHUNK_LEN(k) ((size_t) HH_SEG_FIRST_CHUNK << (k))
+// index of the first element of chunk k
+#define HH__SEG_CHUNK_START(k) (HH__SEG_CHUNK_LEN(k) - HH_SEG_FIRST_CHUNK)
+
+void
+HH__seg_config(hh_seg_t* seg, hh_seg_opt opt) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->len == 0 && seg->chunks[0] == NULL, "hh_seg_config requires an empty array");
+    HH_ASSERT(opt.elem_size > 0, "hh_seg_config requires a non-zero elem_size");
+    // resolved now, so the chunks are all released through the allocator they came from
+    if(opt.alloc == NULL) opt.alloc = hh_allocator_get();
+    seg->opt = opt;
+}
+
+size_t
+hh_seg_putn(hh_seg_t* seg, const void* src, size_t n) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->opt.elem_size > 0, "hh_seg_putn requires hh_seg_config");
+    size_t first = seg->len;
+    const char* from = src;
+    while(n > 0) {
+        size_t k = HH__seg_log2(seg->len + HH_SEG_FIRST_CHUNK) - HH__seg_log2(HH_SEG_FIRST_CHUNK);
+        if(seg->chunks[k] == NULL) {
+            seg->chunks[k] = HH__alloc(seg->opt.alloc, HH__SEG_CHUNK_LEN(k) * seg->opt.elem_size, "hh_seg_putn");
+        }
+        size_t off = seg->len - HH__SEG_CHUNK_START(k);
+        size_t count = HH__SEG_CHUNK_LEN(k) - off;
+        if(count > n) count = n;
+        // chunks are reused after hh_seg_pop and hh_seg_clear, so they aren't necessarily zeroed
+        char* dst = seg->chunks[k] + off * seg->opt.elem_size;
+        if(from == NULL) {
+            memset(dst, 0, count * seg->opt.elem_size);
         } else {
-            // the key already exists, so remove the one we constructed
-            hh_darrheader(root->inner.stats.keys)->len = offset;
-            // compute incremental mean
-            hh_bench_update(&root->inner.stats.inner[idx].val, elapsed);
+            memcpy(dst, from, count * seg->opt.elem_size);
+            from += count * seg->opt.elem_size;
         }
+        seg->len += count;
+        n -= count;
+    }
+    return first;
+}
+
+void*
+hh_seg_pop(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->len > 0, "hh_seg_pop received an empty array");
+    return HH__seg_at(seg, --(seg->len));
+}
+
+void
+hh_seg_clear(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    seg->len = 0;
+}
+
+size_t
+hh_seg_len(const hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    return seg->len;
+}
+
+size_t
+hh_seg_chunks(const hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    if(seg->len == 0) return 0;
+    return HH__seg_log2(seg->len - 1 + HH_SEG_FIRST_CHUNK) - HH__seg_log2(HH_SEG_FIRST_CHUNK) + 1;
+}
+
+void*
+hh_seg_chunk(const hh_seg_t* seg, size_t k, size_t* len) {
+    HH_ASSERT_INVARIANT(seg != NULL && len != NULL);
+    HH_ASSERT(k < hh_seg_chunks(seg), "hh_seg_chunk received chunk %zu of %zu", k, hh_seg_chunks(seg));
+    size_t rem = seg->len - HH__SEG_CHUNK_START(k);
+    *len = (rem < HH__SEG_CHUNK_LEN(k)) ? rem : HH__SEG_CHUNK_LEN(k);
+    return seg->chunks[k];
+}
+
+void
+hh_seg_free(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    for(size_t k = 0; k < HH__SEG_MAX_CHUNKS && seg->chunks[k] != NULL; ++k) {
+        HH__release(seg->opt.alloc, seg->chunks[k], HH__SEG_CHUNK_LEN(k) * seg->opt.elem_size);
+        seg->chunks[k] = NULL;
+    }
+    seg->len = 0;
+}
+
+void
+HH__slotgrow(void** arr_ptr, size_t elem_size) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    HH_ASSERT_INVARIANT(elem_size > 0);
+    hh_slotheader_t* arr_hdr;
+    if(*arr_ptr == NULL) {
+        const hh_allocator_t* alloc = hh_allocator_get();
+        arr_hdr = HH__alloc(alloc, sizeof(hh_slotheader_t) + elem_size * HH_DARR_INITIAL_CAPACITY, "hh_slotinsert");
+        arr_hdr->free = UINT32_MAX;
+        arr_hdr->darr.cap = HH_DARR_INITIAL_CAPACITY;
+        arr_hdr->darr.elem_size = elem_size;
+        arr_hdr->darr.alloc = alloc;
+        *arr_ptr = (void*) (arr_hdr + 1);
+        return;
+    }
+    arr_hdr = hh_slotheader(*arr_ptr);
+    if(arr_hdr->darr.len < arr_hdr->darr.cap) return;
+    HH_ASSERT(arr_hdr->darr.len < UINT32_MAX - 1, "hh_slotinsert ran out of slots");
+    size_t cap = arr_hdr->darr.cap * 2;
+    arr_hdr = HH__resize(arr_hdr->darr.alloc, arr_hdr, sizeof(hh_slotheader_t) + arr_hdr->darr.cap * elem_size, 
+        sizeof(hh_slotheader_t) + cap * elem_size, "hh_slotinsert");
+    arr_hdr->darr.cap = cap;
+    *arr_ptr = (void*) (arr_hdr + 1);
+}
+
+hh_slot_t
+HH__slotpush(void* arr) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t idx = (uint32_t) (arr_hdr->darr.len)++;
+    uint32_t slot = arr_hdr->free;
+    if(slot == UINT32_MAX) {
+        slot = (uint32_t) hh_darradd(arr_hdr->slots, 1);
+        arr_hdr->slots[slot].gen = 1;
+    } else arr_hdr->free = arr_hdr->slots[slot].idx;
+    arr_hdr->slots[slot].idx = idx;
+    hh_darrput(arr_hdr->owners, slot);
+    return ((hh_slot_t) arr_hdr->slots[slot].gen << 32) | slot;
+}
+
+_Bool
+HH__slotremove(void* arr, hh_slot_t handle) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    size_t idx = HH__slotindex(arr, handle);
+    if(idx == SIZE_MAX) return 0;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = (uint32_t) handle;
+    // move the last value into the hole and repoint its slot
+    size_t last = --(arr_hdr->darr.len);
+    if(idx != last) {
+        size_t elem_size = arr_hdr->darr.elem_size;
+        memcpy((char*) arr + idx * elem_size, (char*) arr + last * elem_size, elem_size);
+        arr_hdr->owners[idx] = arr_hdr->owners[last];
+        arr_hdr->slots[arr_hdr->owners[idx]].idx = (uint32_t) idx;
     }
+    (void) hh_darrpop(arr_hdr->owners);
+    // a new generation makes outstanding handles stale, 0 is skipped on wrap-around
+    if(++(arr_hdr->slots[slot].gen) == 0) arr_hdr->slots[slot].gen = 1;
+    arr_hdr->slots[slot].idx = arr_hdr->free;
+    arr_hdr->free = slot;
+    return 1;
+}
+
+hh_slot_t
+HH__slothandle(const void* arr, size_t idx) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    HH_ASSERT(idx < hh_darrlen(arr), "hh_slothandle received an out-of-bounds index: %zu", idx);
+    const hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = arr_hdr->owners[idx];
+    return ((hh_slot_t) arr_hdr->slots[slot].gen << 32) | slot;
+}
+
+void
+HH__slotclear(void* arr) {
+    if(arr == NULL) return;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    while(arr_hdr->darr.len > 0) (void) HH__slotremove(arr, HH__slothandle(arr, arr_hdr->darr.len - 1));
+}
+
+void
+HH__slotfree(void* arr) {
+    if(arr == NULL) return;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    hh_darrfree(arr_hdr->slots);
+    hh_darrfree(arr_hdr->owners);
+    HH__release(arr_hdr->darr.alloc, arr_hdr, sizeof(hh_slotheader_t) + arr_hdr->darr.cap * arr_hdr->darr.elem_size);
 }
 
 
@@ -1610,10 +5639,10 @@ hh_span_next_opt(hh_span_t* span, hh_span_opt opt) {
 }
 
 size_t 
-hh_hash_span(const void* ptr, size_t sz) {
+hh_hash_span(const void* ptr, size_t sz, size_t seed) {
     (void) sz;
     const hh_span_t* s = ptr;
-    return hh_hash_djb2(s->ptr, hh_span_len(*s));
+    return hh_hash_wide(s->ptr, hh_span_len(*s), seed);
 }
 
 int
@@ -1627,6 +5656,28 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
     if(ret != 0) return ret;
     return (len_fst > len_snd) - (len_fst < len_snd);
 }
+
+static inline int
+HH__comp_span_str(const hh_span_t* span, const char* str) {
+    size_t len = hh_span_len(*span);
+    // the span may hold a NUL, so str is measured first and never read past its terminator
+    size_t len_str = hh_strnlen(str, len + 1);
+    int ret = memcmp(span->ptr, str, HH_MIN(len, len_str));
+    if(ret != 0) return ret;
+    return (len > len_str) - (len < len_str);
+}
+
+int
+hh_comp_span_cstr(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    return HH__comp_span_str(fst, *((const char**) snd));
+}
+
+int
+hh_comp_span_cstr_owned(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    return HH__comp_span_str(fst, (const char*) snd);
+}
 #endif // HH_IMPLEMENTATION
 #endif // HH__
 #ifndef HH__APPLY_PREFIXES
@@ -1654,6 +5705,10 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define malloc_checked hh_malloc_checked
 #define calloc_checked hh_calloc_checked
 #define realloc_checked hh_realloc_checked
+#define allocator_t hh_allocator_t
+#define allocator_checked hh_allocator_checked
+#define allocator_get hh_allocator_get
+#define allocator_set hh_allocator_set
 #define fp_wrap_t hh_fp_wrap_t
 #define fp_wrap hh_fp_wrap
 #define fp_unwrap hh_fp_unwrap
@@ -1664,15 +5719,26 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define darrput hh_darrput
 #define darrpop hh_darrpop
 #define darradd hh_darradd
+#define darradd_uninit hh_darradd_uninit
+#define darrputn hh_darrputn
+#define darrinsertn hh_darrinsertn
+#define darrerasen hh_darrerasen
 #define darrlen hh_darrlen
 #define darrcap hh_darrcap
 #define darrswap hh_darrswap
 #define darrswapdel hh_darrswapdel
+#define darrreserve hh_darrreserve
+#define darrshrink hh_darrshrink
+#define darrinit hh_darrinit
+#define darrinit_aligned hh_darrinit_aligned
+#define DARR_INLINE HH_DARR_INLINE
 #define darrputstr hh_darrputstr
 #define darrputstrn hh_darrputstrn
 #define arena hh_arena
 #define arena_alloc hh_arena_alloc
 #define arena_free hh_arena_free
+#define arena_reset hh_arena_reset
+#define arena_allocator hh_arena_allocator
 #define path_alloc hh_path_alloc
 #define path_exists hh_path_exists
 #define path_is_file hh_path_is_file
@@ -1696,16 +5762,38 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define timer_duration hh_timer_duration
 #define hash_f hh_hash_f
 #define comp_f hh_comp_f
+#define hash_wide hh_hash_wide
+#define hash_wide_str hh_hash_wide_str
 #define hash_djb2 hh_hash_djb2
 #define hash_cstr hh_hash_cstr
 #define comp_cstr hh_comp_cstr
 #define comp_cstr_owned hh_comp_cstr_owned
 #define copy_cstr hh_copy_cstr
 #define hmap_opt hh_hmap_opt
+#define HMAP_CHAINED HH_HMAP_CHAINED
+#define HMAP_FLAT HH_HMAP_FLAT
 #define hmapconfig hh_hmapconfig
 #define hmaplen hh_hmaplen
 #define hmapinsert hh_hmapinsert
 #define hmapget hh_hmapget
+#define hmapget_hashed hh_hmapget_hashed
+#define hmapget_probe hh_hmapget_probe
+#define hmapinsert_hashed hh_hmapinsert_hashed
+#define hmapupsert hh_hmapupsert
+#define hmapget_many hh_hmapget_many
+#define hmapinsert_many hh_hmapinsert_many
+#define hmaphash hh_hmaphash
+#define hmapstats hh_hmapstats
+#define hmapstats_t hh_hmapstats_t
+#define hmapsave hh_hmapsave
+#define hmapload_mapped hh_hmapload_mapped
+#define HMAP_DEFINE HH_HMAP_DEFINE
+#define hash_int hh_hash_int
+#define bloom_t hh_bloom_t
+#define bloom_reserve hh_bloom_reserve
+#define bloom_add hh_bloom_add
+#define bloom_has hh_bloom_has
+#define bloom_free hh_bloom_free
 #define hmapfree hh_hmapfree
 #define hmapremove hh_hmapremove
 #define read_entire_file hh_read_entire_file
@@ -1716,12 +5804,112 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define memflip hh_memflip
 #define memflipn hh_memflipn
 
+#define btree_t hh_btree_t
+#define btree_opt hh_btree_opt
+#define btree_cursor_t hh_btree_cursor_t
+#define BTREE_INT HH_BTREE_INT
+#define BTREE_STR HH_BTREE_STR
+#define btree_config hh_btree_config
+#define btree_put_int hh_btree_put_int
+#define btree_get_int hh_btree_get_int
+#define btree_remove_int hh_btree_remove_int
+#define btree_lower_int hh_btree_lower_int
+#define btree_upper_int hh_btree_upper_int
+#define btree_put_str hh_btree_put_str
+#define btree_get_str hh_btree_get_str
+#define btree_remove_str hh_btree_remove_str
+#define btree_lower_str hh_btree_lower_str
+#define btree_upper_str hh_btree_upper_str
+#define btree_put_span hh_btree_put_span
+#define btree_get_span hh_btree_get_span
+#define btree_lower_span hh_btree_lower_span
+#define btree_upper_span hh_btree_upper_span
+#define btree_load hh_btree_load
+#define btree_len hh_btree_len
+#define btree_first hh_btree_first
+#define btree_valid hh_btree_valid
+#define btree_next hh_btree_next
+#define btree_key_int hh_btree_key_int
+#define btree_key_str hh_btree_key_str
+#define btree_val hh_btree_val
+#define btree_free hh_btree_free
+
+#define hsetlen hh_hsetlen
+#define hsetinsert hh_hsetinsert
+#define hsetput hh_hsetput
+#define hsetget hh_hsetget
+#define hsethas hh_hsethas
+#define hsetremove hh_hsetremove
+#define hsetreserve hh_hsetreserve
+#define hsetfree hh_hsetfree
+#define hsetinit hh_hsetinit
+#define hsetslots hh_hsetslots
+#define hsetvalid hh_hsetvalid
+
+#define intern_t hh_intern_t
+#define INTERN_NONE HH_INTERN_NONE
+#define intern hh_intern
+#define intern_n hh_intern_n
+#define intern_find hh_intern_find
+#define intern_find_n hh_intern_find_n
+#define intern_str hh_intern_str
+#define intern_len hh_intern_len
+#define intern_count hh_intern_count
+#define intern_span hh_intern_span
+#define intern_find_span hh_intern_find_span
+#define intern_free hh_intern_free
+
+#define lru_t hh_lru_t
+#define lru_opt hh_lru_opt
+#define lru_stats_t hh_lru_stats_t
+#define lru_config hh_lru_config
+#define lru_get hh_lru_get
+#define lru_put hh_lru_put
+#define lru_remove hh_lru_remove
+#define lru_len hh_lru_len
+#define lru_stats hh_lru_stats
+#define lru_free hh_lru_free
+
+#define perfect_t hh_perfect_t
+#define PERFECT_NONE HH_PERFECT_NONE
+#define perfect_build hh_perfect_build
+#define perfect_find hh_perfect_find
+#define perfect_find_n hh_perfect_find_n
+#define perfect_find_span hh_perfect_find_span
+#define perfect_emit hh_perfect_emit
+#define perfect_free hh_perfect_free
+
 #define bench_t hh_bench_t
 #define bench_update hh_bench_update
 #define profiler_t hh_profiler_t
 #define profiler_start hh_profiler_start
 #define profiler_end hh_profiler_end
 
+#define seg_t hh_seg_t
+#define seg_opt hh_seg_opt
+#define SEG_FIRST_CHUNK HH_SEG_FIRST_CHUNK
+#define seg_config hh_seg_config
+#define seg_push hh_seg_push
+#define seg_putn hh_seg_putn
+#define seg_get hh_seg_get
+#define seg_pop hh_seg_pop
+#define seg_clear hh_seg_clear
+#define seg_len hh_seg_len
+#define seg_chunks hh_seg_chunks
+#define seg_chunk hh_seg_chunk
+#define seg_free hh_seg_free
+
+#define slot_t hh_slot_t
+#define SLOT_NONE HH_SLOT_NONE
+#define slotinsert hh_slotinsert
+#define slotget hh_slotget
+#define slotindex hh_slotindex
+#define slothas hh_slothas
+#define slotremove hh_slotremove
+#define slothandle hh_slothandle
+#define slotclear hh_slotclear
+#define slotfree hh_slotfree
+
 #define span_t hh_span_t
 #define span_opt hh_span_opt
 #define span_len hh_span_len
@@ -1731,5 +5919,7 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define span_next hh_span_next
 #define hash_span hh_hash_span
 #define comp_span hh_comp_span
+#define comp_span_cstr hh_comp_span_cstr
+#define comp_span_cstr_owned hh_comp_span_cstr_owned
 #endif // HH_APPLY_PREFIXES
 #endif // not HH__APPLY_PREFIXES
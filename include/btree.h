@@ -0,0 +1,733 @@
+#ifndef HH_BTREE__
+#define HH_BTREE__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_btree_t is an ordered map (B+-tree) for range queries and sorted iteration
+// keys are either signed 64-bit integers (HH_BTREE_INT) or byte strings (HH_BTREE_STR),
+// strings are ordered like memcmp (shorter first on a common prefix) and copied into the tree
+// values are val_size bytes, stored next to their keys in the leaves
+// nodes are HH_BTREE_NODE_SIZE bytes and come from an arena, so a lookup touches one node per level
+// and the leaves are chained for scans
+// nodes and key bytes freed by removal are reused, so memory follows the live keys, not every key ever inserted
+// a zero-initialized hh_btree_t is an integer set (val_size 0), call hh_btree_config before use otherwise
+// EXAMPLE (timestamps in a window):
+// hh_btree_t events = {0};
+// hh_btree_config(&events, .kind = HH_BTREE_INT, .val_size = sizeof(event_t));
+// hh_btree_put_int(&events, ev.time, &ev);
+// for(hh_btree_cursor_t c = hh_btree_lower_int(&events, from);
+//     hh_btree_valid(c) && hh_btree_key_int(c) < to; hh_btree_next(&c)) {
+//     event_t* ev = hh_btree_val(c);
+// }
+// EXAMPLE (keys with a prefix):
+// for(hh_btree_cursor_t c = hh_btree_lower_str(&names, "foo", 3); hh_btree_valid(c); hh_btree_next(&c)) {
+//     size_t len;
+//     const char* name = hh_btree_key_str(c, &len);
+//     if(len < 3 || memcmp(name, "foo", 3) != 0) break;
+// }
+typedef struct HH__btree_t hh_btree_t;
+
+// key kinds, selected through hh_btree_opt.kind
+#define HH_BTREE_INT 0
+#define HH_BTREE_STR 1
+
+// node size in bytes, the fan-out follows from it and the key/value sizes
+#ifndef HH_BTREE_NODE_SIZE
+#define HH_BTREE_NODE_SIZE 512
+#endif // not HH_BTREE_NODE_SIZE
+
+// configuration options for hh_btree_t, applied through hh_btree_config on an empty tree
+// kind:     HH_BTREE_INT or HH_BTREE_STR
+// val_size: size of the values in bytes (0 for a set)
+typedef struct {
+    int kind;
+    size_t val_size;
+} hh_btree_opt;
+
+// position of an entry, returned by the lower/upper bound functions
+// it stays valid until the tree is modified
+typedef struct {
+    const hh_btree_t* tree;
+    void* leaf;
+    size_t idx;
+} hh_btree_cursor_t;
+
+#define hh_btree_config(tree, ...) (HH__btree_config((tree), (hh_btree_opt) { __VA_ARGS__ }))
+
+// hh_btree_put_*     inserts a key with a copy of the val_size bytes at val (zeroed if val is NULL),
+//                    replacing the value of an existing key, returns truthy if the key was new
+// hh_btree_get_*     returns a pointer to the key's value, or NULL if it is absent
+//                    (the pointer is valid until the tree is modified)
+// hh_btree_remove_*  removes a key, returns truthy if it was present
+//                    a node left under half full is merged with a sibling when both fit in one node
+// hh_btree_lower_*   cursor at the first key >= key
+// hh_btree_upper_*   cursor at the first key > key
+// the _span variants take an hh_span_t (see span.h)
+_Bool
+hh_btree_put_int(hh_btree_t* tree, int64_t key, const void* val);
+void*
+hh_btree_get_int(const hh_btree_t* tree, int64_t key);
+_Bool
+hh_btree_remove_int(hh_btree_t* tree, int64_t key);
+hh_btree_cursor_t
+hh_btree_lower_int(const hh_btree_t* tree, int64_t key);
+hh_btree_cursor_t
+hh_btree_upper_int(const hh_btree_t* tree, int64_t key);
+_Bool
+hh_btree_put_str(hh_btree_t* tree, const char* str, size_t len, const void* val);
+void*
+hh_btree_get_str(const hh_btree_t* tree, const char* str, size_t len);
+_Bool
+hh_btree_remove_str(hh_btree_t* tree, const char* str, size_t len);
+hh_btree_cursor_t
+hh_btree_lower_str(const hh_btree_t* tree, const char* str, size_t len);
+hh_btree_cursor_t
+hh_btree_upper_str(const hh_btree_t* tree, const char* str, size_t len);
+#define hh_btree_put_span(tree, span, val) (hh_btree_put_str((tree), (span).ptr, hh_span_len(span), (val)))
+#define hh_btree_get_span(tree, span)      (hh_btree_get_str((tree), (span).ptr, hh_span_len(span)))
+#define hh_btree_lower_span(tree, span)    (hh_btree_lower_str((tree), (span).ptr, hh_span_len(span)))
+#define hh_btree_upper_span(tree, span)    (hh_btree_upper_str((tree), (span).ptr, hh_span_len(span)))
+
+// replaces the contents of the tree with n sorted, distinct keys given as a darr
+// (int64_t for HH_BTREE_INT, null-terminated `const char*` for HH_BTREE_STR)
+// vals holds n values of val_size bytes (zeroed if vals is NULL)
+// the leaves are packed, which is faster and more compact than n insertions
+void
+hh_btree_load(hh_btree_t* tree, const void* keys, const void* vals);
+
+// returns the number of keys
+size_t
+hh_btree_len(const hh_btree_t* tree);
+// cursor at the smallest key
+hh_btree_cursor_t
+hh_btree_first(const hh_btree_t* tree);
+// truthy while the cursor points at an entry
+#define hh_btree_valid(cursor) ((cursor).leaf != NULL)
+// advances the cursor to the next key in order
+void
+hh_btree_next(hh_btree_cursor_t* cursor);
+// key and value at the cursor
+int64_t
+hh_btree_key_int(hh_btree_cursor_t cursor);
+const char*
+hh_btree_key_str(hh_btree_cursor_t cursor, size_t* len);
+void*
+hh_btree_val(hh_btree_cursor_t cursor);
+// frees all nodes and keys, the options are kept
+void
+hh_btree_free(hh_btree_t* tree);
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// a node is followed by its keys and then by its values (leaf) or its len + 1 children (inner)
+// inner child i holds the keys in [keys[i - 1], keys[i])
+typedef struct HH__btree_node_t {
+    // next leaf in key order
+    struct HH__btree_node_t* next;
+    uint32_t len;
+    uint32_t leaf;
+} HH__btree_node_t;
+
+// HH_BTREE_STR keys, the bytes live in the tree's arena
+// separators in inner nodes own a copy of their bytes, so a leaf key's bytes are freed with it
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__btree_str_t;
+
+struct HH__btree_t {
+    hh_btree_opt opt;
+    HH__btree_node_t* root;
+    size_t len;
+    // derived from opt on first use
+    size_t key_size, leaf_cap, inner_cap, off_vals;
+    hh_arena arena;
+    // blocks freed by removal, reused before the arena grows
+    // string key blocks are kept by size class, class c holds 16 << c bytes
+    void* free_nodes;
+    void* free_keys[sizeof(size_t) * 8];
+};
+
+void
+HH__btree_config(hh_btree_t* tree, hh_btree_opt opt);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+#define HH__BTREE_KEYS(node) ((char*) ((node) + 1))
+
+// takes a block from a free list, or a new one from the arena
+static void*
+HH__btree_alloc(hh_btree_t* tree, void** free_list, size_t sz) {
+    void* ptr = *free_list;
+    if(ptr != NULL) {
+        memcpy(free_list, ptr, sizeof(void*));
+        return ptr;
+    }
+    // keep every allocation word-aligned, nodes hold pointers
+    ptr = hh_arena_alloc(&(tree->arena), (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1));
+    HH_ASSERT(ptr != NULL, "hh_btree failed to allocate");
+    return ptr;
+}
+
+// the first word of a freed block links it to the rest of the list
+static inline void
+HH__btree_recycle(void** free_list, void* ptr) {
+    memcpy(ptr, free_list, sizeof(void*));
+    *free_list = ptr;
+}
+
+// size class of a string key block of sz bytes
+static inline size_t
+HH__btree_class(size_t sz) {
+    size_t c = 0;
+    while(((size_t) 16 << c) < sz) ++c;
+    return c;
+}
+
+// fan-out and layout, computed once the options can no longer change
+static void
+HH__btree_layout(hh_btree_t* tree) {
+    if(tree->key_size != 0) return;
+    tree->key_size = (tree->opt.kind == HH_BTREE_STR) ? sizeof(HH__btree_str_t) : sizeof(int64_t);
+    size_t room = HH_BTREE_NODE_SIZE - sizeof(HH__btree_node_t);
+    tree->leaf_cap = room / (tree->key_size + tree->opt.val_size);
+    tree->inner_cap = (room - sizeof(void*)) / (tree->key_size + sizeof(void*));
+    HH_ASSERT(tree->leaf_cap >= 4 && tree->inner_cap >= 4,
+        "hh_btree values are too large for HH_BTREE_NODE_SIZE");
+    tree->off_vals = tree->leaf_cap * tree->key_size;
+}
+
+static HH__btree_node_t*
+HH__btree_node(hh_btree_t* tree, _Bool leaf) {
+    HH__btree_node_t* node = HH__btree_alloc(tree, &(tree->free_nodes), HH_BTREE_NODE_SIZE);
+    node->next = NULL;
+    node->len = 0;
+    node->leaf = leaf;
+    return node;
+}
+
+static inline HH__btree_node_t**
+HH__btree_children(const hh_btree_t* tree, const HH__btree_node_t* node) {
+    return (HH__btree_node_t**) (HH__BTREE_KEYS(node) + tree->inner_cap * tree->key_size);
+}
+
+static inline char*
+HH__btree_vals(const hh_btree_t* tree, const HH__btree_node_t* node) {
+    return HH__BTREE_KEYS(node) + tree->off_vals;
+}
+
+static int
+HH__btree_comp(const hh_btree_t* tree, const void* fst, const void* snd) {
+    if(tree->opt.kind == HH_BTREE_INT) {
+        int64_t key_fst, key_snd;
+        memcpy(&key_fst, fst, sizeof(int64_t));
+        memcpy(&key_snd, snd, sizeof(int64_t));
+        return (key_fst > key_snd) - (key_fst < key_snd);
+    }
+    const HH__btree_str_t* str_fst = fst;
+    const HH__btree_str_t* str_snd = snd;
+    int ret = memcmp(str_fst->ptr, str_snd->ptr, HH_MIN(str_fst->len, str_snd->len));
+    if(ret != 0) return ret;
+    return (str_fst->len > str_snd->len) - (str_fst->len < str_snd->len);
+}
+
+// number of keys in node that are < key (or <= key when upper is set)
+static size_t
+HH__btree_search(const hh_btree_t* tree, const HH__btree_node_t* node, const void* key, _Bool upper) {
+    size_t lo = 0, hi = node->len;
+    const char* keys = HH__BTREE_KEYS(node);
+    if(tree->opt.kind == HH_BTREE_INT) {
+        int64_t k;
+        memcpy(&k, key, sizeof(int64_t));
+        const int64_t* ints = (const int64_t*) keys;
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(ints[mid] < k || (upper && ints[mid] == k)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int comp = HH__btree_comp(tree, keys + mid * tree->key_size, key);
+        if(comp < 0 || (upper && comp == 0)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// leaf that holds (or would hold) key
+static HH__btree_node_t*
+HH__btree_leaf(const hh_btree_t* tree, const void* key) {
+    HH__btree_node_t* node = tree->root;
+    while(node != NULL && !node->leaf) {
+        // a separator equal to key is the first key of the right child
+        node = HH__btree_children(tree, node)[HH__btree_search(tree, node, key, 1)];
+    }
+    return node;
+}
+
+// skips past the end of a leaf (only an empty root leaf is left by removal)
+static hh_btree_cursor_t
+HH__btree_cursor(const hh_btree_t* tree, HH__btree_node_t* leaf, size_t idx) {
+    while(leaf != NULL && idx >= leaf->len) {
+        leaf = leaf->next;
+        idx = 0;
+    }
+    return (hh_btree_cursor_t) { .tree = tree, .leaf = leaf, .idx = idx };
+}
+
+static hh_btree_cursor_t
+HH__btree_bound(const hh_btree_t* tree, const void* key, _Bool upper) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* leaf = HH__btree_leaf(tree, key);
+    if(leaf == NULL) return (hh_btree_cursor_t) { .tree = tree };
+    return HH__btree_cursor(tree, leaf, HH__btree_search(tree, leaf, key, upper));
+}
+
+static void*
+HH__btree_get(const hh_btree_t* tree, const void* key) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* leaf = HH__btree_leaf(tree, key);
+    if(leaf == NULL) return NULL;
+    size_t idx = HH__btree_search(tree, leaf, key, 0);
+    if(idx == leaf->len || HH__btree_comp(tree, HH__BTREE_KEYS(leaf) + idx * tree->key_size, key) != 0) return NULL;
+    return HH__btree_vals(tree, leaf) + idx * tree->opt.val_size;
+}
+
+// copies a new key into the tree (string bytes go to the arena)
+static void
+HH__btree_keycopy(hh_btree_t* tree, void* dst, const void* key) {
+    if(tree->opt.kind == HH_BTREE_STR) {
+        HH__btree_str_t str = *((const HH__btree_str_t*) key);
+        HH_ASSERT(str.len < SIZE_MAX / 2, "hh_btree received a key of %zu bytes", str.len);
+        size_t c = HH__btree_class(str.len + 1);
+        char* copy = HH__btree_alloc(tree, &(tree->free_keys[c]), (size_t) 16 << c);
+        if(str.len > 0) memcpy(copy, str.ptr, str.len);
+        copy[str.len] = '\0';
+        str.ptr = copy;
+        memcpy(dst, &str, sizeof(HH__btree_str_t));
+        return;
+    }
+    memcpy(dst, key, tree->key_size);
+}
+
+// releases the bytes of a key copied by HH__btree_keycopy
+static void
+HH__btree_keyfree(hh_btree_t* tree, const void* key) {
+    if(tree->opt.kind != HH_BTREE_STR) return;
+    HH__btree_str_t str;
+    memcpy(&str, key, sizeof(HH__btree_str_t));
+    HH__btree_recycle(&(tree->free_keys[HH__btree_class(str.len + 1)]), (char*) str.ptr);
+}
+
+static void
+HH__btree_valcopy(const hh_btree_t* tree, void* dst, const void* val) {
+    if(tree->opt.val_size == 0) return;
+    if(val == NULL) memset(dst, 0, tree->opt.val_size);
+    else memcpy(dst, val, tree->opt.val_size);
+}
+
+// inserts into a leaf with room for one more entry
+static void
+HH__btree_leafinsert(hh_btree_t* tree, HH__btree_node_t* leaf, size_t idx, const void* key, const void* val) {
+    char* keys = HH__BTREE_KEYS(leaf);
+    char* vals = HH__btree_vals(tree, leaf);
+    size_t ks = tree->key_size, vs = tree->opt.val_size;
+    memmove(keys + (idx + 1) * ks, keys + idx * ks, (leaf->len - idx) * ks);
+    if(vs > 0) memmove(vals + (idx + 1) * vs, vals + idx * vs, (leaf->len - idx) * vs);
+    HH__btree_keycopy(tree, keys + idx * ks, key);
+    HH__btree_valcopy(tree, vals + idx * vs, val);
+    ++(leaf->len);
+}
+
+// inserts a separator and the child to its right into an inner node with room for them
+static void
+HH__btree_innerinsert(hh_btree_t* tree, HH__btree_node_t* node, size_t idx, const void* sep, HH__btree_node_t* child) {
+    char* keys = HH__BTREE_KEYS(node);
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    size_t ks = tree->key_size;
+    memmove(keys + (idx + 1) * ks, keys + idx * ks, (node->len - idx) * ks);
+    memmove(children + idx + 2, children + idx + 1, (node->len - idx) * sizeof(void*));
+    memcpy(keys + idx * ks, sep, ks);
+    children[idx + 1] = child;
+    ++(node->len);
+}
+
+// inserts key into the subtree at node
+// returns the new right sibling when node had to be split, its smallest key is copied to sep
+static HH__btree_node_t*
+HH__btree_insertat(hh_btree_t* tree, HH__btree_node_t* node, const void* key, const void* val, void* sep, _Bool* added) {
+    size_t ks = tree->key_size;
+    if(node->leaf) {
+        size_t idx = HH__btree_search(tree, node, key, 0);
+        if(idx < node->len && HH__btree_comp(tree, HH__BTREE_KEYS(node) + idx * ks, key) == 0) {
+            HH__btree_valcopy(tree, HH__btree_vals(tree, node) + idx * tree->opt.val_size, val);
+            *added = 0;
+            return NULL;
+        }
+        *added = 1;
+        if(node->len < tree->leaf_cap) {
+            HH__btree_leafinsert(tree, node, idx, key, val);
+            return NULL;
+        }
+        // move the upper half into a new leaf
+        HH__btree_node_t* right = HH__btree_node(tree, 1);
+        size_t mid = node->len / 2, vs = tree->opt.val_size;
+        right->len = node->len - (uint32_t) mid;
+        memcpy(HH__BTREE_KEYS(right), HH__BTREE_KEYS(node) + mid * ks, right->len * ks);
+        if(vs > 0) memcpy(HH__btree_vals(tree, right), HH__btree_vals(tree, node) + mid * vs, right->len * vs);
+        node->len = (uint32_t) mid;
+        right->next = node->next;
+        node->next = right;
+        if(idx <= mid) HH__btree_leafinsert(tree, node, idx, key, val);
+        else HH__btree_leafinsert(tree, right, idx - mid, key, val);
+        HH__btree_keycopy(tree, sep, HH__BTREE_KEYS(right));
+        return right;
+    }
+    size_t idx = HH__btree_search(tree, node, key, 1);
+    char child_sep[sizeof(HH__btree_str_t)];
+    HH__btree_node_t* child = HH__btree_insertat(tree, HH__btree_children(tree, node)[idx], key, val, child_sep, added);
+    if(child == NULL) return NULL;
+    if(node->len < tree->inner_cap) {
+        HH__btree_innerinsert(tree, node, idx, child_sep, child);
+        return NULL;
+    }
+    // the middle key moves up, the keys and children after it move right
+    HH__btree_node_t* right = HH__btree_node(tree, 0);
+    size_t mid = node->len / 2;
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    right->len = node->len - (uint32_t) mid - 1;
+    memcpy(sep, HH__BTREE_KEYS(node) + mid * ks, ks);
+    memcpy(HH__BTREE_KEYS(right), HH__BTREE_KEYS(node) + (mid + 1) * ks, right->len * ks);
+    memcpy(HH__btree_children(tree, right), children + mid + 1, (right->len + 1) * sizeof(void*));
+    node->len = (uint32_t) mid;
+    if(idx <= mid) HH__btree_innerinsert(tree, node, idx, child_sep, child);
+    else HH__btree_innerinsert(tree, right, idx - mid - 1, child_sep, child);
+    return right;
+}
+
+static _Bool
+HH__btree_put(hh_btree_t* tree, const void* key, const void* val) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_layout(tree);
+    if(tree->root == NULL) tree->root = HH__btree_node(tree, 1);
+    _Bool added = 0;
+    char sep[sizeof(HH__btree_str_t)];
+    HH__btree_node_t* right = HH__btree_insertat(tree, tree->root, key, val, sep, &added);
+    if(right != NULL) {
+        // the root was split, the tree grows by one level
+        HH__btree_node_t* root = HH__btree_node(tree, 0);
+        HH__btree_children(tree, root)[0] = tree->root;
+        HH__btree_innerinsert(tree, root, 0, sep, right);
+        tree->root = root;
+    }
+    tree->len += added;
+    return added;
+}
+
+// merges child i + 1 of node into child i when their entries fit in one node
+static void
+HH__btree_merge(hh_btree_t* tree, HH__btree_node_t* node, size_t i) {
+    HH__btree_node_t** children = HH__btree_children(tree, node);
+    HH__btree_node_t* left = children[i];
+    HH__btree_node_t* right = children[i + 1];
+    size_t ks = tree->key_size, vs = tree->opt.val_size;
+    char* sep = HH__BTREE_KEYS(node) + i * ks;
+    if(left->leaf) {
+        if(left->len + right->len > tree->leaf_cap) return;
+        memcpy(HH__BTREE_KEYS(left) + left->len * ks, HH__BTREE_KEYS(right), right->len * ks);
+        if(vs > 0) memcpy(HH__btree_vals(tree, left) + left->len * vs, HH__btree_vals(tree, right), right->len * vs);
+        left->next = right->next;
+        HH__btree_keyfree(tree, sep);
+    } else {
+        // the separator moves down between the two halves
+        if(left->len + 1 + right->len > tree->inner_cap) return;
+        memcpy(HH__BTREE_KEYS(left) + left->len * ks, sep, ks);
+        memcpy(HH__BTREE_KEYS(left) + (left->len + 1) * ks, HH__BTREE_KEYS(right), right->len * ks);
+        memcpy(HH__btree_children(tree, left) + left->len + 1, HH__btree_children(tree, right), (right->len + 1) * sizeof(void*));
+        ++(left->len);
+    }
+    left->len += right->len;
+    memmove(sep, sep + ks, (node->len - i - 1) * ks);
+    memmove(children + i + 1, children + i + 2, (node->len - i - 1) * sizeof(void*));
+    --(node->len);
+    HH__btree_recycle(&(tree->free_nodes), right);
+}
+
+// removes key from the subtree at node, returns truthy if it was present
+// a child left under half full is merged with a sibling
+static _Bool
+HH__btree_removeat(hh_btree_t* tree, HH__btree_node_t* node, const void* key) {
+    size_t ks = tree->key_size;
+    if(node->leaf) {
+        size_t idx = HH__btree_search(tree, node, key, 0);
+        size_t vs = tree->opt.val_size;
+        char* keys = HH__BTREE_KEYS(node);
+        if(idx == node->len || HH__btree_comp(tree, keys + idx * ks, key) != 0) return 0;
+        HH__btree_keyfree(tree, keys + idx * ks);
+        memmove(keys + idx * ks, keys + (idx + 1) * ks, (node->len - idx - 1) * ks);
+        char* vals = HH__btree_vals(tree, node);
+        if(vs > 0) memmove(vals + idx * vs, vals + (idx + 1) * vs, (node->len - idx - 1) * vs);
+        --(node->len);
+        return 1;
+    }
+    size_t idx = HH__btree_search(tree, node, key, 1);
+    HH__btree_node_t* child = HH__btree_children(tree, node)[idx];
+    if(!HH__btree_removeat(tree, child, key)) return 0;
+    size_t cap = child->leaf ? tree->leaf_cap : tree->inner_cap;
+    // the last child merges into its left sibling
+    if(child->len < cap / 2 && node->len > 0) HH__btree_merge(tree, node, (idx < node->len) ? idx : idx - 1);
+    return 1;
+}
+
+static _Bool
+HH__btree_remove(hh_btree_t* tree, const void* key) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    if(tree->root == NULL || !HH__btree_removeat(tree, tree->root, key)) return 0;
+    // an inner root left with one child is replaced by it, the tree shrinks by one level
+    while(!tree->root->leaf && tree->root->len == 0) {
+        HH__btree_node_t* root = tree->root;
+        tree->root = HH__btree_children(tree, root)[0];
+        HH__btree_recycle(&(tree->free_nodes), root);
+    }
+    --(tree->len);
+    return 1;
+}
+
+void
+HH__btree_config(hh_btree_t* tree, hh_btree_opt opt) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH_ASSERT(tree->root == NULL, "hh_btree_config requires an empty tree");
+    HH_ASSERT(opt.kind == HH_BTREE_INT || opt.kind == HH_BTREE_STR, "hh_btree_config received an unknown kind");
+    tree->opt = opt;
+    tree->key_size = 0;
+}
+
+_Bool
+hh_btree_put_int(hh_btree_t* tree, int64_t key, const void* val) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_put_int requires HH_BTREE_INT keys");
+    return HH__btree_put(tree, &key, val);
+}
+
+void*
+hh_btree_get_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_get_int requires HH_BTREE_INT keys");
+    return HH__btree_get(tree, &key);
+}
+
+_Bool
+hh_btree_remove_int(hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_remove_int requires HH_BTREE_INT keys");
+    return HH__btree_remove(tree, &key);
+}
+
+hh_btree_cursor_t
+hh_btree_lower_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_lower_int requires HH_BTREE_INT keys");
+    return HH__btree_bound(tree, &key, 0);
+}
+
+hh_btree_cursor_t
+hh_btree_upper_int(const hh_btree_t* tree, int64_t key) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_INT, "hh_btree_upper_int requires HH_BTREE_INT keys");
+    return HH__btree_bound(tree, &key, 1);
+}
+
+_Bool
+hh_btree_put_str(hh_btree_t* tree, const char* str, size_t len, const void* val) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_put_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_put(tree, &key, val);
+}
+
+void*
+hh_btree_get_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_get_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_get(tree, &key);
+}
+
+_Bool
+hh_btree_remove_str(hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_remove_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_remove(tree, &key);
+}
+
+hh_btree_cursor_t
+hh_btree_lower_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_lower_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_bound(tree, &key, 0);
+}
+
+hh_btree_cursor_t
+hh_btree_upper_str(const hh_btree_t* tree, const char* str, size_t len) {
+    HH_ASSERT(tree->opt.kind == HH_BTREE_STR, "hh_btree_upper_str requires HH_BTREE_STR keys");
+    HH__btree_str_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    return HH__btree_bound(tree, &key, 1);
+}
+
+void
+hh_btree_load(hh_btree_t* tree, const void* keys, const void* vals) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    hh_btree_free(tree);
+    HH__btree_layout(tree);
+    size_t n = hh_darrlen(keys), ks = tree->key_size, vs = tree->opt.val_size;
+    if(n == 0) return;
+    // fill the leaves evenly, left to right
+    size_t leaves = (n + tree->leaf_cap - 1) / tree->leaf_cap, count = leaves;
+    HH__btree_node_t** level = HH__alloc(NULL, leaves * sizeof(HH__btree_node_t*), "hh_btree_load");
+    HH__btree_node_t* prev = NULL;
+    char key[sizeof(HH__btree_str_t)], last[sizeof(HH__btree_str_t)];
+    for(size_t i = 0, j = 0; i < count; ++i) {
+        HH__btree_node_t* leaf = level[i] = HH__btree_node(tree, 1);
+        size_t end = n * (i + 1) / count;
+        for(; j < end; ++j) {
+            if(tree->opt.kind == HH_BTREE_STR) {
+                const char* str = ((const char* const*) keys)[j];
+                HH__btree_str_t key_str = { .ptr = str, .len = strlen(str) };
+                memcpy(key, &key_str, sizeof(HH__btree_str_t));
+            } else memcpy(key, (const int64_t*) keys + j, sizeof(int64_t));
+            HH_ASSERT(j == 0 || HH__btree_comp(tree, last, key) < 0, "hh_btree_load requires sorted, distinct keys");
+            memcpy(last, key, ks);
+            HH__btree_keycopy(tree, HH__BTREE_KEYS(leaf) + leaf->len * ks, key);
+            HH__btree_valcopy(tree, HH__btree_vals(tree, leaf) + leaf->len * vs, (vals == NULL) ? NULL : (const char*) vals + j * vs);
+            ++(leaf->len);
+        }
+        if(prev != NULL) prev->next = leaf;
+        prev = leaf;
+    }
+    // build the inner levels bottom-up, the separator of a child is the smallest key below it
+    while(count > 1) {
+        size_t parents = (count + tree->inner_cap) / (tree->inner_cap + 1);
+        for(size_t i = 0, j = 0; i < parents; ++i) {
+            HH__btree_node_t* node = HH__btree_node(tree, 0);
+            size_t end = count * (i + 1) / parents;
+            HH__btree_children(tree, node)[0] = level[j++];
+            for(; j < end; ++j) {
+                HH__btree_node_t* leftmost = level[j];
+                while(!leftmost->leaf) leftmost = HH__btree_children(tree, leftmost)[0];
+                HH__btree_keycopy(tree, key, HH__BTREE_KEYS(leftmost));
+                HH__btree_innerinsert(tree, node, node->len, key, level[j]);
+            }
+            level[i] = node;
+        }
+        count = parents;
+    }
+    tree->root = level[0];
+    tree->len = n;
+    HH__release(NULL, level, leaves * sizeof(HH__btree_node_t*));
+}
+
+size_t
+hh_btree_len(const hh_btree_t* tree) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    return tree->len;
+}
+
+hh_btree_cursor_t
+hh_btree_first(const hh_btree_t* tree) {
+    HH_ASSERT_INVARIANT(tree != NULL);
+    HH__btree_node_t* node = tree->root;
+    while(node != NULL && !node->leaf) node = HH__btree_children(tree, node)[0];
+    if(node == NULL) return (hh_btree_cursor_t) { .tree = tree };
+    return HH__btree_cursor(tree, node, 0);
+}
+
+void
+hh_btree_next(hh_btree_cursor_t* cursor) {
+    HH_ASSERT_INVARIANT(cursor != NULL && cursor->leaf != NULL);
+    *cursor = HH__btree_cursor(cursor->tree, cursor->leaf, cursor->idx + 1);
+}
+
+int64_t
+hh_btree_key_int(hh_btree_cursor_t cursor) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    int64_t key;
+    memcpy(&key, HH__BTREE_KEYS((HH__btree_node_t*) cursor.leaf) + cursor.idx * sizeof(int64_t), sizeof(int64_t));
+    return key;
+}
+
+const char*
+hh_btree_key_str(hh_btree_cursor_t cursor, size_t* len) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    HH__btree_str_t key;
+    memcpy(&key, HH__BTREE_KEYS((HH__btree_node_t*) cursor.leaf) + cursor.idx * sizeof(HH__btree_str_t), sizeof(key));
+    if(len != NULL) *len = key.len;
+    return key.ptr;
+}
+
+void*
+hh_btree_val(hh_btree_cursor_t cursor) {
+    HH_ASSERT_INVARIANT(cursor.leaf != NULL);
+    return HH__btree_vals(cursor.tree, cursor.leaf) + cursor.idx * cursor.tree->opt.val_size;
+}
+
+void
+hh_btree_free(hh_btree_t* tree) {
+    if(tree == NULL) return;
+    hh_arena_free(&(tree->arena));
+    hh_btree_opt opt = tree->opt;
+    memset(tree, 0, sizeof(hh_btree_t));
+    tree->opt = opt;
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_BTREE__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define btree_t hh_btree_t
+#define btree_opt hh_btree_opt
+#define btree_cursor_t hh_btree_cursor_t
+#define BTREE_INT HH_BTREE_INT
+#define BTREE_STR HH_BTREE_STR
+#define btree_config hh_btree_config
+#define btree_put_int hh_btree_put_int
+#define btree_get_int hh_btree_get_int
+#define btree_remove_int hh_btree_remove_int
+#define btree_lower_int hh_btree_lower_int
+#define btree_upper_int hh_btree_upper_int
+#define btree_put_str hh_btree_put_str
+#define btree_get_str hh_btree_get_str
+#define btree_remove_str hh_btree_remove_str
+#define btree_lower_str hh_btree_lower_str
+#define btree_upper_str hh_btree_upper_str
+#define btree_put_span hh_btree_put_span
+#define btree_get_span hh_btree_get_span
+#define btree_lower_span hh_btree_lower_span
+#define btree_upper_span hh_btree_upper_span
+#define btree_load hh_btree_load
+#define btree_len hh_btree_len
+#define btree_first hh_btree_first
+#define btree_valid hh_btree_valid
+#define btree_next hh_btree_next
+#define btree_key_int hh_btree_key_int
+#define btree_key_str hh_btree_key_str
+#define btree_val hh_btree_val
+#define btree_free hh_btree_free
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
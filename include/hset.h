@@ -0,0 +1,329 @@
+#ifndef HH_HSET__
+#define HH_HSET__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_hset is an open-addressing hash set of integer keys (1, 2, 4 or 8 bytes, signed or unsigned)
+// keys are hashed by fibonacci hashing and stored inline, without a separate index,
+// so a membership test usually touches a single cache line
+// the same functions also manage integer-keyed maps: an array of struct { K key; V val; }
+// (key first), filled with hh_hsetput instead of hh_hsetinsert
+// a set only stores its keys, halving the memory a map with a dummy value would need
+// EXAMPLE:
+// uint32_t* seen = NULL;
+// if(hh_hsetinsert(seen, id)) { /* first time */ }
+// ASSERT(hh_hsethas(seen, id));
+// hh_hsetfree(seen);
+// struct { uint64_t key; float val; }* weights = NULL;
+// hh_hsetput(weights, 42, 1.0f);
+// size_t slot = hh_hsetget(weights, 42);
+// float w = weights[slot].val;
+// hh_hsetfree(weights);
+
+// fraction of occupied slots before the table is doubled
+#ifndef HH_HSET_MAX_LOAD
+#define HH_HSET_MAX_LOAD 0.7
+#endif // not HH_HSET_MAX_LOAD
+
+// hh_hsetlen      returns the number of keys
+// hh_hsetinsert   inserts a key into a set, returns truthy if it wasn't present
+// hh_hsetput      inserts (or overwrites) a key/value pair in a map, returns truthy if the key wasn't present
+// hh_hsetget      returns the slot holding key, or SIZE_MAX
+// hh_hsethas      returns truthy if key is present
+// hh_hsetremove   removes key, returns truthy if it was present
+// hh_hsetreserve  makes room for n keys without growing
+// hh_hsetfree     frees the set and sets it to NULL
+// hh_hsetinit     creates an empty set (set must be NULL) that allocates through alloc,
+//                 sets created any other way use the global allocator (see hh_allocator_get)
+// slots move whenever the set grows or a key is removed, so slot indices are only valid until then
+// iterate over all keys with hh_hsetslots/hh_hsetvalid:
+// for(size_t i = 0; i < hh_hsetslots(set); ++i) if(hh_hsetvalid(set, i)) { ... set[i] ... }
+#define hh_hsetlen(set)            (((set) == NULL) ? 0 : hh_hsetheader(set)->len)
+#define hh_hsetinsert(set, key)    (HH__hsetinsert((void**) &(set), sizeof(*(set)), sizeof(*(set)), (uint64_t) (key)))
+#define hh_hsetput(map, key_, val_) (HH__hsetinsert((void**) &(map), sizeof((map)->key), sizeof(*(map)), (uint64_t) (key_)) ? \
+    ((map)[hh_hsetheader(map)->last].val = (val_), 1) : \
+    ((map)[hh_hsetheader(map)->last].val = (val_), 0))
+#define hh_hsetget(set, key)       (((set) == NULL) ? SIZE_MAX : HH__hsetfind((set), (uint64_t) (key)))
+#define hh_hsethas(set, key)       (hh_hsetget((set), (key)) != SIZE_MAX)
+#define hh_hsetremove(set, key)    (((set) == NULL) ? 0 : HH__hsetremove((set), (uint64_t) (key)))
+#define hh_hsetreserve(set, n)     (HH__hsetreserve((void**) &(set), sizeof(*(set)), (n)))
+#define hh_hsetinit(set, alloc)    (HH__hsetinit((void**) &(set), sizeof(*(set)), (alloc)))
+#define hh_hsetfree(set)           (HH__hsetfree(set), (set) = NULL)
+#define hh_hsetslots(set)          (((set) == NULL) ? 0 : hh_hsetheader(set)->cap + 1)
+#define hh_hsetvalid(set, i)       (HH__hsetvalid((set), (i)))
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// internal hset components
+// slots[0..cap) is the table (cap is a power of two), key 0 marks an empty slot
+// key 0 itself lives in the extra slot `cap`, which is occupied iff `zero` is set
+typedef struct {
+    size_t sz_key, sz_entry;
+    size_t len, cap, last;
+    // allocator behind the table, the global one at the time the set was created
+    const hh_allocator_t* alloc;
+    // 64 - log2(cap), fibonacci hashing keeps the top bits of the product
+    uint32_t shift;
+    uint32_t zero;
+    // rounds the header up to a multiple of 16 bytes, so map values are as aligned as a darr's
+    uint32_t pad[(16 - (5 * sizeof(size_t) + sizeof(void*) + 2 * sizeof(uint32_t)) % 16) / sizeof(uint32_t)];
+} hh_hsetheader_t;
+// fails to compile if the padding above is wrong
+typedef char HH__hsetheader_aligned[(sizeof(hh_hsetheader_t) % 16 == 0) ? 1 : -1];
+// macro for retrieving hset header
+#define hh_hsetheader(set) (((hh_hsetheader_t*) (set)) - 1)
+
+// reads the key at the start of an entry
+// (signed and unsigned keys of the same width may alias)
+static inline uint64_t
+HH__hsetkey(const void* entry, size_t sz_key) {
+    switch(sz_key) {
+        case 1: return *((const uint8_t*) entry);
+        case 2: return *((const uint16_t*) entry);
+        case 4: return *((const uint32_t*) entry);
+        default: return *((const uint64_t*) entry);
+    }
+}
+
+// truncates a (possibly sign-extended) key to the width it is stored with
+// (hh_hsetreserve leaves the key size at 0, which maps every key to 0)
+static inline uint64_t
+HH__hsetnorm(uint64_t key, size_t sz_key) {
+    return (sz_key >= 8) ? key : key & ((1ULL << (sz_key * 8)) - 1);
+}
+
+static inline size_t
+HH__hsethome(const hh_hsetheader_t* set_hdr, uint64_t key) {
+    return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> set_hdr->shift);
+}
+
+// returns the slot holding key, or SIZE_MAX
+HH__FORCE_INLINE size_t
+HH__hsetfind(const void* set, uint64_t key) {
+    const hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    key = HH__hsetnorm(key, set_hdr->sz_key);
+    if(key == 0) return set_hdr->zero ? set_hdr->cap : SIZE_MAX;
+    size_t mask = set_hdr->cap - 1;
+    for(size_t i = HH__hsethome(set_hdr, key);; i = (i + 1) & mask) {
+        uint64_t other = HH__hsetkey((const char*) set + i * set_hdr->sz_entry, set_hdr->sz_key);
+        if(other == key) return i;
+        // the table is never full, so every probe reaches an empty slot
+        if(other == 0) return SIZE_MAX;
+    }
+}
+
+// implementations of hset macros
+_Bool
+HH__hsetinsert(void** set_ptr, size_t sz_key, size_t sz_entry, uint64_t key);
+_Bool
+HH__hsetremove(void* set, uint64_t key);
+void
+HH__hsetreserve(void** set_ptr, size_t sz_entry, size_t n);
+void
+HH__hsetinit(void** set_ptr, size_t sz_entry, const hh_allocator_t* alloc);
+_Bool
+HH__hsetvalid(const void* set, size_t idx);
+void
+HH__hsetfree(void* set);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+static void
+HH__hsetkeyset(void* entry, size_t sz_key, uint64_t key) {
+    switch(sz_key) {
+        case 1: *((uint8_t*) entry) = (uint8_t) key; break;
+        case 2: *((uint16_t*) entry) = (uint16_t) key; break;
+        case 4: *((uint32_t*) entry) = (uint32_t) key; break;
+        default: *((uint64_t*) entry) = key; break;
+    }
+}
+
+static inline size_t
+HH__hsetsize(size_t cap, size_t sz_entry) {
+    return sizeof(hh_hsetheader_t) + (cap + 1) * sz_entry;
+}
+
+// (re)allocates the table with `cap` slots and re-inserts every entry
+// a new set allocates through alloc (NULL for the global allocator), an existing one keeps its own
+static hh_hsetheader_t*
+HH__hsetresize(void** set_ptr, size_t sz_key, size_t sz_entry, size_t cap, const hh_allocator_t* alloc) {
+    if(set_ptr[0] != NULL) alloc = hh_hsetheader(set_ptr[0])->alloc;
+    else if(alloc == NULL) alloc = HH__allocator_global;
+    // custom allocators don't have to return zeroed memory
+    hh_hsetheader_t* set_hdr = HH__alloc(alloc, HH__hsetsize(cap, sz_entry), "hsetinsert");
+    memset(set_hdr, 0, HH__hsetsize(cap, sz_entry));
+    set_hdr->alloc = alloc;
+    set_hdr->sz_key = sz_key;
+    set_hdr->sz_entry = sz_entry;
+    set_hdr->cap = cap;
+    set_hdr->last = SIZE_MAX;
+    set_hdr->shift = 64;
+    for(size_t c = cap; c > 1; c >>= 1) --(set_hdr->shift);
+    char* slots = (char*) (set_hdr + 1);
+    if(set_ptr[0] != NULL) {
+        hh_hsetheader_t* old_hdr = hh_hsetheader(set_ptr[0]);
+        const char* old = set_ptr[0];
+        size_t mask = cap - 1;
+        for(size_t j = 0; j < old_hdr->cap && old_hdr->len > 0; ++j) {
+            uint64_t key = HH__hsetkey(old + j * sz_entry, sz_key);
+            if(key == 0) continue;
+            size_t i = HH__hsethome(set_hdr, key);
+            while(HH__hsetkey(slots + i * sz_entry, sz_key) != 0) i = (i + 1) & mask;
+            memcpy(slots + i * sz_entry, old + j * sz_entry, sz_entry);
+        }
+        memcpy(slots + cap * sz_entry, old + old_hdr->cap * sz_entry, sz_entry);
+        set_hdr->len = old_hdr->len;
+        set_hdr->zero = old_hdr->zero;
+        HH__release(alloc, old_hdr, HH__hsetsize(old_hdr->cap, old_hdr->sz_entry));
+    }
+    set_ptr[0] = slots;
+    return set_hdr;
+}
+
+// smallest table that holds n keys below HH_HSET_MAX_LOAD
+static size_t
+HH__hsetcap(size_t n) {
+    size_t cap = HH_DARR_INITIAL_CAPACITY;
+    while((double) cap * HH_HSET_MAX_LOAD < (double) n) cap *= 2;
+    return cap;
+}
+
+_Bool
+HH__hsetinsert(void** set_ptr, size_t sz_key, size_t sz_entry, uint64_t key) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    HH_ASSERT(sz_key == 1 || sz_key == 2 || sz_key == 4 || sz_key == 8,
+        "hh_hset requires integer keys, received a key of %zu bytes", sz_key);
+    hh_hsetheader_t* set_hdr = (set_ptr[0] == NULL) ? \
+        HH__hsetresize(set_ptr, sz_key, sz_entry, HH__hsetcap(0), NULL) : \
+        hh_hsetheader(set_ptr[0]);
+    // a set created by hh_hsetreserve learns its key size here
+    if(set_hdr->sz_key == 0) set_hdr->sz_key = sz_key;
+    key = HH__hsetnorm(key, sz_key);
+    size_t idx = HH__hsetfind(set_ptr[0], key);
+    if(idx != SIZE_MAX) {
+        set_hdr->last = idx;
+        return 0;
+    }
+    if(key == 0) {
+        set_hdr->zero = 1;
+        idx = set_hdr->cap;
+    } else {
+        if((double) (set_hdr->len + 1) > (double) set_hdr->cap * HH_HSET_MAX_LOAD)
+            set_hdr = HH__hsetresize(set_ptr, sz_key, sz_entry, set_hdr->cap * 2, NULL);
+        size_t mask = set_hdr->cap - 1;
+        char* slots = set_ptr[0];
+        idx = HH__hsethome(set_hdr, key);
+        while(HH__hsetkey(slots + idx * sz_entry, sz_key) != 0) idx = (idx + 1) & mask;
+    }
+    char* entry = (char*) set_ptr[0] + idx * sz_entry;
+    memset(entry, 0, sz_entry);
+    HH__hsetkeyset(entry, sz_key, key);
+    ++(set_hdr->len);
+    set_hdr->last = idx;
+    return 1;
+}
+
+_Bool
+HH__hsetremove(void* set, uint64_t key) {
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    size_t idx = HH__hsetfind(set, key);
+    if(idx == SIZE_MAX) return 0;
+    char* slots = set;
+    size_t sz_entry = set_hdr->sz_entry, mask = set_hdr->cap - 1;
+    --(set_hdr->len);
+    if(idx == set_hdr->cap) {
+        set_hdr->zero = 0;
+        memset(slots + idx * sz_entry, 0, sz_entry);
+        return 1;
+    }
+    // backward shift deletion: later keys of the run move into the gap
+    // unless that would place them in front of their home slot, so no tombstones are needed
+    for(size_t j = (idx + 1) & mask;; j = (j + 1) & mask) {
+        uint64_t other = HH__hsetkey(slots + j * sz_entry, set_hdr->sz_key);
+        if(other == 0) break;
+        size_t home = HH__hsethome(set_hdr, other);
+        // distance from home to j must cover the gap at idx
+        if(((j - home) & mask) < ((j - idx) & mask)) continue;
+        memcpy(slots + idx * sz_entry, slots + j * sz_entry, sz_entry);
+        idx = j;
+    }
+    memset(slots + idx * sz_entry, 0, sz_entry);
+    return 1;
+}
+
+void
+HH__hsetreserve(void** set_ptr, size_t sz_entry, size_t n) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    size_t cap = HH__hsetcap(n);
+    if(set_ptr[0] == NULL) {
+        // the key size (0 for now) is unknown until the first insert,
+        // no key can be found until then
+        HH__hsetresize(set_ptr, 0, sz_entry, cap, NULL);
+        return;
+    }
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set_ptr[0]);
+    if(cap > set_hdr->cap) HH__hsetresize(set_ptr, set_hdr->sz_key, sz_entry, cap, NULL);
+}
+
+void
+HH__hsetinit(void** set_ptr, size_t sz_entry, const hh_allocator_t* alloc) {
+    HH_ASSERT_INVARIANT(set_ptr != NULL);
+    HH_ASSERT(*set_ptr == NULL, "hh_hsetinit requires an empty (NULL) set");
+    // the key size is learned on the first insert, as for hh_hsetreserve
+    HH__hsetresize(set_ptr, 0, sz_entry, HH__hsetcap(0), alloc);
+}
+
+_Bool
+HH__hsetvalid(const void* set, size_t idx) {
+    if(set == NULL) return 0;
+    const hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    if(idx == set_hdr->cap) return set_hdr->zero;
+    return idx < set_hdr->cap && HH__hsetkey((const char*) set + idx * set_hdr->sz_entry, set_hdr->sz_key) != 0;
+}
+
+void
+HH__hsetfree(void* set) {
+    if(set == NULL) return;
+    hh_hsetheader_t* set_hdr = hh_hsetheader(set);
+    HH__release(set_hdr->alloc, set_hdr, HH__hsetsize(set_hdr->cap, set_hdr->sz_entry));
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_HSET__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define hsetlen hh_hsetlen
+#define hsetinsert hh_hsetinsert
+#define hsetput hh_hsetput
+#define hsetget hh_hsetget
+#define hsethas hh_hsethas
+#define hsetremove hh_hsetremove
+#define hsetreserve hh_hsetreserve
+#define hsetfree hh_hsetfree
+#define hsetinit hh_hsetinit
+#define hsetslots hh_hsetslots
+#define hsetvalid hh_hsetvalid
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
@@ -0,0 +1,188 @@
+#ifndef HH_INTERN__
+#define HH_INTERN__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_intern_t maps strings to dense uint32_t IDs (0, 1, 2, ...) and back
+// every distinct string is copied once into an arena,
+// so the strings handed out by hh_intern_str stay valid until hh_intern_free
+// a zero-initialized hh_intern_t is ready for use
+// EXAMPLE:
+// hh_intern_t names = {0};
+// uint32_t id = hh_intern(&names, "foo");
+// ASSERT(hh_intern(&names, "foo") == id && strcmp(hh_intern_str(&names, id), "foo") == 0);
+// hh_intern_free(&names);
+typedef struct HH__intern_t hh_intern_t;
+
+// returned by the hh_intern_find family when a string hasn't been interned
+#define HH_INTERN_NONE UINT32_MAX
+
+// returns the ID of the string, interning it if it is new
+uint32_t
+hh_intern(hh_intern_t* in, const char* str);
+// same as hh_intern, the string is given by its first len bytes (it may contain '\0')
+uint32_t
+hh_intern_n(hh_intern_t* in, const char* str, size_t len);
+// returns the ID of the string, or HH_INTERN_NONE if it hasn't been interned
+uint32_t
+hh_intern_find(const hh_intern_t* in, const char* str);
+uint32_t
+hh_intern_find_n(const hh_intern_t* in, const char* str, size_t len);
+// returns the interned (null-terminated) string with the given ID
+const char*
+hh_intern_str(const hh_intern_t* in, uint32_t id);
+// returns the length of the interned string with the given ID
+size_t
+hh_intern_len(const hh_intern_t* in, uint32_t id);
+// returns the number of distinct strings
+#define hh_intern_count(in) ((uint32_t) hh_hmaplen((in)->index))
+// span variants (see span.h)
+#define hh_intern_span(in, span)      (hh_intern_n((in), (span).ptr, hh_span_len(span)))
+#define hh_intern_find_span(in, span) (hh_intern_find_n((in), (span).ptr, hh_span_len(span)))
+// frees all interned strings and resets the table
+void
+hh_intern_free(hh_intern_t* in);
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__intern_key_t;
+
+struct HH__intern_t {
+    hh_arena arena;
+    // entry i holds the string with ID i
+    struct { HH__intern_key_t key; uint32_t val; }* index;
+};
+
+size_t
+HH__intern_hash(const void* ptr, size_t sz, size_t seed);
+int
+HH__intern_comp(const void* fst, const void* snd, size_t sz);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+size_t
+HH__intern_hash(const void* ptr, size_t sz, size_t seed) {
+    (void) sz;
+    const HH__intern_key_t* key = ptr;
+    return hh_hash_wide(key->ptr, key->len, seed);
+}
+
+int
+HH__intern_comp(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    const HH__intern_key_t* key_fst = fst;
+    const HH__intern_key_t* key_snd = snd;
+    if(key_fst->len != key_snd->len) return 1;
+    return memcmp(key_fst->ptr, key_snd->ptr, key_fst->len);
+}
+
+uint32_t
+hh_intern(hh_intern_t* in, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_intern_n(in, str, strlen(str));
+}
+
+uint32_t
+hh_intern_n(hh_intern_t* in, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT_INVARIANT(str != NULL || len == 0);
+    if(in->index == NULL) {
+        hh_hmapconfig(in->index, .key_f.hash = HH__intern_hash,
+            .key_f.comp = HH__intern_comp, .layout = HH_HMAP_FLAT);
+    }
+    HH__intern_key_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    size_t hash = hh_hmaphash(in->index, &key);
+    size_t idx = hh_hmapget_hashed(in->index, &key, hash);
+    if(idx != SIZE_MAX) return (uint32_t) idx;
+    HH_ASSERT(hh_hmaplen(in->index) < HH_INTERN_NONE, "hh_intern ran out of IDs");
+    // copy the string into the arena
+    char* copy = hh_arena_alloc(&(in->arena), len + 1);
+    HH_ASSERT(copy != NULL, "hh_intern failed to allocate");
+    memcpy(copy, key.ptr, len);
+    copy[len] = '\0';
+    key.ptr = copy;
+    uint32_t id = (uint32_t) hh_hmaplen(in->index);
+    (void) hh_hmapinsert_hashed(in->index, &key, id, hash);
+    return id;
+}
+
+uint32_t
+hh_intern_find(const hh_intern_t* in, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_intern_find_n(in, str, strlen(str));
+}
+
+uint32_t
+hh_intern_find_n(const hh_intern_t* in, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    if(in->index == NULL) return HH_INTERN_NONE;
+    HH__intern_key_t key = { .ptr = (str == NULL) ? "" : str, .len = len };
+    size_t idx = hh_hmapget(in->index, &key);
+    return (idx == SIZE_MAX) ? HH_INTERN_NONE : (uint32_t) idx;
+}
+
+const char*
+hh_intern_str(const hh_intern_t* in, uint32_t id) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT(id < hh_intern_count(in), "hh_intern_str received an unknown ID: %u", id);
+    return in->index[id].key.ptr;
+}
+
+size_t
+hh_intern_len(const hh_intern_t* in, uint32_t id) {
+    HH_ASSERT_INVARIANT(in != NULL);
+    HH_ASSERT(id < hh_intern_count(in), "hh_intern_len received an unknown ID: %u", id);
+    return in->index[id].key.len;
+}
+
+void
+hh_intern_free(hh_intern_t* in) {
+    if(in == NULL) return;
+    hh_hmapfree(in->index);
+    hh_arena_free(&(in->arena));
+    memset(in, 0, sizeof(hh_intern_t));
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_INTERN__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define intern_t hh_intern_t
+#define INTERN_NONE HH_INTERN_NONE
+#define intern hh_intern
+#define intern_n hh_intern_n
+#define intern_find hh_intern_find
+#define intern_find_n hh_intern_find_n
+#define intern_str hh_intern_str
+#define intern_len hh_intern_len
+#define intern_count hh_intern_count
+#define intern_span hh_intern_span
+#define intern_find_span hh_intern_find_span
+#define intern_free hh_intern_free
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
@@ -0,0 +1,348 @@
+#ifndef HH_LRU__
+#define HH_LRU__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_lru_t is a least-recently-used cache from byte-string keys to values
+// get, put and eviction are O(1): entries live in an hmap and are threaded
+// on an intrusive recency list that follows them when the hmap moves them around
+// keys are copied (into recycled arena blocks), values are opaque pointers owned by the caller,
+// which are handed back through .evict once the cache lets go of them
+// a zero-initialized hh_lru_t is ready for use (and never evicts)
+// EXAMPLE:
+// hh_lru_t cache = {0};
+// hh_lru_config(&cache, .max_bytes = 1 << 20, .evict = release);
+// image_t* img = hh_lru_get(&cache, path, strlen(path));
+// if(img == NULL) hh_lru_put(&cache, path, strlen(path), img = load(path), img->size);
+// hh_lru_free(&cache);
+typedef struct HH__lru_t hh_lru_t;
+
+// configuration options for hh_lru_t, applied through hh_lru_config
+// max_entries: entries kept before the least recently used ones are evicted (0 for no limit)
+// max_bytes:   total size (as passed to hh_lru_put) kept before evicting (0 for no limit)
+//              the most recently put entry is kept even if it alone exceeds the limit
+// evict:       called with every value the cache drops: on eviction, when hh_lru_put replaces it
+//              with a different pointer, and for the remaining entries in hh_lru_free
+//              not called by hh_lru_remove, which returns the value instead
+// ctx:         passed to evict
+typedef struct {
+    size_t max_entries;
+    size_t max_bytes;
+    void (*evict)(const void* key, size_t len, void* val, void* ctx);
+    void* ctx;
+} hh_lru_opt;
+
+// counters returned by hh_lru_stats
+typedef struct {
+    size_t len, bytes;
+    size_t hits, misses, evictions;
+} hh_lru_stats_t;
+
+// sets the cache's options, evicting entries that no longer fit
+#define hh_lru_config(lru, ...) (HH__lru_config((lru), (hh_lru_opt) { __VA_ARGS__ }))
+// returns the value stored for key (marking it most recently used) or NULL
+// counts a hit or a miss
+void*
+hh_lru_get(hh_lru_t* lru, const void* key, size_t len);
+// inserts or replaces the value for key, marks it most recently used
+// and evicts least recently used entries until the cache is within its limits
+// size is the value's cost against .max_bytes
+void
+hh_lru_put(hh_lru_t* lru, const void* key, size_t len, void* val, size_t size);
+// removes key without calling .evict, returns its value (or NULL if it was absent)
+void*
+hh_lru_remove(hh_lru_t* lru, const void* key, size_t len);
+// returns the number of entries
+size_t
+hh_lru_len(const hh_lru_t* lru);
+hh_lru_stats_t
+hh_lru_stats(const hh_lru_t* lru);
+// passes every remaining value to .evict, frees the cache and resets it (options included)
+void
+hh_lru_free(hh_lru_t* lru);
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// key blocks are recycled through per-size free lists, sizes 8, 16, ..., 8 << (HH__LRU_CLASSES - 1)
+// longer keys are malloc'd
+#define HH__LRU_CLASSES 10
+
+typedef struct {
+    const char* ptr;
+    size_t len;
+} HH__lru_key_t;
+
+// prev/next are entry indices (SIZE_MAX at either end of the list)
+typedef struct {
+    void* val;
+    size_t size;
+    size_t prev, next;
+} HH__lru_node_t;
+
+struct HH__lru_t {
+    hh_lru_opt opt;
+    struct { HH__lru_key_t key; HH__lru_node_t val; }* index;
+    // most and least recently used entries, only meaningful while the cache isn't empty
+    size_t head, tail;
+    size_t bytes, hits, misses, evictions;
+    hh_arena arena;
+    void* free_keys[HH__LRU_CLASSES];
+};
+
+void
+HH__lru_config(hh_lru_t* lru, hh_lru_opt opt);
+size_t
+HH__lru_hash(const void* ptr, size_t sz, size_t seed);
+int
+HH__lru_comp(const void* fst, const void* snd, size_t sz);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+size_t
+HH__lru_hash(const void* ptr, size_t sz, size_t seed) {
+    (void) sz;
+    const HH__lru_key_t* key = ptr;
+    return hh_hash_wide(key->ptr, key->len, seed);
+}
+
+int
+HH__lru_comp(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    const HH__lru_key_t* key_fst = fst;
+    const HH__lru_key_t* key_snd = snd;
+    if(key_fst->len != key_snd->len) return 1;
+    return memcmp(key_fst->ptr, key_snd->ptr, key_fst->len);
+}
+
+// size class of a key block, HH__LRU_CLASSES if it is too long for the free lists
+static size_t
+HH__lru_class(size_t len) {
+    size_t cls = 0;
+    while(cls < HH__LRU_CLASSES && ((size_t) 8 << cls) < len) ++cls;
+    return cls;
+}
+
+static const char*
+HH__lru_keycopy(hh_lru_t* lru, const void* key, size_t len) {
+    size_t cls = HH__lru_class(len);
+    char* copy;
+    if(cls == HH__LRU_CLASSES) {
+        copy = malloc(len);
+    } else if(lru->free_keys[cls] != NULL) {
+        // the first word of a free block links to the next one
+        copy = lru->free_keys[cls];
+        memcpy(&(lru->free_keys[cls]), copy, sizeof(void*));
+    } else {
+        copy = hh_arena_alloc(&(lru->arena), (size_t) 8 << cls);
+    }
+    HH_ASSERT(copy != NULL, "hh_lru_put failed to allocate");
+    if(len > 0) memcpy(copy, key, len);
+    return copy;
+}
+
+static void
+HH__lru_keyfree(hh_lru_t* lru, const HH__lru_key_t* key) {
+    size_t cls = HH__lru_class(key->len);
+    if(cls == HH__LRU_CLASSES) {
+        free((void*) key->ptr);
+        return;
+    }
+    memcpy((void*) key->ptr, &(lru->free_keys[cls]), sizeof(void*));
+    lru->free_keys[cls] = (void*) key->ptr;
+}
+
+// takes entry idx off the recency list
+static void
+HH__lru_unlink(hh_lru_t* lru, size_t idx) {
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    if(node->prev == SIZE_MAX) lru->head = node->next;
+    else lru->index[node->prev].val.next = node->next;
+    if(node->next == SIZE_MAX) lru->tail = node->prev;
+    else lru->index[node->next].val.prev = node->prev;
+}
+
+// puts entry idx at the front of the recency list
+static void
+HH__lru_link(hh_lru_t* lru, size_t idx) {
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    node->prev = SIZE_MAX;
+    // idx is the only linked entry
+    if(hh_hmaplen(lru->index) == 1) {
+        node->next = SIZE_MAX;
+        lru->head = lru->tail = idx;
+        return;
+    }
+    node->next = lru->head;
+    lru->index[lru->head].val.prev = idx;
+    lru->head = idx;
+}
+
+// removes (the already unlinked) entry idx from the index and releases its key
+// the hmap fills the gap with its last entry, whose neighbours are pointed at its new index
+static void
+HH__lru_removeat(hh_lru_t* lru, size_t idx) {
+    HH__lru_keyfree(lru, &(lru->index[idx].key));
+    lru->bytes -= lru->index[idx].val.size;
+    size_t last = hh_hmaplen(lru->index) - 1;
+    HH__hmapremoveat(lru->index, idx);
+    if(idx == last) return;
+    HH__lru_node_t* node = &(lru->index[idx].val);
+    if(node->prev == SIZE_MAX) lru->head = idx;
+    else lru->index[node->prev].val.next = idx;
+    if(node->next == SIZE_MAX) lru->tail = idx;
+    else lru->index[node->next].val.prev = idx;
+}
+
+// evicts least recently used entries until the cache is within its limits
+// keep_head spares the most recently used entry, i.e. the one hh_lru_put just stored
+static void
+HH__lru_trim(hh_lru_t* lru, _Bool keep_head) {
+    while(hh_hmaplen(lru->index) > (keep_head ? 1u : 0u) &&
+        ((lru->opt.max_entries > 0 && hh_hmaplen(lru->index) > lru->opt.max_entries) ||
+        (lru->opt.max_bytes > 0 && lru->bytes > lru->opt.max_bytes))) {
+        size_t idx = lru->tail;
+        HH__lru_unlink(lru, idx);
+        if(lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[idx].key.ptr, lru->index[idx].key.len, lru->index[idx].val.val, lru->opt.ctx);
+        }
+        ++(lru->evictions);
+        HH__lru_removeat(lru, idx);
+    }
+}
+
+void
+HH__lru_config(hh_lru_t* lru, hh_lru_opt opt) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    lru->opt = opt;
+    HH__lru_trim(lru, 0);
+}
+
+void*
+hh_lru_get(hh_lru_t* lru, const void* key, size_t len) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t idx = (lru->index == NULL) ? SIZE_MAX : hh_hmapget(lru->index, &probe);
+    if(idx == SIZE_MAX) {
+        ++(lru->misses);
+        return NULL;
+    }
+    ++(lru->hits);
+    if(idx != lru->head) {
+        HH__lru_unlink(lru, idx);
+        HH__lru_link(lru, idx);
+    }
+    return lru->index[idx].val.val;
+}
+
+void
+hh_lru_put(hh_lru_t* lru, const void* key, size_t len, void* val, size_t size) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    if(lru->index == NULL) {
+        hh_hmapconfig(lru->index, .key_f.hash = HH__lru_hash,
+            .key_f.comp = HH__lru_comp, .layout = HH_HMAP_FLAT);
+    }
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t hash = hh_hmaphash(lru->index, &probe);
+    size_t idx = hh_hmapget_hashed(lru->index, &probe, hash);
+    if(idx != SIZE_MAX) {
+        HH__lru_node_t* node = &(lru->index[idx].val);
+        if(node->val != val && lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[idx].key.ptr, len, node->val, lru->opt.ctx);
+        }
+        lru->bytes = lru->bytes - node->size + size;
+        node->val = val;
+        node->size = size;
+        HH__lru_unlink(lru, idx);
+    } else {
+        probe.ptr = HH__lru_keycopy(lru, probe.ptr, len);
+        (void) hh_hmapinsert_hashed(lru->index, &probe, ((HH__lru_node_t) { .val = val, .size = size }), hash);
+        idx = hh_hmaplen(lru->index) - 1;
+        lru->bytes += size;
+    }
+    HH__lru_link(lru, idx);
+    HH__lru_trim(lru, 1);
+}
+
+void*
+hh_lru_remove(hh_lru_t* lru, const void* key, size_t len) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    HH_ASSERT_INVARIANT(key != NULL || len == 0);
+    HH__lru_key_t probe = { .ptr = (key == NULL) ? "" : key, .len = len };
+    size_t idx = (lru->index == NULL) ? SIZE_MAX : hh_hmapget(lru->index, &probe);
+    if(idx == SIZE_MAX) return NULL;
+    void* val = lru->index[idx].val.val;
+    HH__lru_unlink(lru, idx);
+    HH__lru_removeat(lru, idx);
+    return val;
+}
+
+size_t
+hh_lru_len(const hh_lru_t* lru) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    return hh_hmaplen(lru->index);
+}
+
+hh_lru_stats_t
+hh_lru_stats(const hh_lru_t* lru) {
+    HH_ASSERT_INVARIANT(lru != NULL);
+    return (hh_lru_stats_t) {
+        .len = hh_hmaplen(lru->index), .bytes = lru->bytes,
+        .hits = lru->hits, .misses = lru->misses, .evictions = lru->evictions
+    };
+}
+
+void
+hh_lru_free(hh_lru_t* lru) {
+    if(lru == NULL) return;
+    for(size_t i = 0; i < hh_hmaplen(lru->index); ++i) {
+        if(lru->opt.evict != NULL) {
+            (lru->opt.evict)(lru->index[i].key.ptr, lru->index[i].key.len, lru->index[i].val.val, lru->opt.ctx);
+        }
+        // only long keys live outside the arena
+        if(HH__lru_class(lru->index[i].key.len) == HH__LRU_CLASSES) free((void*) lru->index[i].key.ptr);
+    }
+    hh_hmapfree(lru->index);
+    hh_arena_free(&(lru->arena));
+    memset(lru, 0, sizeof(hh_lru_t));
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_LRU__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define lru_t hh_lru_t
+#define lru_opt hh_lru_opt
+#define lru_stats_t hh_lru_stats_t
+#define lru_config hh_lru_config
+#define lru_get hh_lru_get
+#define lru_put hh_lru_put
+#define lru_remove hh_lru_remove
+#define lru_len hh_lru_len
+#define lru_stats hh_lru_stats
+#define lru_free hh_lru_free
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
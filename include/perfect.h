@@ -0,0 +1,311 @@
+#ifndef HH_PERFECT__
+#define HH_PERFECT__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_perfect_t is a minimal perfect hash table over a fixed set of strings (e.g. keywords)
+// it is built once from the key set, every key then owns exactly one of `count` slots,
+// so a lookup is one hash, one slot and one comparison
+// lookups return the key's index in the array passed to hh_perfect_build
+// EXAMPLE:
+// const char* keywords[] = { "if", "else", "while" };
+// hh_perfect_t kw = {0};
+// if(!hh_perfect_build(&kw, keywords, 3)) { ... }
+// hh_span_t tok = hh_span_next(&src, .delim = " ");
+// switch(hh_perfect_find_span(&kw, tok)) { case 0: ... }
+// hh_perfect_free(&kw);
+// the table can also be generated at build time with hh_perfect_emit,
+// the emitted file defines a ready-to-use `static const hh_perfect_t`
+typedef struct {
+    size_t count, bucket_count;
+    size_t seed;
+    // per-bucket displacement, keys in bucket b are placed by hashing with pilots[b]
+    const uint32_t* pilots;
+    // index (in the built key set) of the key in each slot
+    const uint32_t* ids;
+    // the key in slot i is chars[offs[i]..offs[i + 1])
+    const uint32_t* offs;
+    const char* chars;
+    // owned allocation, NULL for emitted tables
+    void* mem;
+} hh_perfect_t;
+
+// returned by the hh_perfect_find family when a string isn't in the set
+#define HH_PERFECT_NONE UINT32_MAX
+
+// average number of keys per bucket, larger buckets shrink the table but slow down the build
+#ifndef HH_PERFECT_BUCKET_SIZE
+#define HH_PERFECT_BUCKET_SIZE 2
+#endif // not HH_PERFECT_BUCKET_SIZE
+
+// builds the table for n null-terminated keys, replacing its previous contents
+// returns falsy (leaving the table untouched) if a key occurs twice
+// the keys are copied, they don't have to outlive the table
+_Bool
+hh_perfect_build(hh_perfect_t* table, const char* const* keys, size_t n);
+// returns the index of the string among the built keys, or HH_PERFECT_NONE
+uint32_t
+hh_perfect_find(const hh_perfect_t* table, const char* str);
+// same as hh_perfect_find, the string is given by its first len bytes
+uint32_t
+hh_perfect_find_n(const hh_perfect_t* table, const char* str, size_t len);
+// span variant (see span.h)
+#define hh_perfect_find_span(table, span) (hh_perfect_find_n((table), (span).ptr, hh_span_len(span)))
+// writes a C header defining `static const hh_perfect_t name` (and its arrays) to path,
+// returns truthy on success
+// hashes are word-size dependent, so the header must be compiled for the same word size
+_Bool
+hh_perfect_emit(const hh_perfect_t* table, const char* name, const char* path);
+// frees a built table and zeroes it
+void
+hh_perfect_free(hh_perfect_t* table);
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// pilots tried for a bucket before the build starts over with another seed
+#define HH__PERFECT_MAX_PILOT (1u << 20)
+// seeds tried before hh_perfect_build gives up
+#define HH__PERFECT_MAX_SEED 64
+
+// the bucket is picked by the high half of the mixed hash, the slot by the hash mixed with the pilot
+// (mixed to 64 bits first, where size_t is 32 bits the hash itself has no high half)
+static inline size_t
+HH__perfectbucket(uint64_t hash, size_t bucket_count) {
+    return (size_t) (((HH__mix64(hash) >> 32) * (uint64_t) bucket_count) >> 32);
+}
+
+static inline size_t
+HH__perfectslot(uint64_t hash, uint32_t pilot, size_t count) {
+    return (size_t) (((uint64_t) (uint32_t) hh_hash_int(hash, pilot) * (uint64_t) count) >> 32);
+}
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+typedef struct {
+    uint64_t hash;
+    size_t bucket, idx;
+} HH__perfectkey_t;
+
+typedef struct {
+    size_t start, len;
+} HH__perfectrange_t;
+
+static int
+HH__perfectkeycomp(const void* fst, const void* snd) {
+    const HH__perfectkey_t* key_fst = fst;
+    const HH__perfectkey_t* key_snd = snd;
+    if(key_fst->bucket != key_snd->bucket) return (key_fst->bucket > key_snd->bucket) ? 1 : -1;
+    return (key_fst->hash > key_snd->hash) - (key_fst->hash < key_snd->hash);
+}
+
+// largest buckets first, they are the hardest to place
+static int
+HH__perfectrangecomp(const void* fst, const void* snd) {
+    const HH__perfectrange_t* range_fst = fst;
+    const HH__perfectrange_t* range_snd = snd;
+    if(range_fst->len != range_snd->len) return (range_fst->len < range_snd->len) ? 1 : -1;
+    return (range_fst->start > range_snd->start) - (range_fst->start < range_snd->start);
+}
+
+// places every bucket, returns falsy if some bucket can't be placed with this seed
+static _Bool
+HH__perfectplace(const HH__perfectkey_t* order, const HH__perfectrange_t* ranges, size_t range_count,
+    size_t n, uint32_t* pilots, size_t* slot_of, unsigned char* taken) {
+    memset(taken, 0, n);
+    for(size_t r = 0; r < range_count; ++r) {
+        const HH__perfectkey_t* bucket = order + ranges[r].start;
+        size_t len = ranges[r].len;
+        uint32_t pilot = 0;
+        for(; pilot < HH__PERFECT_MAX_PILOT; ++pilot) {
+            size_t i = 0;
+            for(; i < len; ++i) {
+                size_t slot = HH__perfectslot(bucket[i].hash, pilot, n);
+                if(taken[slot]) break;
+                // claim slots as we go, so keys of the same bucket can't share one
+                taken[slot] = 1;
+                slot_of[bucket[i].idx] = slot;
+            }
+            if(i == len) break;
+            while(i-- > 0) taken[slot_of[bucket[i].idx]] = 0;
+        }
+        if(pilot == HH__PERFECT_MAX_PILOT) return 0;
+        pilots[bucket[0].bucket] = pilot;
+    }
+    return 1;
+}
+
+_Bool
+hh_perfect_build(hh_perfect_t* table, const char* const* keys, size_t n) {
+    HH_ASSERT_INVARIANT(table != NULL);
+    HH_ASSERT_INVARIANT(keys != NULL || n == 0);
+    HH_ASSERT(n < UINT32_MAX, "hh_perfect_build received too many keys");
+    size_t bucket_count = n / HH_PERFECT_BUCKET_SIZE + 1, chars = 0;
+    for(size_t i = 0; i < n; ++i) chars += strlen(keys[i]);
+    HH_ASSERT(chars < UINT32_MAX, "hh_perfect_build received too many characters");
+    HH__perfectkey_t* order = malloc(n * sizeof(HH__perfectkey_t) + 1);
+    HH__perfectrange_t* ranges = malloc(bucket_count * sizeof(HH__perfectrange_t));
+    size_t* slot_of = malloc(n * sizeof(size_t) + 1);
+    unsigned char* taken = malloc(n + 1);
+    HH_ASSERT(order != NULL && ranges != NULL && slot_of != NULL && taken != NULL,
+        "hh_perfect_build failed to allocate");
+    // a single allocation holds the pilots, ids, offsets and characters
+    size_t size = (bucket_count + 2 * n + 1) * sizeof(uint32_t) + chars;
+    char* mem = malloc(size);
+    HH_ASSERT(mem != NULL, "hh_perfect_build failed to allocate");
+    uint32_t* pilots = (uint32_t*) mem;
+    uint32_t* ids = pilots + bucket_count;
+    uint32_t* offs = ids + n;
+    char* heap = (char*) (offs + n + 1);
+    size_t seed = 0, range_count = 0, attempt = 0;
+    for(; attempt < HH__PERFECT_MAX_SEED; ++attempt) {
+        seed = hh_hash_int(attempt, 0x5EED);
+        for(size_t i = 0; i < n; ++i) {
+            uint64_t hash = (uint64_t) hh_hash_wide(keys[i], strlen(keys[i]), seed);
+            order[i] = (HH__perfectkey_t) { .hash = hash, .bucket = HH__perfectbucket(hash, bucket_count), .idx = i };
+        }
+        qsort(order, n, sizeof(HH__perfectkey_t), HH__perfectkeycomp);
+        // keys with equal hashes can never be separated
+        size_t i = 1;
+        for(; i < n && order[i].hash != order[i - 1].hash; ++i);
+        if(i < n) {
+            if(strcmp(keys[order[i].idx], keys[order[i - 1].idx]) != 0) continue;
+            HH_ERR("hh_perfect_build received a duplicate key [%s].", keys[order[i].idx]);
+            attempt = HH__PERFECT_MAX_SEED;
+            break;
+        }
+        range_count = 0;
+        for(size_t start = 0; start < n; start = i) {
+            for(i = start + 1; i < n && order[i].bucket == order[start].bucket; ++i);
+            ranges[range_count++] = (HH__perfectrange_t) { .start = start, .len = i - start };
+        }
+        qsort(ranges, range_count, sizeof(HH__perfectrange_t), HH__perfectrangecomp);
+        memset(pilots, 0, bucket_count * sizeof(uint32_t));
+        if(HH__perfectplace(order, ranges, range_count, n, pilots, slot_of, taken)) break;
+    }
+    free(order);
+    free(ranges);
+    free(taken);
+    if(attempt == HH__PERFECT_MAX_SEED) {
+        free(slot_of);
+        free(mem);
+        return 0;
+    }
+    // lay the keys out in slot order
+    for(size_t i = 0; i < n; ++i) ids[slot_of[i]] = (uint32_t) i;
+    offs[0] = 0;
+    for(size_t slot = 0; slot < n; ++slot) {
+        size_t len = strlen(keys[ids[slot]]);
+        memcpy(heap + offs[slot], keys[ids[slot]], len);
+        offs[slot + 1] = offs[slot] + (uint32_t) len;
+    }
+    free(slot_of);
+    hh_perfect_free(table);
+    *table = (hh_perfect_t) {
+        .count = n, .bucket_count = bucket_count, .seed = seed,
+        .pilots = pilots, .ids = ids, .offs = offs, .chars = heap, .mem = mem
+    };
+    return 1;
+}
+
+uint32_t
+hh_perfect_find(const hh_perfect_t* table, const char* str) {
+    HH_ASSERT_INVARIANT(str != NULL);
+    return hh_perfect_find_n(table, str, strlen(str));
+}
+
+uint32_t
+hh_perfect_find_n(const hh_perfect_t* table, const char* str, size_t len) {
+    HH_ASSERT_INVARIANT(table != NULL);
+    if(table->count == 0) return HH_PERFECT_NONE;
+    uint64_t hash = (uint64_t) hh_hash_wide(str, len, table->seed);
+    size_t slot = HH__perfectslot(hash, table->pilots[HH__perfectbucket(hash, table->bucket_count)], table->count);
+    const char* key = table->chars + table->offs[slot];
+    if(table->offs[slot + 1] - table->offs[slot] != len || memcmp(key, str, len) != 0) return HH_PERFECT_NONE;
+    return table->ids[slot];
+}
+
+// writes an array of uint32_t as a C initializer
+static void
+HH__perfectemitarr(FILE* f, const char* name, const char* suffix, const uint32_t* arr, size_t n) {
+    fprintf(f, "static const uint32_t %s_%s[] = {", name, suffix);
+    for(size_t i = 0; i < n; ++i) fprintf(f, "%s%luu,", (i % 8 == 0) ? "\n    " : " ", (unsigned long) arr[i]);
+    // an empty initializer isn't valid C99
+    if(n == 0) fprintf(f, " 0");
+    fprintf(f, "\n};\n");
+}
+
+_Bool
+hh_perfect_emit(const hh_perfect_t* table, const char* name, const char* path) {
+    HH_ASSERT_INVARIANT(table != NULL && name != NULL && path != NULL);
+    FILE* f = fopen(path, "w");
+    if(f == NULL) {
+        HH_ERR("Failed to open file at path [%s].", path);
+        return 0;
+    }
+    fprintf(f, "// generated by hh_perfect_emit, %zu keys\n", table->count);
+    fprintf(f, "#if SIZE_MAX != %zuu\n#error \"%s was generated for a different word size\"\n#endif\n",
+        (size_t) SIZE_MAX, name);
+    HH__perfectemitarr(f, name, "pilots", table->pilots, table->bucket_count);
+    HH__perfectemitarr(f, name, "ids", table->ids, table->count);
+    // a table that was never built has no offsets at all
+    HH__perfectemitarr(f, name, "offs", table->offs, (table->offs == NULL) ? 0 : table->count + 1);
+    size_t chars = (table->offs == NULL) ? 0 : table->offs[table->count];
+    fprintf(f, "static const char %s_chars[] = {", name);
+    for(size_t i = 0; i < chars; ++i) fprintf(f, "%s%d,", (i % 16 == 0) ? "\n    " : " ", (int) table->chars[i]);
+    if(chars == 0) fprintf(f, " 0");
+    fprintf(f, "\n};\n");
+    fprintf(f, "static const hh_perfect_t %s = {\n", name);
+    fprintf(f, "    .count = %zu, .bucket_count = %zu, .seed = %zuu,\n", table->count, table->bucket_count, table->seed);
+    fprintf(f, "    .pilots = %s_pilots, .ids = %s_ids, .offs = %s_offs, .chars = %s_chars\n};\n",
+        name, name, name, name);
+    _Bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = 0;
+    if(!ok) {
+        HH_ERR("Failed to write file at path [%s].", path);
+    }
+    return ok;
+}
+
+void
+hh_perfect_free(hh_perfect_t* table) {
+    if(table == NULL) return;
+    free(table->mem);
+    memset(table, 0, sizeof(hh_perfect_t));
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_PERFECT__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define perfect_t hh_perfect_t
+#define PERFECT_NONE HH_PERFECT_NONE
+#define perfect_build hh_perfect_build
+#define perfect_find hh_perfect_find
+#define perfect_find_n hh_perfect_find_n
+#define perfect_find_span hh_perfect_find_span
+#define perfect_emit hh_perfect_emit
+#define perfect_free hh_perfect_free
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
@@ -126,18 +126,12 @@ hh_profiler_end(hh_profiler_t* profiler) {
         hh_darrput(root->inner.stats.keys, '\0');
         HH__profiler_full_name(root, profiler);
         const char* key = root->inner.stats.keys + offset;
-        // check if it's the first iteration
-        size_t idx = hh_hmapget(root->inner.stats.inner, &key);
-        if(idx == SIZE_MAX) {
-            // insert the first data point for this profiler
-            hh_bench_t bench = { .mean = elapsed, .count = 1 };
-            hh_hmapinsert(root->inner.stats.inner, &key, bench);
-        } else {
-            // the key already exists, so remove the one we constructed
-            hh_darrheader(root->inner.stats.keys)->len = offset;
-            // compute incremental mean
-            hh_bench_update(&root->inner.stats.inner[idx].val, elapsed);
-        }
+        // a zeroed bench is inserted on the first iteration
+        hh_bench_t* bench = hh_hmapupsert(root->inner.stats.inner, &key);
+        // if the key already existed, remove the one we constructed
+        if(bench->count > 0) hh_darrheader(root->inner.stats.keys)->len = offset;
+        // compute incremental mean
+        hh_bench_update(bench, elapsed);
     }
 }
 // SECTION(IMPLEMENTATION, END)
@@ -0,0 +1,266 @@
+#ifndef HH_SEG__
+#define HH_SEG__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// hh_seg_t is a segmented array: elements live in chunks of doubling size,
+// chunk k holds HH_SEG_FIRST_CHUNK << k elements
+// growing allocates the next chunk and never moves existing elements, so pointers to them
+// stay valid until hh_seg_free, and appends never pay for a copy of the whole array
+// chunk sizes double like darr capacities, so at most half of the reserved slots go unused
+// indexing is O(1): the chunk is the index's highest set bit and the chunk directory
+// is a fixed array inside hh_seg_t, so it never reallocates either
+// chunks are contiguous, so long scans should walk them with hh_seg_chunk instead of hh_seg_get
+// a zero-initialized hh_seg_t must be configured with hh_seg_config before use
+// EXAMPLE:
+// hh_seg_t events = {0};
+// hh_seg_config(&events, .elem_size = sizeof(event_t));
+// event_t* ev = hh_seg_push(&events, NULL);
+// for(size_t k = 0; k < hh_seg_chunks(&events); ++k) {
+//     size_t len;
+//     event_t* chunk = hh_seg_chunk(&events, k, &len);
+//     for(size_t i = 0; i < len; ++i) process(&chunk[i]);
+// }
+// hh_seg_free(&events);
+typedef struct HH__seg_t hh_seg_t;
+
+// number of elements in the first chunk, must be a power of two
+#ifndef HH_SEG_FIRST_CHUNK
+#define HH_SEG_FIRST_CHUNK 64
+#endif // not HH_SEG_FIRST_CHUNK
+
+// configuration options for hh_seg_t, applied through hh_seg_config on an empty array
+// elem_size: size of the elements in bytes
+// alloc:     allocator the chunks come from (see hh_allocator_t), NULL for the global one
+typedef struct {
+    size_t elem_size;
+    const hh_allocator_t* alloc;
+} hh_seg_opt;
+
+#define hh_seg_config(seg, ...) (HH__seg_config((seg), (hh_seg_opt) { __VA_ARGS__ }))
+
+// hh_seg_push    appends a copy of the element at val (zeroed if val is NULL), returns a pointer to it
+// hh_seg_putn    appends n elements copied from src (zeroed if src is NULL) with one copy per chunk,
+//                returns the index of the first one
+// hh_seg_get     returns a pointer to element i, which must be less than hh_seg_len
+// hh_seg_pop     removes the last element, returns a pointer to it (valid until the next append)
+// hh_seg_clear   removes all elements, the chunks are kept for reuse
+// all returned pointers stay valid until hh_seg_free
+static inline void*
+hh_seg_push(hh_seg_t* seg, const void* val);
+size_t
+hh_seg_putn(hh_seg_t* seg, const void* src, size_t n);
+static inline void*
+hh_seg_get(const hh_seg_t* seg, size_t i);
+void*
+hh_seg_pop(hh_seg_t* seg);
+void
+hh_seg_clear(hh_seg_t* seg);
+// number of elements
+size_t
+hh_seg_len(const hh_seg_t* seg);
+// number of chunks holding elements
+size_t
+hh_seg_chunks(const hh_seg_t* seg);
+// chunk k (k < hh_seg_chunks), stores the number of elements in it in *len
+// every chunk but the last is full, so walking k = 0, 1, ... visits the elements in order
+void*
+hh_seg_chunk(const hh_seg_t* seg, size_t k, size_t* len);
+// frees all chunks, the options are kept
+void
+hh_seg_free(hh_seg_t* seg);
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// one chunk per bit of an index, enough to address any size_t
+#define HH__SEG_MAX_CHUNKS (sizeof(size_t) * 8)
+
+struct HH__seg_t {
+    hh_seg_opt opt;
+    size_t len;
+    // chunk k holds HH_SEG_FIRST_CHUNK << k elements, allocated on first use
+    char* chunks[HH__SEG_MAX_CHUNKS];
+};
+
+// index of the highest set bit, v must be non-zero
+static inline size_t
+HH__seg_log2(size_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(unsigned long long) * 8 - 1 - (size_t) __builtin_clzll((unsigned long long) v);
+#else
+    size_t idx = 0;
+    while(v >>= 1) ++idx;
+    return idx;
+#endif
+}
+
+// element i is at offset i + HH_SEG_FIRST_CHUNK - (HH_SEG_FIRST_CHUNK << k) of chunk k,
+// where HH_SEG_FIRST_CHUNK << k is the highest set bit of i + HH_SEG_FIRST_CHUNK
+HH__FORCE_INLINE void*
+HH__seg_at(const hh_seg_t* seg, size_t i) {
+    size_t pos = i + HH_SEG_FIRST_CHUNK;
+    size_t top = HH__seg_log2(pos);
+    size_t k = top - HH__seg_log2(HH_SEG_FIRST_CHUNK);
+    return seg->chunks[k] + (pos - ((size_t) 1 << top)) * seg->opt.elem_size;
+}
+
+static inline void*
+hh_seg_get(const hh_seg_t* seg, size_t i) {
+    HH_ASSERT(i < seg->len, "hh_seg_get received index %zu of %zu", i, seg->len);
+    return HH__seg_at(seg, i);
+}
+
+// copies into the current chunk inline, only a new chunk or a zeroed element goes through hh_seg_putn
+static inline void*
+hh_seg_push(hh_seg_t* seg, const void* val) {
+#if defined(__GNUC__) || defined(__clang__)
+    size_t pos = seg->len + HH_SEG_FIRST_CHUNK;
+    size_t top = HH__seg_log2(pos);
+    char* chunk = seg->chunks[top - HH__seg_log2(HH_SEG_FIRST_CHUNK)];
+    if(chunk != NULL && val != NULL) {
+        char* dst = chunk + (pos - ((size_t) 1 << top)) * seg->opt.elem_size;
+        __builtin_memcpy(dst, val, seg->opt.elem_size);
+        ++(seg->len);
+        return dst;
+    }
+#endif
+    return HH__seg_at(seg, hh_seg_putn(seg, val, 1));
+}
+
+void
+HH__seg_config(hh_seg_t* seg, hh_seg_opt opt);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+#if (HH_SEG_FIRST_CHUNK & (HH_SEG_FIRST_CHUNK - 1)) != 0 || HH_SEG_FIRST_CHUNK <= 0
+#error "HH_SEG_FIRST_CHUNK must be a power of two"
+#endif
+
+#define HH__SEG_CHUNK_LEN(k) ((size_t) HH_SEG_FIRST_CHUNK << (k))
+// index of the first element of chunk k
+#define HH__SEG_CHUNK_START(k) (HH__SEG_CHUNK_LEN(k) - HH_SEG_FIRST_CHUNK)
+
+void
+HH__seg_config(hh_seg_t* seg, hh_seg_opt opt) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->len == 0 && seg->chunks[0] == NULL, "hh_seg_config requires an empty array");
+    HH_ASSERT(opt.elem_size > 0, "hh_seg_config requires a non-zero elem_size");
+    // resolved now, so the chunks are all released through the allocator they came from
+    if(opt.alloc == NULL) opt.alloc = hh_allocator_get();
+    seg->opt = opt;
+}
+
+size_t
+hh_seg_putn(hh_seg_t* seg, const void* src, size_t n) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->opt.elem_size > 0, "hh_seg_putn requires hh_seg_config");
+    size_t first = seg->len;
+    const char* from = src;
+    while(n > 0) {
+        size_t k = HH__seg_log2(seg->len + HH_SEG_FIRST_CHUNK) - HH__seg_log2(HH_SEG_FIRST_CHUNK);
+        if(seg->chunks[k] == NULL) {
+            seg->chunks[k] = HH__alloc(seg->opt.alloc, HH__SEG_CHUNK_LEN(k) * seg->opt.elem_size, "hh_seg_putn");
+        }
+        size_t off = seg->len - HH__SEG_CHUNK_START(k);
+        size_t count = HH__SEG_CHUNK_LEN(k) - off;
+        if(count > n) count = n;
+        // chunks are reused after hh_seg_pop and hh_seg_clear, so they aren't necessarily zeroed
+        char* dst = seg->chunks[k] + off * seg->opt.elem_size;
+        if(from == NULL) {
+            memset(dst, 0, count * seg->opt.elem_size);
+        } else {
+            memcpy(dst, from, count * seg->opt.elem_size);
+            from += count * seg->opt.elem_size;
+        }
+        seg->len += count;
+        n -= count;
+    }
+    return first;
+}
+
+void*
+hh_seg_pop(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    HH_ASSERT(seg->len > 0, "hh_seg_pop received an empty array");
+    return HH__seg_at(seg, --(seg->len));
+}
+
+void
+hh_seg_clear(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    seg->len = 0;
+}
+
+size_t
+hh_seg_len(const hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    return seg->len;
+}
+
+size_t
+hh_seg_chunks(const hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    if(seg->len == 0) return 0;
+    return HH__seg_log2(seg->len - 1 + HH_SEG_FIRST_CHUNK) - HH__seg_log2(HH_SEG_FIRST_CHUNK) + 1;
+}
+
+void*
+hh_seg_chunk(const hh_seg_t* seg, size_t k, size_t* len) {
+    HH_ASSERT_INVARIANT(seg != NULL && len != NULL);
+    HH_ASSERT(k < hh_seg_chunks(seg), "hh_seg_chunk received chunk %zu of %zu", k, hh_seg_chunks(seg));
+    size_t rem = seg->len - HH__SEG_CHUNK_START(k);
+    *len = (rem < HH__SEG_CHUNK_LEN(k)) ? rem : HH__SEG_CHUNK_LEN(k);
+    return seg->chunks[k];
+}
+
+void
+hh_seg_free(hh_seg_t* seg) {
+    HH_ASSERT_INVARIANT(seg != NULL);
+    for(size_t k = 0; k < HH__SEG_MAX_CHUNKS && seg->chunks[k] != NULL; ++k) {
+        HH__release(seg->opt.alloc, seg->chunks[k], HH__SEG_CHUNK_LEN(k) * seg->opt.elem_size);
+        seg->chunks[k] = NULL;
+    }
+    seg->len = 0;
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_SEG__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define seg_t hh_seg_t
+#define seg_opt hh_seg_opt
+#define SEG_FIRST_CHUNK HH_SEG_FIRST_CHUNK
+#define seg_config hh_seg_config
+#define seg_push hh_seg_push
+#define seg_putn hh_seg_putn
+#define seg_get hh_seg_get
+#define seg_pop hh_seg_pop
+#define seg_clear hh_seg_clear
+#define seg_len hh_seg_len
+#define seg_chunks hh_seg_chunks
+#define seg_chunk hh_seg_chunk
+#define seg_free hh_seg_free
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
@@ -0,0 +1,226 @@
+#ifndef HH_SLOT__
+#define HH_SLOT__
+
+#include "core.h"
+
+// SECTION(HEADER)
+// a slot map is a dense array of values that hands out stable handles to them
+// the values are a regular dynamic array, so iteration and the read-only darr macros
+// (hh_darrlen, hh_darrlast, indexing) work on it as usual
+// removal moves the last value into the hole like hh_darrswapdel, but handles keep
+// pointing at their value, and handles to removed values are detected as stale
+// a handle packs a slot index (low 32 bits) and a generation (high 32 bits),
+// so resolving one is two array reads instead of a hash probe
+// only the hh_slot* macros may grow, shrink or free the array
+// EXAMPLE:
+// entity_t* entities = NULL;
+// hh_slot_t player = hh_slotinsert(entities, (entity_t) { .hp = 10 });
+// for(size_t i = 0; i < hh_darrlen(entities); ++i) update(&entities[i]);
+// entity_t* p = hh_slotget(entities, player);
+// hh_slotremove(entities, player);
+// ASSERT(hh_slotget(entities, player) == NULL);
+// hh_slotfree(entities);
+
+// handle to a value in a slot map
+typedef uint64_t hh_slot_t;
+
+// never refers to a value, usable as a null handle
+#define HH_SLOT_NONE ((hh_slot_t) 0)
+
+// hh_slotinsert  appends a value, returns its handle
+// hh_slotget     returns a pointer to the handle's value, or NULL if the handle is stale
+//                (the pointer is valid until the next insertion or removal)
+// hh_slotindex   returns the index of the handle's value in the array, or SIZE_MAX if the handle is stale
+// hh_slothas     returns truthy if the handle refers to a value
+// hh_slotremove  removes the handle's value, returns truthy if the handle wasn't stale
+// hh_slothandle  returns the handle of the value at index i
+// hh_slotclear   removes all values, every handle handed out so far becomes stale
+// hh_slotfree    frees the slot map and sets it to NULL
+#define hh_slotinsert(arr, val)  (HH__slotgrow((void**) &(arr), sizeof(*(arr))), \
+    (arr)[hh_darrheader(arr)->len] = (val), HH__slotpush(arr))
+#define hh_slotget(arr, handle)   (HH__slotget((arr), (handle)))
+#define hh_slotindex(arr, handle) (((arr) == NULL) ? SIZE_MAX : HH__slotindex((arr), (handle)))
+#define hh_slothas(arr, handle)   (hh_slotindex((arr), (handle)) != SIZE_MAX)
+#define hh_slotremove(arr, handle) (((arr) == NULL) ? 0 : HH__slotremove((arr), (handle)))
+#define hh_slothandle(arr, i)     (HH__slothandle((arr), (i)))
+#define hh_slotclear(arr)         (HH__slotclear(arr))
+#define hh_slotfree(arr)          (HH__slotfree(arr), (arr) = NULL)
+// SECTION(HEADER, END)
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+//
+//
+//
+
+// SECTION(HEADER_PRIVATE)
+// internal slot map components
+// the darr header comes last, so it sits right in front of the values
+typedef struct {
+    // slot i: index of its value while live (next free slot otherwise) and generation
+    struct { uint32_t idx, gen; }* slots;
+    // owners[j]: slot of the value at index j
+    uint32_t* owners;
+    // first free slot, UINT32_MAX if there is none
+    uint32_t free;
+    // rounds the fields above up to a multiple of 16 bytes, so the values are as aligned as a darr's
+    uint32_t pad[(16 - (2 * sizeof(void*) + sizeof(uint32_t)) % 16) / sizeof(uint32_t)];
+    hh_darrheader_t darr;
+} hh_slotheader_t;
+// fails to compile if the padding above is wrong
+typedef char HH__slotheader_aligned[(offsetof(hh_slotheader_t, darr) % 16 == 0) ? 1 : -1];
+// macro for retrieving slot map header
+#define hh_slotheader(arr) (((hh_slotheader_t*) (arr)) - 1)
+
+// returns the index of the handle's value, or SIZE_MAX
+HH__FORCE_INLINE size_t
+HH__slotindex(const void* arr, hh_slot_t handle) {
+    const hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = (uint32_t) handle;
+    // generations start at 1, so HH_SLOT_NONE never matches
+    if(slot >= hh_darrlen(arr_hdr->slots) || arr_hdr->slots[slot].gen != (uint32_t) (handle >> 32)) return SIZE_MAX;
+    return arr_hdr->slots[slot].idx;
+}
+
+static inline void*
+HH__slotget(void* arr, hh_slot_t handle) {
+    if(arr == NULL) return NULL;
+    size_t idx = HH__slotindex(arr, handle);
+    return (idx == SIZE_MAX) ? NULL : (char*) arr + idx * hh_darrheader(arr)->elem_size;
+}
+
+// implementations of slot map macros
+void
+HH__slotgrow(void** arr_ptr, size_t elem_size);
+hh_slot_t
+HH__slotpush(void* arr);
+_Bool
+HH__slotremove(void* arr, hh_slot_t handle);
+hh_slot_t
+HH__slothandle(const void* arr, size_t idx);
+void
+HH__slotclear(void* arr);
+void
+HH__slotfree(void* arr);
+// SECTION(HEADER_PRIVATE, END)
+
+#ifdef HH_IMPLEMENTATION
+// SECTION(IMPLEMENTATION)
+void
+HH__slotgrow(void** arr_ptr, size_t elem_size) {
+    HH_ASSERT_INVARIANT(arr_ptr != NULL);
+    HH_ASSERT_INVARIANT(elem_size > 0);
+    hh_slotheader_t* arr_hdr;
+    if(*arr_ptr == NULL) {
+        const hh_allocator_t* alloc = hh_allocator_get();
+        arr_hdr = HH__alloc(alloc, sizeof(hh_slotheader_t) + elem_size * HH_DARR_INITIAL_CAPACITY, "hh_slotinsert");
+        arr_hdr->free = UINT32_MAX;
+        arr_hdr->darr.cap = HH_DARR_INITIAL_CAPACITY;
+        arr_hdr->darr.elem_size = elem_size;
+        arr_hdr->darr.alloc = alloc;
+        *arr_ptr = (void*) (arr_hdr + 1);
+        return;
+    }
+    arr_hdr = hh_slotheader(*arr_ptr);
+    if(arr_hdr->darr.len < arr_hdr->darr.cap) return;
+    HH_ASSERT(arr_hdr->darr.len < UINT32_MAX - 1, "hh_slotinsert ran out of slots");
+    size_t cap = arr_hdr->darr.cap * 2;
+    arr_hdr = HH__resize(arr_hdr->darr.alloc, arr_hdr, sizeof(hh_slotheader_t) + arr_hdr->darr.cap * elem_size, 
+        sizeof(hh_slotheader_t) + cap * elem_size, "hh_slotinsert");
+    arr_hdr->darr.cap = cap;
+    *arr_ptr = (void*) (arr_hdr + 1);
+}
+
+hh_slot_t
+HH__slotpush(void* arr) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t idx = (uint32_t) (arr_hdr->darr.len)++;
+    uint32_t slot = arr_hdr->free;
+    if(slot == UINT32_MAX) {
+        slot = (uint32_t) hh_darradd(arr_hdr->slots, 1);
+        arr_hdr->slots[slot].gen = 1;
+    } else arr_hdr->free = arr_hdr->slots[slot].idx;
+    arr_hdr->slots[slot].idx = idx;
+    hh_darrput(arr_hdr->owners, slot);
+    return ((hh_slot_t) arr_hdr->slots[slot].gen << 32) | slot;
+}
+
+_Bool
+HH__slotremove(void* arr, hh_slot_t handle) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    size_t idx = HH__slotindex(arr, handle);
+    if(idx == SIZE_MAX) return 0;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = (uint32_t) handle;
+    // move the last value into the hole and repoint its slot
+    size_t last = --(arr_hdr->darr.len);
+    if(idx != last) {
+        size_t elem_size = arr_hdr->darr.elem_size;
+        memcpy((char*) arr + idx * elem_size, (char*) arr + last * elem_size, elem_size);
+        arr_hdr->owners[idx] = arr_hdr->owners[last];
+        arr_hdr->slots[arr_hdr->owners[idx]].idx = (uint32_t) idx;
+    }
+    (void) hh_darrpop(arr_hdr->owners);
+    // a new generation makes outstanding handles stale, 0 is skipped on wrap-around
+    if(++(arr_hdr->slots[slot].gen) == 0) arr_hdr->slots[slot].gen = 1;
+    arr_hdr->slots[slot].idx = arr_hdr->free;
+    arr_hdr->free = slot;
+    return 1;
+}
+
+hh_slot_t
+HH__slothandle(const void* arr, size_t idx) {
+    HH_ASSERT_INVARIANT(arr != NULL);
+    HH_ASSERT(idx < hh_darrlen(arr), "hh_slothandle received an out-of-bounds index: %zu", idx);
+    const hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    uint32_t slot = arr_hdr->owners[idx];
+    return ((hh_slot_t) arr_hdr->slots[slot].gen << 32) | slot;
+}
+
+void
+HH__slotclear(void* arr) {
+    if(arr == NULL) return;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    while(arr_hdr->darr.len > 0) (void) HH__slotremove(arr, HH__slothandle(arr, arr_hdr->darr.len - 1));
+}
+
+void
+HH__slotfree(void* arr) {
+    if(arr == NULL) return;
+    hh_slotheader_t* arr_hdr = hh_slotheader(arr);
+    hh_darrfree(arr_hdr->slots);
+    hh_darrfree(arr_hdr->owners);
+    HH__release(arr_hdr->darr.alloc, arr_hdr, sizeof(hh_slotheader_t) + arr_hdr->darr.cap * arr_hdr->darr.elem_size);
+}
+// SECTION(IMPLEMENTATION, END)
+#endif // HH_IMPLEMENTATION
+#endif // HH_SLOT__
+
+#ifndef HH__APPLY_PREFIXES
+#define HH__APPLY_PREFIXES
+#ifndef HH_APPLY_PREFIXES
+// SECTION(PREFIX)
+#define slot_t hh_slot_t
+#define SLOT_NONE HH_SLOT_NONE
+#define slotinsert hh_slotinsert
+#define slotget hh_slotget
+#define slotindex hh_slotindex
+#define slothas hh_slothas
+#define slotremove hh_slotremove
+#define slothandle hh_slothandle
+#define slotclear hh_slotclear
+#define slotfree hh_slotfree
+// SECTION(PREFIX, END)
+#endif // HH_APPLY_PREFIXES
+#endif // not HH__APPLY_PREFIXES
@@ -41,9 +41,17 @@ hh_span(char* contents);
 #define hh_span_next(span, ...) hh_span_next_opt((span), (hh_span_opt) { __VA_ARGS__ })
 
 size_t 
-hh_hash_span(const void* ptr, size_t sz);
+hh_hash_span(const void* ptr, size_t sz, size_t seed);
 int
 hh_comp_span(const void* fst, const void* snd, size_t sz);
+// compare a span probe against cstr keys without copying it (see hh_hmapget_probe)
+// hh_hash_span produces the same hash as hh_hash_cstr for equal contents
+// hh_comp_span_cstr:       keys are `const char*`
+// hh_comp_span_cstr_owned: keys are char arrays filled by hh_copy_cstr
+int
+hh_comp_span_cstr(const void* fst, const void* snd, size_t sz);
+int
+hh_comp_span_cstr_owned(const void* fst, const void* snd, size_t sz);
 // SECTION(HEADER, END)
 
 //
@@ -65,6 +73,8 @@ hh_comp_span(const void* fst, const void* snd, size_t sz);
 // SECTION(HEADER_PRIVATE)
 hh_span_t
 hh_span_next_opt(hh_span_t* s, hh_span_opt opt);
+// lets hh_hmapsave recognize maps with hh_span_t keys
+#define HH__HMAPFILE_SPAN_COMP hh_comp_span
 // SECTION(HEADER_PRIVATE, END)
 
 #ifdef HH_IMPLEMENTATION
@@ -133,10 +143,10 @@ hh_span_next_opt(hh_span_t* span, hh_span_opt opt) {
 }
 
 size_t 
-hh_hash_span(const void* ptr, size_t sz) {
+hh_hash_span(const void* ptr, size_t sz, size_t seed) {
     (void) sz;
     const hh_span_t* s = ptr;
-    return hh_hash_djb2(s->ptr, hh_span_len(*s));
+    return hh_hash_wide(s->ptr, hh_span_len(*s), seed);
 }
 
 int
@@ -150,6 +160,28 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
     if(ret != 0) return ret;
     return (len_fst > len_snd) - (len_fst < len_snd);
 }
+
+static inline int
+HH__comp_span_str(const hh_span_t* span, const char* str) {
+    size_t len = hh_span_len(*span);
+    // the span may hold a NUL, so str is measured first and never read past its terminator
+    size_t len_str = hh_strnlen(str, len + 1);
+    int ret = memcmp(span->ptr, str, HH_MIN(len, len_str));
+    if(ret != 0) return ret;
+    return (len > len_str) - (len < len_str);
+}
+
+int
+hh_comp_span_cstr(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    return HH__comp_span_str(fst, *((const char**) snd));
+}
+
+int
+hh_comp_span_cstr_owned(const void* fst, const void* snd, size_t sz) {
+    (void) sz;
+    return HH__comp_span_str(fst, (const char*) snd);
+}
 // SECTION(IMPLEMENTATION, END)
 #endif // HH_IMPLEMENTATION
 #endif // HH_SPAN__
@@ -167,6 +199,8 @@ hh_comp_span(const void* fst, const void* snd, size_t sz) {
 #define span_next hh_span_next
 #define hash_span hh_hash_span
 #define comp_span hh_comp_span
+#define comp_span_cstr hh_comp_span_cstr
+#define comp_span_cstr_owned hh_comp_span_cstr_owned
 // SECTION(PREFIX, END)
 #endif // HH_APPLY_PREFIXES
 #endif // not HH__APPLY_PREFIXES
@@ -0,0 +1,168 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 20000
+
+// counts live blocks and checks that the library reports their sizes correctly
+typedef struct {
+    size_t blocks, bytes, calls;
+} tracker_t;
+
+#define TRACKER_PAD 16
+
+static void*
+tracker_alloc(void* ctx, size_t size) {
+    tracker_t* tracker = ctx;
+    char* ptr = calloc(1, size + TRACKER_PAD);
+    if(ptr == NULL) return NULL;
+    memcpy(ptr, &size, sizeof(size_t));
+    ++(tracker->blocks);
+    ++(tracker->calls);
+    tracker->bytes += size;
+    return ptr + TRACKER_PAD;
+}
+
+static void*
+tracker_resize(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    tracker_t* tracker = ctx;
+    size_t size;
+    memcpy(&size, (char*) ptr - TRACKER_PAD, sizeof(size_t));
+    ASSERT(size == old_size, "hh_allocator_t.resize received %zu bytes as the old size of a %zu byte block", old_size, size);
+    char* block = realloc((char*) ptr - TRACKER_PAD, new_size + TRACKER_PAD);
+    if(block == NULL) return NULL;
+    memcpy(block, &new_size, sizeof(size_t));
+    ++(tracker->calls);
+    tracker->bytes = tracker->bytes - old_size + new_size;
+    return block + TRACKER_PAD;
+}
+
+static void
+tracker_release(void* ctx, void* ptr, size_t size) {
+    tracker_t* tracker = ctx;
+    size_t actual;
+    memcpy(&actual, (char*) ptr - TRACKER_PAD, sizeof(size_t));
+    ASSERT(size == actual, "hh_allocator_t.release received %zu bytes as the size of a %zu byte block", size, actual);
+    --(tracker->blocks);
+    tracker->bytes -= size;
+    free((char*) ptr - TRACKER_PAD);
+}
+
+// fills an array, an integer set and a map of both layouts, then frees them
+static void
+fill(int layout, const allocator_t* alloc) {
+    uint64_t* arr = NULL;
+    uint32_t* set = NULL;
+    if(alloc != NULL) {
+        darrinit(arr, alloc);
+        hsetinit(set, alloc);
+    }
+    struct { uint64_t key; uint64_t val; }* map = NULL;
+    hmapconfig(map, .layout = layout, .filter_fpr = 0.01, .alloc = alloc);
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        darrput(arr, i);
+        hsetinsert(set, i * 7);
+        uint64_t key = i * 7;
+        hmapinsert(map, &key, i);
+    }
+    for(uint64_t i = 0; i < ENTRY_COUNT; i += 3) {
+        uint64_t key = i * 7;
+        hmapremove(map, &key);
+        hsetremove(set, key);
+    }
+    ASSERT(darrlen(arr) == ENTRY_COUNT && arr[ENTRY_COUNT - 1] == ENTRY_COUNT - 1, "hh_darrput failed on a custom allocator");
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        uint64_t key = i * 7;
+        size_t idx = hmapget(map, &key);
+        ASSERT((idx == SIZE_MAX) == (i % 3 == 0) && (idx == SIZE_MAX || map[idx].val == i),
+            "hh_hmapget failed on a custom allocator for %zu", (size_t) i);
+        ASSERT(hsethas(set, i * 7) == (i % 3 != 0), "hh_hsethas failed on a custom allocator for %zu", (size_t) i);
+    }
+    darrshrink(arr);
+    darrfree(arr);
+    hsetfree(set);
+    hmapfree(map);
+}
+
+// every block goes through the global allocator and comes back with the size it was allocated with
+static void
+test_global(void) {
+    tracker_t tracker = {0};
+    allocator_t alloc = { tracker_alloc, tracker_resize, tracker_release, &tracker };
+    ASSERT(allocator_set(&alloc) == &allocator_checked, "hh_allocator_set returned the wrong previous allocator");
+    ASSERT(allocator_get() == &alloc, "hh_allocator_get returned the wrong allocator");
+    fill(HMAP_CHAINED, NULL);
+    fill(HMAP_FLAT, NULL);
+    DBG("%zu allocator calls", tracker.calls);
+    ASSERT(tracker.calls > 0 && tracker.blocks == 0 && tracker.bytes == 0,
+        "hh_allocator_t leaked %zu blocks [%zu bytes]", tracker.blocks, tracker.bytes);
+    // arenas draw their segments from it
+    hh_arena scratch = {0};
+    for(size_t i = 0; i < 4; ++i) arena_alloc(&scratch, HH_ARENA_DEFAULT_SIZE / 2 + 1);
+    ASSERT(tracker.blocks > 4, "hh_arena_alloc bypassed the global allocator");
+    arena_free(&scratch);
+    ASSERT(tracker.blocks == 0, "hh_arena_free leaked %zu blocks", tracker.blocks);
+    // containers keep the allocator they were created with
+    char* str = NULL;
+    darrputstr(str, "created on the tracker");
+    ASSERT(allocator_set(NULL) == &alloc && allocator_get() == &allocator_checked, "hh_allocator_set failed to restore the default");
+    for(size_t i = 0; i < 100; ++i) darrputstr(str, "!");
+    darrfree(str);
+    ASSERT(tracker.blocks == 0 && tracker.bytes == 0, "hh_darrfree released through the wrong allocator");
+    // an explicit allocator overrides the global one
+    int* arr = NULL;
+    darrinit(arr, &alloc);
+    for(int i = 0; i < 100; ++i) darrput(arr, i);
+    ASSERT(tracker.blocks == 1, "hh_darrinit ignored its allocator");
+    darrfree(arr);
+}
+
+// containers on an arena are freed all at once
+static void
+test_arena(void) {
+    hh_arena scratch = {0};
+    allocator_t alloc = arena_allocator(&scratch);
+    for(int round = 0; round < 3; ++round) {
+        fill(HMAP_CHAINED, &alloc);
+        uint64_t* arr = NULL;
+        darrinit(arr, &alloc);
+        struct { uint64_t key; uint64_t val; }* map = NULL;
+        hmapconfig(map, .layout = HMAP_FLAT, .alloc = &alloc);
+        for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+            ASSERT(darradd(arr, 1) == i && arr[i] == 0, "hh_darradd returned non-zero memory from an arena");
+            arr[i] = i;
+            hmapinsert(map, &i, i);
+        }
+        ASSERT(((uintptr_t) arr & 15) == 0, "hh_arena_allocator failed to align a block");
+        for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+            size_t idx = hmapget(map, &i);
+            ASSERT(arr[i] == i && idx != SIZE_MAX && map[idx].val == i, "hh_arena_allocator corrupted a container");
+        }
+        // nothing is freed individually
+        arena_reset(&scratch);
+        ASSERT(scratch.cur == scratch.ptr, "hh_arena_reset failed to rewind the arena");
+    }
+    // allocations continue in the last segment, a reset starts over at the first one
+    hh_arena chain = {0};
+    for(size_t i = 0; i < 64; ++i) arena_alloc(&chain, HH_ARENA_DEFAULT_SIZE / 2 + 1);
+    hh_arena* tail = chain.tail;
+    ASSERT(tail != NULL && tail->next == NULL && tail->cur != tail->ptr, "hh_arena_alloc lost track of the last segment");
+    arena_reset(&chain);
+    ASSERT(chain.tail == NULL, "hh_arena_reset failed to rewind to the first segment");
+    for(size_t i = 0; i < 64; ++i) arena_alloc(&chain, HH_ARENA_DEFAULT_SIZE / 2 + 1);
+    ASSERT(chain.tail == tail && tail->next == NULL, "hh_arena_reset failed to reuse the segments");
+    arena_free(&chain);
+    // the most recent block grows in place
+    char* a = alloc.alloc(alloc.ctx, 24);
+    char* b = alloc.resize(alloc.ctx, a, 24, 4096);
+    ASSERT(a == b && scratch.cur == a + 4096, "hh_arena_allocator failed to grow the last block in place");
+    alloc.release(alloc.ctx, b, 4096);
+    ASSERT(scratch.cur == b, "hh_arena_allocator failed to give back the last block");
+    arena_free(&scratch);
+}
+
+int
+main(void) {
+    test_global();
+    test_arena();
+    return 0;
+}
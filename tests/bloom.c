@@ -0,0 +1,34 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 100000
+
+static void
+test_rate(double fpr) {
+    bloom_t bloom = {0};
+    bloom_reserve(&bloom, ENTRY_COUNT, fpr);
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) bloom_add(&bloom, hash_int(i, 1));
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        ASSERT(bloom_has(&bloom, hash_int(i, 1)), "hh_bloom_has rejected an added hash: %zu", (size_t) i);
+    }
+    size_t passed = 0;
+    for(uint64_t i = ENTRY_COUNT; i < 2 * ENTRY_COUNT; ++i) passed += bloom_has(&bloom, hash_int(i, 1));
+    double rate = (double) passed / ENTRY_COUNT;
+    DBG("fpr = %.4lf: measured %.4lf with %zu blocks and k = %u", fpr, rate, bloom.block_count, bloom.k);
+    ASSERT(rate < 2.0 * fpr, "hh_bloom_t exceeded its false-positive rate: %.4lf > %.4lf", rate, fpr);
+    // reserving again empties the filter
+    bloom_reserve(&bloom, 10, fpr);
+    ASSERT(bloom.count == 0 && !bloom_has(&bloom, hash_int(0, 1)), "hh_bloom_reserve failed to empty the filter");
+    ASSERT(((uintptr_t) bloom.blocks & 63) == 0, "hh_bloom_reserve failed to align the blocks");
+    bloom_free(&bloom);
+    ASSERT(bloom.blocks == NULL && bloom.block_count == 0, "hh_bloom_free failed to reset the filter");
+}
+
+int
+main(void) {
+    test_rate(0.1);
+    test_rate(0.01);
+    test_rate(0.001);
+    test_rate(0.0001);
+    return 0;
+}
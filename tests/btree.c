@@ -0,0 +1,231 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define KEY_RANGE 20000
+#define OP_COUNT 100000
+
+// random inserts and removals, checked against a presence array
+static void
+test_int(void) {
+    btree_t tree = {0};
+    btree_config(&tree, .kind = BTREE_INT, .val_size = sizeof(int64_t));
+    static int64_t model[KEY_RANGE];
+    static _Bool present[KEY_RANGE];
+    size_t len = 0;
+    uint32_t state = 11;
+    for(size_t op = 0; op < OP_COUNT; ++op) {
+        state = state * 1664525u + 1013904223u;
+        int64_t k = (int64_t) ((state >> 8) % KEY_RANGE);
+        int64_t key = k * 3 - KEY_RANGE; // negative keys and gaps
+        if((state >> 28) < 11) {
+            int64_t val = (int64_t) op;
+            _Bool added = btree_put_int(&tree, key, &val);
+            ASSERT(added == !present[k], "hh_btree_put_int disagrees with the model on %lld", (long long) key);
+            len += added;
+            present[k] = 1;
+            model[k] = val;
+        } else {
+            _Bool removed = btree_remove_int(&tree, key);
+            ASSERT(removed == present[k], "hh_btree_remove_int disagrees with the model on %lld", (long long) key);
+            len -= removed;
+            present[k] = 0;
+        }
+    }
+    ASSERT(btree_len(&tree) == len, "hh_btree_len returned %zu, expected %zu", btree_len(&tree), len);
+    // in-order iteration visits exactly the present keys
+    btree_cursor_t c = btree_first(&tree);
+    for(int64_t k = 0; k < KEY_RANGE; ++k) {
+        int64_t* val = btree_get_int(&tree, k * 3 - KEY_RANGE);
+        ASSERT((val != NULL) == present[k] && (val == NULL || *val == model[k]),
+            "hh_btree_get_int returned an incorrect value for %lld", (long long) (k * 3 - KEY_RANGE));
+        if(!present[k]) continue;
+        ASSERT(btree_valid(c) && btree_key_int(c) == k * 3 - KEY_RANGE && btree_val(c) == (void*) val,
+            "hh_btree_next skipped %lld", (long long) (k * 3 - KEY_RANGE));
+        btree_next(&c);
+    }
+    ASSERT(!btree_valid(c), "hh_btree_next visited removed keys");
+    // bounds between and on keys
+    for(int64_t k = 0; k < KEY_RANGE; k += 7) {
+        int64_t key = k * 3 - KEY_RANGE;
+        int64_t next = k + !present[k];
+        while(next < KEY_RANGE && !present[next]) ++next;
+        btree_cursor_t lower = btree_lower_int(&tree, key);
+        ASSERT(btree_valid(lower) == (next < KEY_RANGE) && (!btree_valid(lower) || btree_key_int(lower) == next * 3 - KEY_RANGE),
+            "hh_btree_lower_int failed on %lld", (long long) key);
+        btree_cursor_t upper = btree_upper_int(&tree, key - 1);
+        ASSERT(btree_valid(upper) == btree_valid(lower) && (!btree_valid(upper) || btree_key_int(upper) == btree_key_int(lower)),
+            "hh_btree_upper_int failed on %lld", (long long) (key - 1));
+        upper = btree_upper_int(&tree, key);
+        next = k + 1;
+        while(next < KEY_RANGE && !present[next]) ++next;
+        ASSERT(btree_valid(upper) == (next < KEY_RANGE) && (!btree_valid(upper) || btree_key_int(upper) == next * 3 - KEY_RANGE),
+            "hh_btree_upper_int failed on %lld", (long long) key);
+    }
+    ASSERT(!btree_valid(btree_lower_int(&tree, INT64_MAX)), "hh_btree_lower_int found a key past the end");
+    btree_free(&tree);
+    ASSERT(btree_len(&tree) == 0 && !btree_valid(btree_first(&tree)), "hh_btree_free failed to reset the tree");
+    // the options survive hh_btree_free
+    int64_t val = 5;
+    btree_put_int(&tree, 1, &val);
+    ASSERT(*((int64_t*) btree_get_int(&tree, 1)) == 5, "hh_btree_put_int failed after hh_btree_free");
+    btree_free(&tree);
+}
+
+// string keys, range scans by prefix
+static void
+test_str(void) {
+    btree_t tree = {0};
+    btree_config(&tree, .kind = BTREE_STR, .val_size = sizeof(uint32_t));
+    char key[32];
+    for(uint32_t i = 0; i < KEY_RANGE; ++i) {
+        uint32_t k = (i * 7919u) % KEY_RANGE;
+        snprintf(key, sizeof(key), "key%u", k);
+        ASSERT(btree_put_str(&tree, key, strlen(key), &k), "hh_btree_put_str failed to insert %s", key);
+    }
+    ASSERT(!btree_put_str(&tree, "key42", 5, NULL) && *((uint32_t*) btree_get_str(&tree, "key42", 5)) == 0,
+        "hh_btree_put_str failed to replace a value");
+    ASSERT(btree_get_str(&tree, "key", 3) == NULL && btree_get_str(&tree, "key420000", 9) == NULL,
+        "hh_btree_get_str found an absent key");
+    // keys are ordered like memcmp, shorter keys first
+    size_t count = 0, prev_len = 0;
+    const char* prev = NULL;
+    for(btree_cursor_t c = btree_first(&tree); btree_valid(c); btree_next(&c), ++count) {
+        size_t len;
+        const char* str = btree_key_str(c, &len);
+        ASSERT(str[len] == '\0', "hh_btree_key_str returned an unterminated key");
+        if(prev != NULL) {
+            int comp = memcmp(prev, str, HH_MIN(prev_len, len));
+            ASSERT(comp < 0 || (comp == 0 && prev_len < len), "hh_btree_next visited %s before %s", prev, str);
+        }
+        prev = str;
+        prev_len = len;
+    }
+    ASSERT(count == KEY_RANGE, "hh_btree_next visited %zu keys", count);
+    // all keys starting with key12: key12, key120..key129, key1200..key1299, key12000..key12999
+    char src[] = "key12 key2";
+    span_t tokens = span(src);
+    span_t prefix = span_next(&tokens, .delim = " ");
+    count = 0;
+    for(btree_cursor_t c = btree_lower_span(&tree, prefix); btree_valid(c); btree_next(&c), ++count) {
+        size_t len;
+        const char* str = btree_key_str(c, &len);
+        if(len < span_len(prefix) || memcmp(str, prefix.ptr, span_len(prefix)) != 0) break;
+    }
+    ASSERT(count == 1 + 10 + 100 + 1000, "hh_btree_lower_span scanned %zu keys with prefix key12", count);
+    span_t second = span_next(&tokens, .delim = " ");
+    btree_cursor_t c = btree_upper_span(&tree, second);
+    ASSERT(btree_valid(c) && strcmp(btree_key_str(c, NULL), "key20") == 0, "hh_btree_upper_span failed");
+    ASSERT(btree_remove_str(&tree, "key20", 5) && !btree_remove_str(&tree, "key20", 5), "hh_btree_remove_str failed");
+    c = btree_upper_str(&tree, "key2", 4);
+    ASSERT(btree_valid(c) && strcmp(btree_key_str(c, NULL), "key200") == 0, "hh_btree_upper_str failed after removal");
+    ASSERT(btree_put_str(&tree, NULL, 0, NULL) && strcmp(btree_key_str(btree_first(&tree), NULL), "") == 0,
+        "hh_btree_put_str mishandled the empty key");
+    btree_free(&tree);
+}
+
+// bulk loading matches insertion
+static void
+test_load(void) {
+    btree_t tree = {0};
+    int64_t* keys = NULL;
+    int64_t* vals = NULL;
+    for(int64_t i = 0; i < KEY_RANGE; ++i) {
+        darrput(keys, i * 2);
+        darrput(vals, -i);
+    }
+    btree_config(&tree, .kind = BTREE_INT, .val_size = sizeof(int64_t));
+    btree_put_int(&tree, 1, NULL);
+    btree_load(&tree, keys, vals);
+    ASSERT(btree_len(&tree) == KEY_RANGE && btree_get_int(&tree, 1) == NULL, "hh_btree_load kept the old contents");
+    for(int64_t i = 0; i < KEY_RANGE; ++i) {
+        int64_t* val = btree_get_int(&tree, i * 2);
+        ASSERT(val != NULL && *val == -i, "hh_btree_load lost key %lld", (long long) (i * 2));
+        btree_cursor_t c = btree_upper_int(&tree, i * 2 - 1);
+        ASSERT(btree_valid(c) && btree_key_int(c) == i * 2, "hh_btree_upper_int failed after hh_btree_load");
+    }
+    // the loaded tree accepts further inserts
+    for(int64_t i = 0; i < KEY_RANGE; ++i) btree_put_int(&tree, i * 2 + 1, &i);
+    int64_t expected = 0;
+    for(btree_cursor_t c = btree_first(&tree); btree_valid(c); btree_next(&c), ++expected) {
+        ASSERT(btree_key_int(c) == expected, "hh_btree_put_int broke the order of a loaded tree at %lld", (long long) expected);
+    }
+    ASSERT(expected == 2 * KEY_RANGE, "hh_btree_load tree holds %lld keys", (long long) expected);
+    btree_free(&tree);
+    darrfree(keys);
+    darrfree(vals);
+    // string keys, as a set
+    const char** words = NULL;
+    const char* sorted[] = { "apple", "banana", "cherry", "date", "elderberry", "fig", "grape" };
+    for(size_t i = 0; i < ARR_LEN(sorted); ++i) darrput(words, sorted[i]);
+    btree_config(&tree, .kind = BTREE_STR);
+    btree_load(&tree, words, NULL);
+    btree_cursor_t c = btree_lower_str(&tree, "c", 1);
+    ASSERT(btree_valid(c) && strcmp(btree_key_str(c, NULL), "cherry") == 0, "hh_btree_lower_str failed after hh_btree_load");
+    btree_free(&tree);
+    darrfree(words);
+}
+
+// the prefixed hh_arena alias would rename the tree's arena member
+#undef arena
+
+// bytes reserved by the segments of an arena
+static size_t
+arena_bytes(const hh_arena* arena) {
+    size_t total = 0;
+    for(; arena != NULL && arena->ptr != NULL; arena = arena->next) total += (size_t) (arena->end - arena->ptr);
+    return total;
+}
+
+// a sliding window of keys, memory follows the live keys and scans skip no empty leaves
+static void
+test_churn(void) {
+    btree_t ints = {0}, strs = {0};
+    btree_config(&ints, .kind = BTREE_INT, .val_size = sizeof(int64_t));
+    btree_config(&strs, .kind = BTREE_STR);
+    char key[32];
+    size_t warm_ints = 0, warm_strs = 0;
+    for(int64_t i = 0; i < 50 * KEY_RANGE; ++i) {
+        btree_put_int(&ints, i, &i);
+        int len = snprintf(key, sizeof(key), "key%lld", (long long) (i * 7919));
+        btree_put_str(&strs, key, (size_t) len, NULL);
+        if(i < 1000) continue;
+        ASSERT(btree_remove_int(&ints, i - 1000), "hh_btree_remove_int lost %lld", (long long) (i - 1000));
+        len = snprintf(key, sizeof(key), "key%lld", (long long) ((i - 1000) * 7919));
+        ASSERT(btree_remove_str(&strs, key, (size_t) len), "hh_btree_remove_str lost %s", key);
+        if(i == KEY_RANGE) {
+            warm_ints = arena_bytes(&ints.arena);
+            warm_strs = arena_bytes(&strs.arena);
+        }
+    }
+    ASSERT(btree_len(&ints) == 1000 && btree_len(&strs) == 1000, "hh_btree_remove produced the wrong len");
+    ASSERT(arena_bytes(&ints.arena) == warm_ints && arena_bytes(&strs.arena) == warm_strs,
+        "hh_btree grew from %zu to %zu bytes with a constant number of keys", warm_ints + warm_strs,
+        arena_bytes(&ints.arena) + arena_bytes(&strs.arena));
+    // every leaf holds keys, at least a quarter of what fits in it on average
+    size_t leaves = 0;
+    for(HH__btree_node_t* leaf = btree_first(&ints).leaf; leaf != NULL; leaf = leaf->next, ++leaves) {
+        ASSERT(leaf->len > 0, "hh_btree_remove left an empty leaf");
+    }
+    ASSERT(leaves * ints.leaf_cap / 4 <= 1000, "hh_btree keeps %zu leaves for 1000 keys", leaves);
+    int64_t expected = 50 * KEY_RANGE - 1000;
+    for(btree_cursor_t c = btree_first(&ints); btree_valid(c); btree_next(&c), ++expected) {
+        ASSERT(btree_key_int(c) == expected && *(int64_t*) btree_val(c) == expected, "hh_btree_next returned %lld", (long long) btree_key_int(c));
+    }
+    ASSERT(expected == 50 * KEY_RANGE, "hh_btree_next stopped at %lld", (long long) expected);
+    // removing everything leaves an empty root
+    for(int64_t i = 50 * KEY_RANGE - 1000; i < 50 * KEY_RANGE; ++i) btree_remove_int(&ints, i);
+    ASSERT(btree_len(&ints) == 0 && !btree_valid(btree_first(&ints)) && ints.root->leaf, "hh_btree_remove failed to empty the tree");
+    btree_put_int(&ints, 3, NULL);
+    ASSERT(btree_valid(btree_first(&ints)) && btree_key_int(btree_first(&ints)) == 3, "hh_btree_put_int failed on an emptied tree");
+    btree_free(&ints);
+    btree_free(&strs);
+}
+
+int
+main(void) {
+    test_int();
+    test_str();
+    test_load();
+    test_churn();
+    return 0;
+}
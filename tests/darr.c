@@ -1,10 +1,148 @@
 #define HH_IMPLEMENTATION
+// small enough that test_capacity maps an array
+#define HH_DARR_MMAP_THRESHOLD (1 << 20)
 #include "h.h"
 
 #include <stdint.h>
 
+#define ELEM_COUNT (1 << 20)
+
+// hh_darrreserve, hh_darrshrink and growth past HH_DARR_MMAP_THRESHOLD
+static void
+test_capacity(void) {
+    uint32_t* arr = NULL;
+    darrreserve(arr, 1000);
+    size_t cap = darrcap(arr);
+    ASSERT(darrlen(arr) == 0 && cap > 1000, "hh_darrreserve failed to make room: cap = %zu", cap);
+    for(uint32_t i = 0; i < 1000; ++i) darrput(arr, i);
+    ASSERT(darrcap(arr) == cap, "hh_darrput reallocated a reserved array");
+    darrreserve(arr, 10);
+    ASSERT(darrcap(arr) == cap, "hh_darrreserve shrank the array");
+    darrshrink(arr);
+    ASSERT(darrcap(arr) == 1000 && arr[999] == 999, "hh_darrshrink failed: cap = %zu", darrcap(arr));
+    // keep growing past the threshold, the contents survive the move into a mapping and every mremap after it
+    for(uint32_t i = 1000; i < ELEM_COUNT; ++i) darrput(arr, i);
+    for(uint32_t i = 0; i < ELEM_COUNT; ++i) ASSERT(arr[i] == i, "hh_darrput lost element %u", i);
+#if defined(__linux__)
+    ASSERT(hh_darrheader(arr)->flags & HH__DARR_MAPPED, "hh_darr failed to map a large array");
+#endif // __linux__
+    darrclear(arr);
+    darrput(arr, 7);
+    darrshrink(arr);
+    ASSERT(darrlen(arr) == 1 && arr[0] == 7 && darrcap(arr) == 1, "hh_darrshrink failed on a large array");
+    darrfree(arr);
+    ASSERT(arr == NULL, "hh_darrfree failed to reset the array");
+    // a large reservation maps the array right away
+    darrreserve(arr, ELEM_COUNT);
+    ASSERT(darrcap(arr) > ELEM_COUNT, "hh_darrreserve failed on an empty array");
+    darrfree(arr);
+}
+
+// inline arrays stay in their buffer until they outgrow it
+static void
+test_inline(void) {
+    DARR_INLINE(uint32_t, arr, 16);
+    uint32_t* buf = arr;
+    ASSERT(darrlen(arr) == 0 && darrcap(arr) > 16, "HH_DARR_INLINE declared an array without room");
+    for(uint32_t i = 0; i < 16; ++i) darrput(arr, i);
+    darrswapdel(arr, 0);
+    darrreserve(arr, 16);
+    darrshrink(arr);
+    ASSERT(arr == buf && darrlen(arr) == 15 && arr[0] == 15, "HH_DARR_INLINE left its buffer early");
+    for(uint32_t i = 16; i < 1000; ++i) darrput(arr, i);
+    ASSERT(arr != buf && darrlen(arr) == 999 && !(hh_darrheader(arr)->flags & HH__DARR_UNOWNED),
+        "HH_DARR_INLINE failed to move to the heap");
+    for(uint32_t i = 1; i < 999; ++i) ASSERT(arr[i] == i + (i >= 15), "HH_DARR_INLINE lost element %u", i);
+    darrfree(arr);
+    // clearing an array that never left its buffer, freeing it releases nothing
+    DARR_INLINE(char, str, 8);
+    darrputstr(str, "1234567");
+    ASSERT(str == str_inline.buf && strcmp(str, "1234567") == 0, "hh_darrputstr left an inline buffer early");
+    darrclear(str);
+    darrputstr(str, "12345678");
+    ASSERT(str != str_inline.buf && strcmp(str, "12345678") == 0, "hh_darrputstr failed to move to the heap");
+    darrfree(str);
+    DARR_INLINE(double, unused, 4);
+    darrput(unused, 1.0);
+    darrfree(unused);
+    ASSERT(unused == NULL, "hh_darrfree failed to reset an inline array");
+}
+
+// bulk operations against an element-by-element model
+static void
+test_bulk(void) {
+    uint32_t src[100];
+    for(uint32_t i = 0; i < 100; ++i) src[i] = i;
+    uint32_t* arr = NULL;
+    ASSERT(darrputn(arr, src, 100) == 0 && darrputn(arr, src, 0) == 100 && darrlen(arr) == 100,
+        "hh_darrputn failed to append");
+    // [0, 100) -> [0, 10) 50 51 [10, 100)
+    ASSERT(darrinsertn(arr, 10, src + 50, 2) == 10 && darrlen(arr) == 102 && arr[10] == 50 && arr[11] == 51 && arr[12] == 10,
+        "hh_darrinsertn failed to insert in the middle");
+    darrerasen(arr, 10, 2);
+    darrerasen(arr, 100, 0);
+    for(uint32_t i = 0; i < 100; ++i) ASSERT(arr[i] == i, "hh_darrerasen failed to restore element %u", i);
+    // sources inside the array survive it moving, and ranges across the gap are split correctly
+    darrshrink(arr);
+    darrputn(arr, arr + 90, 10);
+    ASSERT(darrlen(arr) == 110 && arr[100] == 90 && arr[109] == 99, "hh_darrputn mishandled a source inside the array");
+    darrerasen(arr, 100, 10);
+    darrshrink(arr);
+    darrinsertn(arr, 5, arr + 3, 4);
+    uint32_t expected[] = { 0, 1, 2, 3, 4, 3, 4, 5, 6, 5, 6, 7 };
+    for(size_t i = 0; i < ARR_LEN(expected); ++i) {
+        ASSERT(arr[i] == expected[i], "hh_darrinsertn mishandled a source across the gap at %zu", i);
+    }
+    ASSERT(darrlen(arr) == 104 && arr[103] == 99, "hh_darrinsertn lost the tail");
+    darrinsertn(arr, darrlen(arr), NULL, 3);
+    ASSERT(darrlen(arr) == 107 && arr[104] == 0 && arr[106] == 0, "hh_darrinsertn failed to zero-fill");
+    darrerasen(arr, 0, darrlen(arr));
+    ASSERT(darrlen(arr) == 0, "hh_darrerasen failed to empty the array");
+    size_t idx = darradd_uninit(arr, 50);
+    ASSERT(idx == 0 && darrlen(arr) == 50 && darrcap(arr) > 50, "hh_darradd_uninit failed to grow the array");
+    darrfree(arr);
+}
+
+// aligned arrays keep their alignment through growth, shrinking and mapping
+static void
+test_aligned(void) {
+    size_t aligns[] = { 32, 64, 4096 };
+    for(size_t a = 0; a < ARR_LEN(aligns); ++a) {
+        size_t align = aligns[a];
+        float* arr = NULL;
+        darrinit_aligned(arr, NULL, align);
+        ASSERT(((uintptr_t) arr % align) == 0 && darrlen(arr) == 0, "hh_darrinit_aligned failed to align to %zu", align);
+        for(uint32_t i = 0; i < ELEM_COUNT; ++i) {
+            darrput(arr, (float) i);
+            ASSERT(((uintptr_t) arr % align) == 0, "hh_darrput lost the alignment to %zu at %u", align, i);
+        }
+        for(uint32_t i = 0; i < ELEM_COUNT; ++i) ASSERT(arr[i] == (float) i, "hh_darrput lost element %u of an aligned array", i);
+        darrerasen(arr, 10, ELEM_COUNT - 20);
+        darrshrink(arr);
+        ASSERT(((uintptr_t) arr % align) == 0 && darrlen(arr) == 20 && arr[9] == 9.0f && arr[10] == (float) (ELEM_COUNT - 10),
+            "hh_darrshrink lost the alignment to %zu", align);
+        darrfree(arr);
+    }
+    // on an arena, which hands out 16-byte aligned blocks
+    hh_arena scratch = {0};
+    allocator_t alloc = arena_allocator(&scratch);
+    double* arr = NULL;
+    darrinit_aligned(arr, &alloc, 64);
+    for(uint32_t i = 0; i < 1000; ++i) {
+        arena_alloc(&scratch, 24);
+        darrput(arr, (double) i);
+        ASSERT(((uintptr_t) arr % 64) == 0 && arr[i / 2] == (double) (i / 2), "hh_darrput lost the alignment on an arena");
+    }
+    darrfree(arr);
+    arena_free(&scratch);
+}
+
 int
 main(void) {
+    test_capacity();
+    test_inline();
+    test_bulk();
+    test_aligned();
     char** arr = NULL, fst[6], snd[6];
     darrput(arr, "Hello");
     darrput(arr, "World");
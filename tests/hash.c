@@ -0,0 +1,42 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+int
+main(void) {
+    char buf[128 + 8];
+    for(size_t i = 0; i < sizeof(buf); ++i) buf[i] = (char) ('a' + i % 26);
+    // the cstr hash must agree with the sized hash for every length and alignment
+    for(size_t align = 0; align < 8; ++align) {
+        for(size_t len = 0; len < 128; ++len) {
+            char* str = buf + align;
+            char saved = str[len];
+            str[len] = '\0';
+            size_t fst = hash_wide(str, len, 42);
+            size_t snd = hash_wide_str(str, 42);
+            str[len] = saved;
+            ASSERT(fst == snd, "hh_hash_wide_str disagrees with hh_hash_wide: len = %zu, align = %zu", len, align);
+        }
+    }
+    // strings that end their allocation, a read past the terminator shows up under ASan
+    for(size_t len = 0; len < 64; ++len) {
+        char* str = malloc(len + 1);
+        memcpy(str, buf, len);
+        str[len] = '\0';
+        ASSERT(hash_wide_str(str, 42) == hash_wide(str, len, 42), "hh_hash_wide_str failed on a heap string: len = %zu", len);
+        free(str);
+    }
+    // the seed must perturb the hash, as must the length of zero-padded input
+    const char zeros[16] = {0};
+    ASSERT(hash_wide("hello", 5, 1) != hash_wide("hello", 5, 2), "hh_hash_wide ignored the seed");
+    for(size_t len = 1; len < sizeof(zeros); ++len) {
+        ASSERT(hash_wide(zeros, len, 0) != hash_wide(zeros, len - 1, 0), 
+            "hh_hash_wide collided on zero-padded lengths: len = %zu", len);
+    }
+    // spans and cstr keys with the same contents hash identically
+    char word[] = "identifier";
+    const char* cstr = word;
+    hh_span_t tok = hh_span(word);
+    ASSERT(hash_cstr(&cstr, sizeof(cstr), 7) == hash_span(&tok, sizeof(tok), 7), 
+        "hh_hash_cstr and hh_hash_span disagree");
+    return 0;
+}
@@ -0,0 +1,444 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 20000
+
+static void
+test_layout(int layout) {
+    struct { int key; int val; }* map = NULL;
+    hmapconfig(map, .layout = layout);
+    // inserting drives the table past its load factor many times over
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        ASSERT(hmapinsert(map, &i, i * 2) == NULL, 
+            "hh_hmapinsert reported a replacement for a new key: key = %d", i);
+    }
+    hh_hmapheader_t* map_hdr = hh_hmapheader(map);
+    DBG("Inserted %d entries [layout %d]: buckets = %zu, slots = %zu, rehashing = %s", ENTRY_COUNT, layout,
+        map_hdr->bucket_count, map_hdr->slot_count, STRINGIFY_BOOL(map_hdr->buckets_old != NULL));
+    ASSERT(hmaplen(map) == ENTRY_COUNT, 
+        "hh_hmaplen returned incorrect length: len = %zu", hmaplen(map));
+    ASSERT((double) (map_hdr->bucket_count + map_hdr->slot_count) * map_hdr->opt.max_load >= (double) ENTRY_COUNT, 
+        "hh_hmap did not grow its index: buckets = %zu, slots = %zu", map_hdr->bucket_count, map_hdr->slot_count);
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        size_t idx = hmapget(map, &i);
+        ASSERT(idx != SIZE_MAX && map[idx].key == i && map[idx].val == i * 2, 
+            "hh_hmapget failed to find entry after rehashing: key = %d", i);
+    }
+    // replacing returns the old entry and does not change the length
+    int key = 42;
+    ASSERT(hmapinsert(map, &key, -1) == &map[hmaplen(map)] && map[hmaplen(map)].val == 84, 
+        "hh_hmapinsert did not return the replaced entry");
+    ASSERT(hmaplen(map) == ENTRY_COUNT && map[hmapget(map, &key)].val == -1, 
+        "hh_hmapinsert failed to replace entry");
+    // remove every other key, which also drives any incremental rehash forward
+    // removing from the front moves the last entry into each gap
+    for(int i = 0; i < ENTRY_COUNT; i += 2) {
+        int* removed = hmapremove(map, &i);
+        ASSERT(removed != NULL && removed[0] == i && removed[1] == ((i == 42) ? -1 : i * 2), 
+            "hh_hmapremove failed to remove entry: key = %d", i);
+    }
+    ASSERT(hmaplen(map) == ENTRY_COUNT / 2, 
+        "hh_hmapremove left incorrect length: len = %zu", hmaplen(map));
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        size_t idx = hmapget(map, &i);
+        if(i % 2 == 0) ASSERT(idx == SIZE_MAX, "hh_hmapget found removed key: key = %d", i);
+        else ASSERT(idx != SIZE_MAX && map[idx].key == i, "hh_hmapget lost key after removal: key = %d", i);
+    }
+    // churn through removed keys so deleted slots get reused
+    for(int i = 0; i < ENTRY_COUNT; i += 2) {
+        hmapinsert(map, &i, i);
+        ASSERT(hmapremove(map, &i) != NULL, "hh_hmapremove failed during churn: key = %d", i);
+    }
+    ASSERT(hmaplen(map) == ENTRY_COUNT / 2, 
+        "churn left incorrect length: len = %zu", hmaplen(map));
+    hmapfree(map);
+    // reserve pre-sizes the index so no rehash is needed
+    map = NULL;
+    hmapconfig(map, .reserve = ENTRY_COUNT, .layout = layout);
+    size_t bucket_count = hh_hmapheader(map)->bucket_count;
+    size_t slot_count = hh_hmapheader(map)->slot_count;
+    for(int i = 0; i < ENTRY_COUNT; ++i) hmapinsert(map, &i, i);
+    ASSERT(hh_hmapheader(map)->bucket_count == bucket_count && hh_hmapheader(map)->buckets_old == NULL, 
+        "hh_hmap rehashed despite reserve: buckets = %zu", hh_hmapheader(map)->bucket_count);
+    ASSERT(hh_hmapheader(map)->slot_count == slot_count, 
+        "hh_hmap resized despite reserve: slots = %zu", hh_hmapheader(map)->slot_count);
+    hmapfree(map);
+}
+
+// every key collides, so lookups must fall back to key comparison
+static size_t
+hash_collide(const void* ptr, size_t sz, size_t seed) {
+    (void) ptr;
+    (void) sz;
+    (void) seed;
+    return 7;
+}
+
+static void
+test_collisions(int layout) {
+    struct { int key; int val; }* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_collide, .layout = layout);
+    for(int i = 0; i < 100; ++i) hmapinsert(map, &i, -i);
+    for(int i = 0; i < 100; i += 3) {
+        ASSERT(hmapremove(map, &i) != NULL, "hh_hmapremove failed with colliding hashes: key = %d", i);
+    }
+    for(int i = 0; i < 100; ++i) {
+        size_t idx = hmapget(map, &i);
+        if(i % 3 == 0) ASSERT(idx == SIZE_MAX, "hh_hmapget found removed key: key = %d", i);
+        else ASSERT(idx != SIZE_MAX && map[idx].val == -i, "hh_hmapget failed with colliding hashes: key = %d", i);
+    }
+    hmapfree(map);
+}
+
+static void
+test_upsert(int layout) {
+    // count words, each one hashed once per occurrence
+    const char* words[] = { "the", "quick", "fox", "the", "lazy", "dog", "the", "fox" };
+    struct { const char* key; int val; }* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr, .layout = layout);
+    for(size_t i = 0; i < ARR_LEN(words); ++i) ++*hmapupsert(map, &words[i]);
+    ASSERT(hmaplen(map) == 5, "hh_hmapupsert inserted duplicate keys: len = %zu", hmaplen(map));
+    const char* key = "the";
+    ASSERT(map[hmapget(map, &key)].val == 3, "hh_hmapupsert miscounted: the = %d", map[hmapget(map, &key)].val);
+    key = "fox";
+    ASSERT(map[hmapget(map, &key)].val == 2, "hh_hmapupsert miscounted: fox = %d", map[hmapget(map, &key)].val);
+    // precomputed hashes are interchangeable with the regular calls
+    key = "cat";
+    size_t hash = hmaphash(map, &key);
+    ASSERT(hmapget_hashed(map, &key, hash) == SIZE_MAX, "hh_hmapget_hashed found absent key");
+    ASSERT(hmapinsert_hashed(map, &key, 9, hash) == NULL, "hh_hmapinsert_hashed reported a replacement");
+    ASSERT(map[hmapget(map, &key)].val == 9, "hh_hmapinsert_hashed stored the wrong value");
+    ASSERT(hmapinsert_hashed(map, &key, 10, hash) != NULL && map[hmapget_hashed(map, &key, hash)].val == 10, 
+        "hh_hmapinsert_hashed failed to replace");
+    hmapfree(map);
+}
+
+static void
+test_many(int layout) {
+    uint64_t keys[3000];
+    int vals[3000];
+    for(size_t i = 0; i < ARR_LEN(keys); ++i) {
+        keys[i] = (uint64_t) i * 7919u;
+        vals[i] = (int) i;
+    }
+    struct { uint64_t key; int val; }* map = NULL;
+    hmapconfig(map, .layout = layout);
+    // overlapping batches grow an existing map and replace the shared keys
+    size_t added = hmapinsert_many(map, keys, vals, 2000);
+    ASSERT(added == 2000, "hh_hmapinsert_many failed to insert: added = %zu", added);
+    for(size_t i = 1000; i < ARR_LEN(vals); ++i) vals[i] = -vals[i];
+    added = hmapinsert_many(map, keys + 1000, vals + 1000, 2000);
+    ASSERT(added == 1000, "hh_hmapinsert_many failed to replace: added = %zu", added);
+    ASSERT(hmaplen(map) == ARR_LEN(keys), "hh_hmapinsert_many produced wrong len = %zu", hmaplen(map));
+    // every other key is absent
+    uint64_t probes[2 * ARR_LEN(keys)];
+    for(size_t i = 0; i < ARR_LEN(probes); ++i) probes[i] = (i % 2) ? 1 + (uint64_t) i * 7919u : keys[i / 2];
+    size_t* idx = NULL;
+    darrput(idx, 42);
+    hmapget_many(map, probes, ARR_LEN(probes), idx);
+    ASSERT(darrlen(idx) == ARR_LEN(probes) + 1 && idx[0] == 42, "hh_hmapget_many failed to append to out");
+    for(size_t i = 0; i < ARR_LEN(probes); ++i) {
+        ASSERT(idx[i + 1] == hmapget(map, &probes[i]), "hh_hmapget_many disagrees with hh_hmapget on key %zu", i);
+        if(i % 2) continue;
+        ASSERT(map[idx[i + 1]].val == vals[i / 2], "hh_hmapinsert_many stored the wrong value for key %zu", i / 2);
+    }
+    darrfree(idx);
+    hmapfree(map);
+    // an unconfigured map is created on first use
+    map = NULL;
+    ASSERT(hmapinsert_many(map, keys, vals, 5) == 5 && hmaplen(map) == 5, "hh_hmapinsert_many failed on an empty map");
+    hmapfree(map);
+}
+
+static inline _Bool
+u64_eq(uint64_t fst, uint64_t snd) {
+    return fst == snd;
+}
+
+HMAP_DEFINE(u64map, uint64_t, int, hash_int, u64_eq)
+
+// keys copied into a map are tagged with the top bit, which hashing and comparison ignore
+#define U64_TAG ((uint64_t) 1 << 63)
+
+static size_t tagged_copies;
+
+static inline size_t
+tagged_hash(uint64_t key, size_t seed) {
+    return hash_int(key & ~U64_TAG, seed);
+}
+
+static inline _Bool
+tagged_eq(uint64_t fst, uint64_t snd) {
+    return ((fst ^ snd) & ~U64_TAG) == 0;
+}
+
+static void
+tagged_copy(void* dst, const void* ptr, size_t sz) {
+    ASSERT(sz == sizeof(uint64_t), "hh_copy_f received size %zu", sz);
+    *(uint64_t*) dst = *(const uint64_t*) ptr | U64_TAG;
+    ++tagged_copies;
+}
+
+HMAP_DEFINE(taggedmap, uint64_t, int, tagged_hash, tagged_eq)
+
+static void
+test_define(int layout) {
+    u64map_t* map = NULL;
+    u64map_config(&map, (hh_hmap_opt) { .layout = layout });
+    for(uint64_t i = 0; i < 1000; ++i) 
+        ASSERT(u64map_insert(&map, i * i, (int) i) == NULL, "HH_HMAP_DEFINE insert reported a replacement");
+    u64map_t* old = u64map_insert(&map, 49, -1);
+    ASSERT(old != NULL && old->key == 49 && old->val == 7, "HH_HMAP_DEFINE insert failed to return the replaced entry");
+    ASSERT(hmaplen(map) == 1000, "HH_HMAP_DEFINE insert produced wrong len = %zu", hmaplen(map));
+    // the generic functions see the same map
+    uint64_t key = 49;
+    ASSERT(hmapget(map, &key) == u64map_find(map, 49) && map[hmapget(map, &key)].val == -1, 
+        "HH_HMAP_DEFINE map disagrees with hh_hmapget");
+    ASSERT(u64map_find(map, 50) == SIZE_MAX, "HH_HMAP_DEFINE find found absent key");
+    for(uint64_t i = 0; i < 1000; i += 2) {
+        u64map_t* removed = u64map_remove(map, i * i);
+        ASSERT(removed != NULL && removed->key == i * i, "HH_HMAP_DEFINE remove failed on key %zu", (size_t) (i * i));
+    }
+    ASSERT(u64map_remove(map, 0) == NULL, "HH_HMAP_DEFINE removed absent key");
+    for(uint64_t i = 1; i < 1000; i += 2) {
+        size_t idx = u64map_find(map, i * i);
+        ASSERT(idx != SIZE_MAX && map[idx].val == ((i == 7) ? -1 : (int) i), "HH_HMAP_DEFINE lost key %zu", (size_t) (i * i));
+    }
+    hmapfree(map);
+    // an unconfigured map is created on first insert
+    map = NULL;
+    u64map_insert(&map, 1, 1);
+    ASSERT(u64map_find(map, 1) == 0, "HH_HMAP_DEFINE insert failed on an empty map");
+    hmapfree(map);
+    // keys go through .key_f.copy on both append and replace
+    taggedmap_t* tagged = NULL;
+    tagged_copies = 0;
+    taggedmap_config(&tagged, (hh_hmap_opt) { .layout = layout, .key_f.copy = tagged_copy });
+    ASSERT(taggedmap_insert(&tagged, 5, 1) == NULL && tagged[0].key == (5 | U64_TAG), 
+        "HH_HMAP_DEFINE insert bypassed .key_f.copy on append");
+    taggedmap_t* replaced = taggedmap_insert(&tagged, 5, 2);
+    ASSERT(replaced != NULL && replaced->val == 1 && hmaplen(tagged) == 1, "HH_HMAP_DEFINE insert failed to replace a copied key");
+    ASSERT(tagged[0].key == (5 | U64_TAG) && tagged[0].val == 2 && tagged_copies == 2, 
+        "HH_HMAP_DEFINE insert bypassed .key_f.copy on replace");
+    hmapfree(tagged);
+}
+
+#define SAVE_PATH PROJECT_ROOT "tests/hmap.tmp"
+
+static void
+test_save(int layout) {
+    char names[1000][16];
+    struct { char* key; int val; }* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr, .layout = layout);
+    for(int i = 0; i < 1000; ++i) {
+        snprintf(names[i], sizeof(names[i]), "name%d", i);
+        char* key = names[i];
+        hmapinsert(map, &key, i);
+    }
+    ASSERT(hmapsave(map, SAVE_PATH), "hh_hmapsave failed to write " SAVE_PATH);
+    // the second load can't use the preferred address, so its keys are relocated
+    struct { char* key; int val; }* loaded[2] = { NULL, NULL };
+    for(size_t k = 0; k < ARR_LEN(loaded); ++k) {
+        hmapconfig(loaded[k], .key_f.hash = hash_cstr, .key_f.comp = comp_cstr, 
+            .probe_f.hash = hash_span, .probe_f.comp = comp_span_cstr);
+        ASSERT(hmapload_mapped(loaded[k], SAVE_PATH), "hh_hmapload_mapped failed to load " SAVE_PATH);
+        ASSERT(hmaplen(loaded[k]) == 1000, "hh_hmapload_mapped produced wrong len = %zu", hmaplen(loaded[k]));
+    }
+    // keys are served from the mapping, not from `names`
+    memset(names, 0, sizeof(names));
+    for(int i = 0; i < 1000; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "name%d", i);
+        char* key = name;
+        for(size_t k = 0; k < ARR_LEN(loaded); ++k) {
+            size_t idx = hmapget(loaded[k], &key);
+            ASSERT(idx != SIZE_MAX && loaded[k][idx].val == i && strcmp(loaded[k][idx].key, name) == 0, 
+                "hh_hmapload_mapped lost key %s", name);
+            hh_span_t tok = hh_span(name);
+            ASSERT(hmapget_probe(loaded[k], &tok) == idx, "hh_hmapget_probe failed on a loaded map");
+        }
+    }
+    char* absent = "name1000";
+    ASSERT(hmapget(loaded[0], &absent) == SIZE_MAX, "hh_hmapload_mapped map found absent key");
+    hmapfree(loaded[0]);
+    hmapfree(loaded[1]);
+    hmapfree(map);
+    // a corrupted file is rejected and the map is left alone
+    FILE* f = fopen(SAVE_PATH, "r+b");
+    ASSERT(f != NULL && fseek(f, -1, SEEK_END) == 0 && fputc('!', f) != EOF && fclose(f) == 0, 
+        "failed to corrupt " SAVE_PATH);
+    loaded[0] = NULL;
+    ASSERT(!hmapload_mapped(loaded[0], SAVE_PATH) && loaded[0] == NULL, "hh_hmapload_mapped accepted a corrupted file");
+    remove(SAVE_PATH);
+}
+
+// files that pass the checksum but point outside of themselves are rejected
+// 0: a slot refers to an entry past the end, 1: an entry's position is past the index, 2: a key points into the header
+static void
+test_tampered(void) {
+    struct { const char* key; int val; }* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr);
+    const char* names[] = { "one", "two", "three" };
+    for(int i = 0; i < 3; ++i) hmapinsert(map, &names[i], i);
+    for(int which = 0; which < 3; ++which) {
+        ASSERT(hmapsave(map, SAVE_PATH), "hh_hmapsave failed to write " SAVE_PATH);
+        char* image = read_entire_file(SAVE_PATH);
+        hh_hmapfile_t file;
+        memcpy(&file, image, sizeof(file));
+        size_t slot = 0, bad;
+        while(image[file.off_ctrl + slot] & 0x80) ++slot;
+        switch(which) {
+            case 0: memcpy(image + file.off_slots + slot * sizeof(hh_hmapslot_t) + offsetof(hh_hmapslot_t, idx), &file.len, sizeof(size_t)); break;
+            case 1: memcpy(image + file.off_pos, &file.slot_count, sizeof(size_t)); break;
+            default: bad = (size_t) file.base + 1; memcpy(image + file.off_entries + file.off_key, &bad, sizeof(size_t)); break;
+        }
+        file.checksum = hash_wide(image + sizeof(file), darrlen(image) - sizeof(file), 0);
+        memcpy(image, &file, sizeof(file));
+        FILE* f = fopen(SAVE_PATH, "wb");
+        ASSERT(f != NULL && fwrite(image, 1, darrlen(image), f) == darrlen(image) && fclose(f) == 0, "failed to tamper with " SAVE_PATH);
+        darrfree(image);
+        struct { const char* key; int val; }* loaded = NULL;
+        hmapconfig(loaded, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr);
+        ASSERT(!hmapload_mapped(loaded, SAVE_PATH), "hh_hmapload_mapped accepted a tampered file (%d)", which);
+        hmapfree(loaded);
+    }
+    hmapfree(map);
+    remove(SAVE_PATH);
+}
+
+static void
+test_probe(int layout) {
+    char text[] = "let x = let_y + x";
+    // non-owning cstr keys and owned char array keys, both probed with spans
+    struct { const char* key; int val; }* map = NULL;
+    struct { char key[8]; int val; }* owned = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr, .layout = layout, 
+        .probe_f.hash = hash_span, .probe_f.comp = comp_span_cstr);
+    hmapconfig(owned, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr_owned, .key_f.copy = copy_cstr, 
+        .layout = layout, .probe_f.hash = hash_span, .probe_f.comp = comp_span_cstr_owned);
+    const char* keywords[] = { "let", "if", "else" };
+    for(size_t i = 0; i < ARR_LEN(keywords); ++i) {
+        hmapinsert(map, &keywords[i], (int) i);
+        hmapinsert(owned, &keywords[i], (int) i);
+    }
+    hh_span_t src = hh_span(text), tok;
+    size_t found = 0;
+    while((tok = hh_span_next(&src, .delim = " ")).ptr != NULL) {
+        size_t idx = hmapget_probe(map, &tok);
+        size_t idx_owned = hmapget_probe(owned, &tok);
+        ASSERT((idx == SIZE_MAX) == (idx_owned == SIZE_MAX), "hh_hmapget_probe disagrees between key types");
+        if(idx == SIZE_MAX) continue;
+        ASSERT(strncmp(map[idx].key, tok.ptr, span_len(tok)) == 0 && strcmp(owned[idx_owned].key, "let") == 0, 
+            "hh_hmapget_probe matched the wrong key: " span_fmt, span_fmt_args(tok));
+        ++found;
+    }
+    // "let_y" shares a prefix with "let" but must not match
+    ASSERT(found == 1, "hh_hmapget_probe found %zu keywords, expected 1", found);
+    hmapfree(map);
+    hmapfree(owned);
+    // a span with an embedded NUL must not match the key ending at it
+    char bytes[] = { 'a', '\0', 'b' };
+    hh_span_t nul = { .ptr = bytes, .end = bytes + sizeof(bytes) };
+    char* key = malloc(2);
+    memcpy(key, "a", 2);
+    ASSERT(comp_span_cstr(&nul, &key, 0) > 0 && comp_span_cstr_owned(&nul, key, 0) > 0, 
+        "hh_comp_span_cstr matched a span with an embedded NUL");
+    nul.end = bytes + 1;
+    ASSERT(comp_span_cstr(&nul, &key, 0) == 0, "hh_comp_span_cstr failed to match a prefix span");
+    free(key);
+}
+
+static void
+test_filter(int layout) {
+    struct { int key; int val; }* map = NULL;
+    hmapconfig(map, .layout = layout, .filter_fpr = 0.01);
+    // churn: the filter is doubled while growing and keeps the hashes of removed keys until then
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        hmapinsert(map, &i, i);
+        if(i % 3 == 0) hmapremove(map, &i);
+    }
+    int keys[100], vals[100];
+    for(int i = 0; i < 100; ++i) keys[i] = vals[i] = ENTRY_COUNT + i;
+    ASSERT(hmapinsert_many(map, keys, vals, 100) == 100, "hh_hmapinsert_many failed with a filter");
+    hh_bloom_t* filter = &(hh_hmapheader(map)->filter);
+    ASSERT(filter->blocks != NULL && filter->count <= filter->capacity, 
+        "hh_hmap filter overflowed: count = %zu, capacity = %zu", filter->count, filter->capacity);
+    for(int i = 0; i < ENTRY_COUNT + 100; ++i) {
+        size_t idx = hmapget(map, &i);
+        ASSERT((idx == SIZE_MAX) == (i < ENTRY_COUNT && i % 3 == 0), "hh_hmap filter rejected key %d", i);
+        ASSERT(idx == SIZE_MAX || map[idx].val == i, "hh_hmapget returned wrong entry for key %d", i);
+    }
+    // absent keys mostly stop at the filter
+    size_t passed = 0;
+    for(int i = ENTRY_COUNT + 100; i < 2 * ENTRY_COUNT + 100; ++i) {
+        passed += bloom_has(filter, hmaphash(map, &i));
+        ASSERT(hmapget(map, &i) == SIZE_MAX, "hh_hmapget found absent key %d", i);
+    }
+    DBG("[layout %d] %zu of %d absent keys passed the filter", layout, passed, ENTRY_COUNT);
+    ASSERT(passed < ENTRY_COUNT / 20, "hh_hmap filter passed too many absent keys: %zu", passed);
+    hmapfree(map);
+}
+
+// word-sized keys are hashed and compared inline, the results must match hh_hash_wide and memcmp
+static void
+test_word(int layout) {
+    struct { uint8_t key; int val; }* bytes = NULL;
+    struct { uint16_t key; int val; }* shorts = NULL;
+    struct { char key[8]; int val; }* names = NULL;
+    hmapconfig(bytes, .layout = layout);
+    hmapconfig(shorts, .layout = layout);
+    hmapconfig(names, .layout = layout);
+    char name[8];
+    for(int i = 0; i < 256; ++i) {
+        uint8_t b = (uint8_t) i;
+        uint16_t s = (uint16_t) (i * 257);
+        memset(name, 0, sizeof(name));
+        snprintf(name, sizeof(name), "n%d", i * 31);
+        hmapinsert(bytes, &b, i);
+        hmapinsert(shorts, &s, i);
+        hmapinsert(names, name, i);
+        ASSERT(hmaphash(names, name) == hash_wide(name, sizeof(name), hh_hmapheader(names)->opt.seed) && 
+            hmaphash(shorts, &s) == hash_wide(&s, sizeof(s), hh_hmapheader(shorts)->opt.seed), 
+            "hh_hmaphash disagrees with hh_hash_wide on word keys");
+    }
+    for(int i = 0; i < 256; ++i) {
+        uint8_t b = (uint8_t) i;
+        uint16_t s = (uint16_t) (i * 257);
+        memset(name, 0, sizeof(name));
+        snprintf(name, sizeof(name), "n%d", i * 31);
+        size_t idx = hmapget(names, name);
+        ASSERT(bytes[hmapget(bytes, &b)].val == i && shorts[hmapget(shorts, &s)].val == i && 
+            idx != SIZE_MAX && names[idx].val == i, "hh_hmapget failed on word key %d", i);
+        ++s;
+        name[7] = 'x';
+        ASSERT((s == 0 || hmapget(shorts, &s) == SIZE_MAX) && hmapget(names, name) == SIZE_MAX, 
+            "hh_hmapget found an absent word key");
+    }
+    hmapfree(bytes);
+    hmapfree(shorts);
+    hmapfree(names);
+}
+
+int
+main(void) {
+    test_word(HMAP_CHAINED);
+    test_word(HMAP_FLAT);
+    test_filter(HMAP_CHAINED);
+    test_filter(HMAP_FLAT);
+    test_probe(HMAP_CHAINED);
+    test_probe(HMAP_FLAT);
+    test_upsert(HMAP_CHAINED);
+    test_upsert(HMAP_FLAT);
+    test_many(HMAP_CHAINED);
+    test_many(HMAP_FLAT);
+    test_define(HMAP_CHAINED);
+    test_define(HMAP_FLAT);
+    test_save(HMAP_CHAINED);
+    test_save(HMAP_FLAT);
+    test_tampered();
+    test_layout(HMAP_CHAINED);
+    test_layout(HMAP_FLAT);
+    test_collisions(HMAP_CHAINED);
+    test_collisions(HMAP_FLAT);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// built with NDEBUG, writes to a loaded map must not rely on assertions
+#define NDEBUG
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 1000
+#define SAVE_PATH PROJECT_ROOT "tests/hmapmapped.tmp"
+
+// ASSERT compiles out under NDEBUG
+#define CHECK(cond, ...) do { if(!(cond)) { HH_ERR(__VA_ARGS__); exit(1); } } while(0)
+
+typedef struct { char* key; int val; } entry_t;
+
+static entry_t*
+load(void) {
+    entry_t* loaded = NULL;
+    hmapconfig(loaded, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr);
+    CHECK(hmapload_mapped(loaded, SAVE_PATH), "hh_hmapload_mapped failed to load " SAVE_PATH);
+    return loaded;
+}
+
+static int
+lookup(const entry_t* map, const char* name) {
+    char* key = (char*) name;
+    size_t idx = hmapget(map, &key);
+    return (idx == SIZE_MAX) ? -1 : map[idx].val;
+}
+
+static void
+test_mapped(void) {
+    char names[ENTRY_COUNT][16];
+    entry_t* map = NULL;
+    hmapconfig(map, .key_f.hash = hash_cstr, .key_f.comp = comp_cstr);
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        snprintf(names[i], sizeof(names[i]), "name%d", i);
+        char* key = names[i];
+        hmapinsert(map, &key, i);
+    }
+    CHECK(hmapsave(map, SAVE_PATH), "hh_hmapsave failed to write " SAVE_PATH);
+    hmapfree(map);
+    // removal works in place, the file keeps a spare entry for the removed one
+    entry_t* loaded = load();
+    char* key = "name7";
+    entry_t* removed = hmapremove(loaded, &key);
+    CHECK(removed != NULL && removed->val == 7 && strcmp(removed->key, "name7") == 0, "hh_hmapremove failed on a loaded map");
+    CHECK(hmaplen(loaded) == ENTRY_COUNT - 1 && lookup(loaded, "name7") == -1 && lookup(loaded, "name8") == 8,
+        "hh_hmapremove corrupted a loaded map");
+    hmapfree(loaded);
+    // the first insertion copies the map to the heap, its keys still point into the mapping
+    loaded = load();
+    key = "new";
+    CHECK(hmapinsert(loaded, &key, -1) == NULL, "hh_hmapinsert reported a replacement in a loaded map");
+    key = "name3";
+    entry_t* replaced = hmapinsert(loaded, &key, -3);
+    CHECK(replaced != NULL && replaced->val == 3, "hh_hmapinsert failed to replace an entry of a loaded map");
+    ++*hmapupsert(loaded, &key);
+    char* keys[2] = { "name5", "more" };
+    int vals[2] = { -5, -6 };
+    CHECK(hmapinsert_many(loaded, keys, vals, 2) == 1, "hh_hmapinsert_many failed on a loaded map");
+    for(int i = 0; i < ENTRY_COUNT; ++i) {
+        int expected = (i == 3) ? -2 : (i == 5) ? -5 : i;
+        CHECK(lookup(loaded, names[i]) == expected, "a loaded map lost %s after insertion", names[i]);
+    }
+    CHECK(lookup(loaded, "new") == -1 && lookup(loaded, "more") == -6 && hmaplen(loaded) == ENTRY_COUNT + 2,
+        "hh_hmapinsert failed on a loaded map");
+    key = "name9";
+    CHECK(hmapremove(loaded, &key) != NULL && lookup(loaded, "name9") == -1, "hh_hmapremove failed on a copied map");
+    hmapfree(loaded);
+    remove(SAVE_PATH);
+}
+
+int
+main(void) {
+    test_mapped();
+    return 0;
+}
@@ -0,0 +1,50 @@
+#define HH_IMPLEMENTATION
+#define HH_HMAP_STATS
+#include "h.h"
+
+#define ENTRY_COUNT 5000
+
+static void
+test_stats(int layout) {
+    struct { int key; int val; }* map = NULL;
+    hmapstats_t stats = hmapstats(map);
+    ASSERT(stats.len == 0 && stats.buckets == 0, "hh_hmapstats failed on a NULL map");
+    hmapconfig(map, .layout = layout);
+    for(int i = 0; i < ENTRY_COUNT; ++i) hmapinsert(map, &i, i);
+    for(int i = 0; i < 10; ++i) hmapinsert(map, &i, -i);
+    for(int i = 0; i < 100; ++i) hmapremove(map, &i);
+    stats = hmapstats(map);
+    DBG("[layout %d] len = %zu, buckets = %zu, load = %.3lf, max_chain = %zu, "
+        "bytes (entries/index/slack) = %zu/%zu/%zu, rehashes = %zu, comparisons = %zu", 
+        layout, stats.len, stats.buckets, stats.load, stats.max_chain, 
+        stats.bytes_entries, stats.bytes_index, stats.bytes_slack, stats.rehashes, stats.comparisons);
+    ASSERT(stats.len == ENTRY_COUNT - 100 && stats.cap > stats.len, "hh_hmapstats reported wrong len = %zu", stats.len);
+    ASSERT(stats.load == (double) stats.len / (double) stats.buckets, "hh_hmapstats reported wrong load");
+    ASSERT(stats.bytes_entries == stats.len * sizeof *map && 
+        stats.bytes_slack == (stats.cap - stats.len) * sizeof *map && stats.bytes_index > 0, 
+        "hh_hmapstats reported wrong memory use");
+    // every bucket (or entry) lands in exactly one bin
+    size_t total = 0, longest = 0;
+    for(size_t i = 0; i < HH_HMAP_STATS_BINS; ++i) {
+        total += stats.hist[i];
+        if(stats.hist[i] > 0) longest = i;
+    }
+    size_t expected = (layout == HMAP_FLAT) ? stats.len : stats.buckets;
+    // while rehashing, unmigrated old buckets are counted as well
+    if(layout == HMAP_CHAINED) expected += hh_hmapheader(map)->bucket_count_old - hh_hmapheader(map)->rehash;
+    ASSERT(total == expected, "hh_hmapstats histogram covers %zu of %zu", total, expected);
+    ASSERT(longest == HH_MIN(stats.max_chain, (size_t) HH_HMAP_STATS_BINS - 1), "hh_hmapstats reported wrong max chain");
+    ASSERT(stats.inserts == ENTRY_COUNT && stats.replaces == 10 && stats.removes == 100, 
+        "hh_hmapstats miscounted events: inserts = %zu, replaces = %zu, removes = %zu", 
+        stats.inserts, stats.replaces, stats.removes);
+    ASSERT(stats.rehashes > 0 && stats.comparisons >= 110, 
+        "hh_hmapstats miscounted rehashes/comparisons: %zu/%zu", stats.rehashes, stats.comparisons);
+    hmapfree(map);
+}
+
+int
+main(void) {
+    test_stats(HMAP_CHAINED);
+    test_stats(HMAP_FLAT);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 50000
+
+static void
+test_set(void) {
+    uint32_t* set = NULL;
+    ASSERT(hsetlen(set) == 0 && !hsethas(set, 1) && !hsetremove(set, 1), "hh_hset failed on a NULL set");
+    // zero is stored out of line, the rest of the keys probe the table
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        ASSERT(hsetinsert(set, i * 7), "hh_hsetinsert reported a new key as present: key = %u", i * 7);
+    }
+    ASSERT(!hsetinsert(set, 7) && !hsetinsert(set, 0), "hh_hsetinsert reported a present key as new");
+    ASSERT(hsetlen(set) == ENTRY_COUNT, "hh_hsetlen returned incorrect length: len = %zu", hsetlen(set));
+    for(uint32_t i = 0; i < 7 * ENTRY_COUNT; ++i) {
+        ASSERT(hsethas(set, i) == (i % 7 == 0), "hh_hsethas returned the wrong answer for key %u", i);
+    }
+    // removal shifts runs back, every other key must stay reachable
+    for(uint32_t i = 0; i < ENTRY_COUNT; i += 2) {
+        ASSERT(hsetremove(set, i * 7), "hh_hsetremove failed to remove key %u", i * 7);
+    }
+    ASSERT(!hsetremove(set, 0) && hsetlen(set) == ENTRY_COUNT / 2, "hh_hsetremove miscounted keys");
+    size_t count = 0;
+    for(size_t i = 0; i < hsetslots(set); ++i) {
+        if(!hsetvalid(set, i)) continue;
+        ASSERT(set[i] % 14 == 7 && hsetget(set, set[i]) == i, "hh_hset iteration visited key %u", set[i]);
+        ++count;
+    }
+    ASSERT(count == ENTRY_COUNT / 2, "hh_hset iteration visited %zu keys", count);
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) {
+        ASSERT(hsethas(set, i * 7) == (i % 2 == 1), "hh_hsetremove lost key %u", i * 7);
+    }
+    hsetfree(set);
+    ASSERT(set == NULL, "hh_hsetfree failed to reset the set");
+}
+
+static void
+test_map(void) {
+    struct { int64_t key; double val; }* map = NULL;
+    hsetreserve(map, ENTRY_COUNT);
+    size_t slots = hsetslots(map);
+    // negative keys (and zero) work like any other
+    for(int64_t i = -ENTRY_COUNT / 2; i < ENTRY_COUNT / 2; ++i) {
+        ASSERT(hsetput(map, i, (double) i / 2.0), "hh_hsetput reported a new key as present");
+    }
+    ASSERT(hsetslots(map) == slots, "hh_hsetreserve failed to prevent growth");
+    ASSERT(!hsetput(map, -1, 4.0) && map[hsetget(map, -1)].val == 4.0, "hh_hsetput failed to overwrite a value");
+    for(int64_t i = -ENTRY_COUNT / 2; i < ENTRY_COUNT / 2; ++i) {
+        size_t slot = hsetget(map, i);
+        ASSERT(slot != SIZE_MAX && map[slot].key == i, "hh_hsetget failed to find key %lld", (long long) i);
+        ASSERT(i == -1 || map[slot].val == (double) i / 2.0, "hh_hsetget returned the wrong value");
+    }
+    ASSERT(!hsethas(map, ENTRY_COUNT) && !hsethas(map, INT64_MIN), "hh_hsethas found an absent key");
+    hsetfree(map);
+    // narrow signed keys are truncated consistently
+    struct { int8_t key; uint8_t val; }* small = NULL;
+    for(int i = -128; i < 128; ++i) hsetput(small, i, (uint8_t) i);
+    ASSERT(hsetlen(small) == 256 && small[hsetget(small, -128)].val == 128, "hh_hset mishandled int8_t keys");
+    hsetfree(small);
+}
+
+int
+main(void) {
+    test_set();
+    test_map();
+    return 0;
+}
@@ -0,0 +1,53 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define WORD_COUNT 50000
+
+int
+main(void) {
+    intern_t names = {0};
+    ASSERT(intern_find(&names, "foo") == INTERN_NONE, "hh_intern_find found a string in an empty table");
+    // IDs are dense and handed out in order of first appearance
+    char word[32];
+    for(uint32_t i = 0; i < WORD_COUNT; ++i) {
+        snprintf(word, sizeof(word), "word%u", i);
+        uint32_t id = intern(&names, word);
+        ASSERT(id == i, "hh_intern returned non-dense ID: word = %s, id = %u", word, id);
+    }
+    ASSERT(intern_count(&names) == WORD_COUNT, "hh_intern_count returned %u", intern_count(&names));
+    DBG("Interned %d words", WORD_COUNT);
+    // repeated strings are stored once
+    const char* first = intern_str(&names, 42);
+    for(uint32_t i = 0; i < WORD_COUNT; ++i) {
+        snprintf(word, sizeof(word), "word%u", i);
+        ASSERT(intern(&names, word) == i && intern_find(&names, word) == i, 
+            "hh_intern returned a new ID for a repeated string: word = %s", word);
+        ASSERT(strcmp(intern_str(&names, i), word) == 0 && intern_len(&names, i) == strlen(word), 
+            "hh_intern_str returned incorrect string: id = %u, str = %s", i, intern_str(&names, i));
+    }
+    ASSERT(intern_count(&names) == WORD_COUNT && intern_str(&names, 42) == first, 
+        "hh_intern moved or duplicated strings");
+    // spans and embedded bytes
+    char src[] = "alpha beta alpha word7";
+    span_t tokens = span(src);
+    uint32_t ids[4];
+    for(size_t i = 0; i < ARR_LEN(ids); ++i) {
+        span_t tok = span_next(&tokens, .delim = " ");
+        ids[i] = intern_span(&names, tok);
+        ASSERT(intern_find_span(&names, tok) == ids[i], "hh_intern_find_span failed to find token %zu", i);
+    }
+    ASSERT(ids[0] == ids[2] && ids[0] != ids[1] && ids[3] == 7, "hh_intern_span returned inconsistent IDs");
+    ASSERT(strcmp(intern_str(&names, ids[1]), "beta") == 0, "hh_intern_span stored the whole source");
+    uint32_t nul = intern_n(&names, "a\0b", 3);
+    ASSERT(nul != intern(&names, "a") && intern_len(&names, nul) == 3 && intern_find_n(&names, "a\0b", 3) == nul, 
+        "hh_intern_n mishandled an embedded null");
+    ASSERT(intern(&names, "") == intern_n(&names, NULL, 0) && intern_len(&names, intern(&names, "")) == 0, 
+        "hh_intern mishandled the empty string");
+    intern_free(&names);
+    ASSERT(intern_count(&names) == 0 && intern_find(&names, "word1") == INTERN_NONE, 
+        "hh_intern_free failed to reset the table");
+    // the table is reusable after being freed
+    ASSERT(intern(&names, "again") == 0, "hh_intern failed after hh_intern_free");
+    intern_free(&names);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define KEY_COUNT 64
+#define OP_COUNT 100000
+#define CAPACITY 16
+
+typedef struct {
+    size_t count;
+    int last;
+} evicted_t;
+
+static void
+on_evict(const void* key, size_t len, void* val, void* ctx) {
+    evicted_t* evicted = ctx;
+    ++(evicted->count);
+    evicted->last = (int) (intptr_t) val;
+    ASSERT(len > 0 && ((const char*) key)[0] == 'k', "hh_lru passed a bad key to .evict");
+}
+
+static void
+test_basic(void) {
+    lru_t cache = {0};
+    evicted_t evicted = {0};
+    lru_config(&cache, .max_entries = 3, .evict = on_evict, .ctx = &evicted);
+    ASSERT(lru_get(&cache, "k0", 2) == NULL, "hh_lru_get found a key in an empty cache");
+    for(intptr_t i = 1; i <= 3; ++i) {
+        char key[8];
+        snprintf(key, sizeof(key), "k%d", (int) i);
+        lru_put(&cache, key, strlen(key), (void*) i, 1);
+    }
+    // k1 becomes the most recently used, so k2 is evicted next
+    ASSERT(lru_get(&cache, "k1", 2) == (void*) 1, "hh_lru_get failed to find k1");
+    lru_put(&cache, "k4", 2, (void*) 4, 1);
+    ASSERT(evicted.count == 1 && evicted.last == 2 && lru_get(&cache, "k2", 2) == NULL, 
+        "hh_lru evicted the wrong entry: %d", evicted.last);
+    // replacing a value hands the old one to .evict
+    lru_put(&cache, "k3", 2, (void*) 33, 1);
+    ASSERT(evicted.count == 2 && evicted.last == 3 && lru_get(&cache, "k3", 2) == (void*) 33, 
+        "hh_lru_put failed to replace a value");
+    ASSERT(lru_remove(&cache, "k1", 2) == (void*) 1 && evicted.count == 2 && lru_len(&cache) == 2, 
+        "hh_lru_remove failed to remove k1");
+    // byte limits evict until the total fits, but keep the newest entry
+    lru_config(&cache, .max_bytes = 10, .evict = on_evict, .ctx = &evicted);
+    lru_put(&cache, "k5", 2, (void*) 5, 8);
+    ASSERT(lru_len(&cache) == 3 && lru_stats(&cache).bytes == 10, "hh_lru evicted an entry that fit");
+    lru_put(&cache, "k6", 2, (void*) 6, 100);
+    ASSERT(lru_len(&cache) == 1 && lru_get(&cache, "k6", 2) == (void*) 6, "hh_lru evicted an oversized newest entry");
+    lru_stats_t stats = lru_stats(&cache);
+    ASSERT(stats.hits == 3 && stats.misses == 2 && stats.evictions == 4, 
+        "hh_lru_stats miscounted: hits = %zu, misses = %zu, evictions = %zu", stats.hits, stats.misses, stats.evictions);
+    lru_free(&cache);
+    ASSERT(evicted.count == 6 && evicted.last == 6 && lru_len(&cache) == 0, "hh_lru_free failed to release k6");
+}
+
+// random operations, checked against a plain array ordered by recency
+static void
+test_model(void) {
+    lru_t cache = {0};
+    evicted_t evicted = {0};
+    lru_config(&cache, .max_entries = CAPACITY, .evict = on_evict, .ctx = &evicted);
+    int model[CAPACITY + 1];
+    size_t len = 0, gets = 0;
+    uint32_t state = 7;
+    char key[40];
+    for(size_t op = 0; op < OP_COUNT; ++op) {
+        state = state * 1664525u + 1013904223u;
+        int k = (int) ((state >> 8) % KEY_COUNT);
+        // long keys exercise the malloc'd blocks
+        snprintf(key, sizeof(key), (k % 8 == 0) ? "k%d-with-a-key-longer-than-the-arena-classes" : "k%d", k);
+        size_t pos = 0;
+        while(pos < len && model[pos] != k) ++pos;
+        void* found;
+        switch((state >> 24) % 4) {
+            case 0:
+            case 1:
+                found = lru_get(&cache, key, strlen(key));
+                ++gets;
+                ASSERT((found != NULL) == (pos < len), "hh_lru_get disagrees with the model on %s", key);
+                if(pos == len) break;
+                memmove(model + 1, model, pos * sizeof(int));
+                model[0] = k;
+                break;
+            case 2:
+                lru_put(&cache, key, strlen(key), (void*) (intptr_t) (k + 1), 1);
+                if(pos == len) ++len;
+                memmove(model + 1, model, HH_MIN(pos, (size_t) CAPACITY) * sizeof(int));
+                model[0] = k;
+                if(len > CAPACITY) {
+                    ASSERT(evicted.last == model[CAPACITY] + 1, "hh_lru evicted %d instead of %d", 
+                        evicted.last - 1, model[CAPACITY]);
+                    len = CAPACITY;
+                }
+                break;
+            default:
+                found = lru_remove(&cache, key, strlen(key));
+                ASSERT((found != NULL) == (pos < len), "hh_lru_remove disagrees with the model on %s", key);
+                if(pos == len) break;
+                memmove(model + pos, model + pos + 1, (len - pos - 1) * sizeof(int));
+                --len;
+                break;
+        }
+        ASSERT(lru_len(&cache) == len, "hh_lru_len returned %zu, expected %zu", lru_len(&cache), len);
+    }
+    lru_stats_t stats = lru_stats(&cache);
+    DBG("%d ops: hits = %zu, misses = %zu, evictions = %zu", OP_COUNT, stats.hits, stats.misses, stats.evictions);
+    ASSERT(stats.hits + stats.misses == gets, "hh_lru_stats counted %zu lookups, expected %zu", 
+        stats.hits + stats.misses, gets);
+    lru_free(&cache);
+}
+
+int
+main(void) {
+    test_basic();
+    test_model();
+    return 0;
+}
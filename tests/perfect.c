@@ -0,0 +1,81 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define WORD_COUNT 20000
+#define EMIT_PATH PROJECT_ROOT "tests/perfect.tmp"
+
+static const char* keywords[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if",
+    "inline", "int", "long", "register", "restrict", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "_Bool", "_Complex", "_Imaginary"
+};
+
+static void
+test_keywords(void) {
+    perfect_t kw = {0};
+    ASSERT(perfect_find(&kw, "if") == PERFECT_NONE, "hh_perfect_find found a key in an empty table");
+    ASSERT(perfect_build(&kw, keywords, ARR_LEN(keywords)), "hh_perfect_build failed on C keywords");
+    ASSERT(kw.count == ARR_LEN(keywords), "hh_perfect_build produced %zu slots", kw.count);
+    for(uint32_t i = 0; i < ARR_LEN(keywords); ++i) {
+        ASSERT(perfect_find(&kw, keywords[i]) == i, "hh_perfect_find failed to find %s", keywords[i]);
+    }
+    // prefixes, extensions and near misses are rejected by the comparison
+    const char* absent[] = { "", "i", "iff", "whilst", "Auto", "_Boo", "unsignedd" };
+    for(size_t i = 0; i < ARR_LEN(absent); ++i) {
+        ASSERT(perfect_find(&kw, absent[i]) == PERFECT_NONE, "hh_perfect_find found absent key %s", absent[i]);
+    }
+    char src[] = "static int x = sizeof(y) ; return x ;";
+    span_t tokens = span(src), tok;
+    size_t found = 0;
+    while((tok = span_next(&tokens, .delim = " ")).ptr != NULL) found += perfect_find_span(&kw, tok) != PERFECT_NONE;
+    ASSERT(found == 3, "hh_perfect_find_span found %zu keywords, expected 3", found);
+    // duplicates are rejected and leave the table alone
+    const char* dup[] = { "a", "b", "a" };
+    ASSERT(!perfect_build(&kw, dup, ARR_LEN(dup)) && perfect_find(&kw, "while") == 33, 
+        "hh_perfect_build accepted a duplicate key");
+    // emitted tables are plain C
+    ASSERT(perfect_emit(&kw, "c_keywords", EMIT_PATH), "hh_perfect_emit failed to write " EMIT_PATH);
+    char* text = read_entire_file(EMIT_PATH);
+    ASSERT(text != NULL && strstr(text, "static const hh_perfect_t c_keywords = {") != NULL && 
+        strstr(text, "c_keywords_pilots[]") != NULL, "hh_perfect_emit wrote an unexpected file");
+    darrfree(text);
+    remove(EMIT_PATH);
+    // a table that doesn't own its arrays behaves the same
+    perfect_t borrowed = kw;
+    borrowed.mem = NULL;
+    ASSERT(perfect_find(&borrowed, "volatile") == 32, "hh_perfect_find failed on a borrowed table");
+    perfect_free(&kw);
+    ASSERT(kw.count == 0 && perfect_find(&kw, "if") == PERFECT_NONE, "hh_perfect_free failed to reset the table");
+}
+
+static void
+test_large(void) {
+    char (*words)[16] = malloc(WORD_COUNT * sizeof(*words));
+    const char** keys = malloc(WORD_COUNT * sizeof(*keys));
+    ASSERT(words != NULL && keys != NULL, "test_large failed to allocate");
+    for(size_t i = 0; i < WORD_COUNT; ++i) {
+        snprintf(words[i], sizeof(words[i]), "w%zu", i);
+        keys[i] = words[i];
+    }
+    perfect_t table = {0};
+    ASSERT(perfect_build(&table, keys, WORD_COUNT), "hh_perfect_build failed on %d words", WORD_COUNT);
+    DBG("Built a table for %d words with %zu buckets", WORD_COUNT, table.bucket_count);
+    char word[16];
+    for(size_t i = 0; i < WORD_COUNT; ++i) {
+        ASSERT(perfect_find(&table, keys[i]) == i, "hh_perfect_find failed to find %s", keys[i]);
+        snprintf(word, sizeof(word), "w%zu", i + WORD_COUNT);
+        ASSERT(perfect_find(&table, word) == PERFECT_NONE, "hh_perfect_find found absent key %s", word);
+    }
+    perfect_free(&table);
+    free(words);
+    free(keys);
+}
+
+int
+main(void) {
+    test_keywords();
+    test_large();
+    return 0;
+}
@@ -0,0 +1,96 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define ENTRY_COUNT 100000
+
+typedef struct {
+    uint64_t id;
+    char tag[12];
+} entry_t;
+
+// pointers handed out by hh_seg_push survive every later append
+static void
+test_stable(void) {
+    seg_t entries = {0};
+    seg_config(&entries, .elem_size = sizeof(entry_t));
+    entry_t** ptrs = NULL;
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        entry_t entry = { .id = i };
+        snprintf(entry.tag, sizeof(entry.tag), "%llu", (unsigned long long) i);
+        darrput(ptrs, seg_push(&entries, &entry));
+    }
+    ASSERT(seg_len(&entries) == ENTRY_COUNT, "hh_seg_push failed to append %d elements", ENTRY_COUNT);
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        char tag[12];
+        snprintf(tag, sizeof(tag), "%llu", (unsigned long long) i);
+        ASSERT(ptrs[i] == seg_get(&entries, i), "hh_seg_push moved element %zu", (size_t) i);
+        ASSERT(ptrs[i]->id == i && strcmp(ptrs[i]->tag, tag) == 0, "hh_seg_get returned the wrong element for %zu", (size_t) i);
+    }
+    // NULL appends a zeroed element
+    entry_t* zero = seg_push(&entries, NULL);
+    ASSERT(zero->id == 0 && zero->tag[0] == '\0' && zero == seg_get(&entries, ENTRY_COUNT), "hh_seg_push failed to zero an element");
+    seg_free(&entries);
+    ASSERT(seg_len(&entries) == 0, "hh_seg_free failed to empty the array");
+    darrfree(ptrs);
+}
+
+// bulk appends straddle chunk boundaries, and the chunks visit every element once, in order
+static void
+test_chunks(void) {
+    seg_t nums = {0};
+    seg_config(&nums, .elem_size = sizeof(uint32_t));
+    uint32_t* src = NULL;
+    for(uint32_t i = 0; i < ENTRY_COUNT; ++i) darrput(src, i);
+    size_t total = 0;
+    // uneven batches, the first one ends inside the first chunk
+    for(size_t n = SEG_FIRST_CHUNK / 2 + 1; total < ENTRY_COUNT; n = n * 3 + 7) {
+        if(n > ENTRY_COUNT - total) n = ENTRY_COUNT - total;
+        ASSERT(seg_putn(&nums, src + total, n) == total, "hh_seg_putn returned the wrong first index");
+        total += n;
+    }
+    ASSERT(seg_len(&nums) == ENTRY_COUNT, "hh_seg_putn appended %zu of %d elements", seg_len(&nums), ENTRY_COUNT);
+    uint32_t next = 0;
+    for(size_t k = 0; k < seg_chunks(&nums); ++k) {
+        size_t len;
+        uint32_t* chunk = seg_chunk(&nums, k, &len);
+        ASSERT(len == ((size_t) SEG_FIRST_CHUNK << k) || k + 1 == seg_chunks(&nums), "hh_seg_chunk returned a partial chunk %zu", k);
+        for(size_t i = 0; i < len; ++i, ++next) ASSERT(chunk[i] == next, "hh_seg_chunk returned %u in place of %u", chunk[i], next);
+    }
+    ASSERT(next == ENTRY_COUNT, "hh_seg_chunk visited %u of %d elements", next, ENTRY_COUNT);
+    // the chunks are kept and reused, zeroed on request
+    uint32_t* first = seg_get(&nums, 0);
+    ASSERT(*(uint32_t*) seg_pop(&nums) == ENTRY_COUNT - 1 && seg_len(&nums) == ENTRY_COUNT - 1, "hh_seg_pop failed");
+    seg_clear(&nums);
+    ASSERT(seg_len(&nums) == 0 && seg_chunks(&nums) == 0, "hh_seg_clear failed to empty the array");
+    ASSERT(seg_putn(&nums, NULL, SEG_FIRST_CHUNK + 1) == 0 && seg_get(&nums, 0) == first, "hh_seg_clear released a chunk");
+    for(size_t i = 0; i < SEG_FIRST_CHUNK + 1; ++i) ASSERT(*(uint32_t*) seg_get(&nums, i) == 0, "hh_seg_putn failed to zero a reused chunk");
+    ASSERT(seg_chunks(&nums) == 2, "hh_seg_chunks returned %zu", seg_chunks(&nums));
+    seg_free(&nums);
+    // a freed array keeps its options
+    seg_push(&nums, src);
+    ASSERT(*(uint32_t*) seg_get(&nums, 0) == 0 && seg_len(&nums) == 1, "hh_seg_free dropped the options");
+    seg_free(&nums);
+    darrfree(src);
+}
+
+// chunks come from the configured allocator
+static void
+test_arena(void) {
+    hh_arena scratch = {0};
+    allocator_t alloc = arena_allocator(&scratch);
+    seg_t nums = {0};
+    seg_config(&nums, .elem_size = sizeof(uint64_t), .alloc = &alloc);
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) seg_push(&nums, &i);
+    ASSERT(scratch.ptr != NULL, "hh_seg_push bypassed its allocator");
+    for(uint64_t i = 0; i < ENTRY_COUNT; ++i) ASSERT(*(uint64_t*) seg_get(&nums, i) == i, "hh_seg_get failed on an arena");
+    seg_free(&nums);
+    arena_free(&scratch);
+}
+
+int
+main(void) {
+    test_stable();
+    test_chunks();
+    test_arena();
+    return 0;
+}
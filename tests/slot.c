@@ -0,0 +1,76 @@
+#define HH_IMPLEMENTATION
+#include "h.h"
+
+#define OP_COUNT 100000
+#define HANDLE_COUNT 512
+
+typedef struct {
+    int id;
+    double weight;
+} entity_t;
+
+int
+main(void) {
+    entity_t* entities = NULL;
+    ASSERT(slotget(entities, SLOT_NONE) == NULL && !slothas(entities, 1) && !slotremove(entities, 1),
+        "hh_slot found a handle in an empty slot map");
+    // handles[k] refers to the entity with id k while live[k] is set
+    static slot_t handles[HANDLE_COUNT];
+    static _Bool live[HANDLE_COUNT];
+    size_t len = 0, stale = 0;
+    uint32_t state = 3;
+    for(size_t op = 0; op < OP_COUNT; ++op) {
+        state = state * 1664525u + 1013904223u;
+        int k = (int) ((state >> 8) % HANDLE_COUNT);
+        if((state >> 28) < 9 && !live[k]) {
+            slot_t old = handles[k];
+            handles[k] = slotinsert(entities, ((entity_t) { .id = k, .weight = (double) op }));
+            ASSERT(handles[k] != SLOT_NONE && handles[k] != old, "hh_slotinsert reused a handle");
+            live[k] = 1;
+            ++len;
+        } else {
+            _Bool removed = slotremove(entities, handles[k]);
+            ASSERT(removed == live[k], "hh_slotremove disagrees with the model on %d", k);
+            if(removed) {
+                live[k] = 0;
+                --len;
+            } else if(handles[k] != SLOT_NONE) ++stale;
+        }
+        ASSERT(darrlen(entities) == len, "hh_slot length is %zu, expected %zu", darrlen(entities), len);
+    }
+    DBG("%d ops: %zu live, %zu stale removals", OP_COUNT, len, stale);
+    ASSERT(stale > 0, "hh_slot test never removed through a stale handle");
+    // every live handle resolves to its entity, stale handles resolve to nothing
+    for(int k = 0; k < HANDLE_COUNT; ++k) {
+        entity_t* entity = slotget(entities, handles[k]);
+        ASSERT((entity != NULL) == live[k] && (entity == NULL || entity->id == k),
+            "hh_slotget returned an incorrect entity for %d", k);
+        if(entity == NULL) continue;
+        size_t idx = slotindex(entities, handles[k]);
+        ASSERT(entity == &entities[idx] && slothandle(entities, idx) == handles[k],
+            "hh_slothandle disagrees with hh_slotindex for %d", k);
+    }
+    // the values stay dense
+    size_t count = 0;
+    for(size_t i = 0; i < darrlen(entities); ++i) {
+        ASSERT(live[entities[i].id] && slothandle(entities, i) == handles[entities[i].id],
+            "hh_slot array holds a removed entity");
+        ++count;
+    }
+    ASSERT(count == len, "hh_slot array holds %zu entities, expected %zu", count, len);
+    slotclear(entities);
+    for(int k = 0; k < HANDLE_COUNT; ++k) {
+        ASSERT(!slothas(entities, handles[k]), "hh_slotclear left a live handle");
+    }
+    ASSERT(darrlen(entities) == 0, "hh_slotclear failed to empty the array");
+    slot_t handle = slotinsert(entities, ((entity_t) { .id = 1 }));
+    ASSERT(slothas(entities, handle) && entities[0].id == 1, "hh_slotinsert failed after hh_slotclear");
+    slotfree(entities);
+    ASSERT(entities == NULL && slotget(entities, handle) == NULL, "hh_slotfree failed to reset the slot map");
+    // values are as aligned as the header's block
+    long double* wide = NULL;
+    slotinsert(wide, 1.0L);
+    ASSERT((uintptr_t) wide % 16 == 0, "hh_slotinsert misaligned its values");
+    slotfree(wide);
+    return 0;
+}